@@ -151,6 +151,11 @@ COMMON_C_INCLUDES += \
 	system/core/libsync
 endif
 
+# LLVM guards its global state, as Reactor builds routines concurrently
+ifneq ($(REACTOR_USE_SUBZERO),true)
+COMMON_CFLAGS += -DLLVM_ENABLE_THREADS=1
+endif
+
 # Common Subzero defines
 COMMON_CFLAGS += -DALLOW_DUMP=0 -DALLOW_TIMERS=0 -DALLOW_LLVM_CL=0 -DALLOW_LLVM_IR=0 -DALLOW_LLVM_IR_AS_INPUT=0 -DALLOW_MINIMAL_BUILD=0 -DALLOW_WASM=0 -DICE_THREAD_LOCAL_HACK=1
 
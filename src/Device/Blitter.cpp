@@ -16,7 +16,9 @@
 
 #include "Pipeline/ShaderCore.hpp"
 #include "Reactor/Reactor.hpp"
+#include "System/Math.hpp"
 #include "System/Memory.hpp"
+#include "System/ThreadPool.hpp"
 #include "Vulkan/VkDebug.hpp"
 #include "Vulkan/VkImage.hpp"
 #include "Vulkan/VkBuffer.hpp"
@@ -25,10 +27,16 @@
 
 namespace sw
 {
+	// Blits writing fewer pixels than this run on the calling thread. Larger
+	// ones are split into bands of rows of at least BLIT_BAND_PIXELS pixels,
+	// executed by the thread pool.
+	static const int64_t BLIT_PARALLEL_PIXELS = 0x10000;
+	static const int BLIT_BAND_PIXELS = 0x2000;
+
 	Blitter::Blitter()
 	{
-		blitCache = new RoutineCache<State>(1024);
-		cornerUpdateCache = new RoutineCache<State>(64); // We only need one of these per format
+		blitCache = new RoutineCache<State, State::Hash>(1024);
+		cornerUpdateCache = new RoutineCache<State, State::Hash>(64); // We only need one of these per format
 	}
 
 	Blitter::~Blitter()
@@ -78,6 +86,8 @@ namespace sw
 			area = *renderArea;
 		}
 
+		std::vector<BlitData> slices;
+
 		for(; subresLayers.mipLevel <= lastMipLevel; subresLayers.mipLevel++)
 		{
 			VkExtent3D extent = dest->getMipLevelExtent(aspect, subresLayers.mipLevel);
@@ -112,7 +122,7 @@ namespace sw
 				for (uint32_t depth = subresourceRange.baseArrayLayer; depth <= lastLayer; depth++)
 				{
 					data.dest = dest->getTexelPointer({0, 0, static_cast<int32_t>(depth)}, subresLayers);
-					blitFunction(&data);
+					slices.push_back(data);
 				}
 			}
 			else
@@ -123,11 +133,15 @@ namespace sw
 					{
 						data.dest = dest->getTexelPointer({ 0, 0, static_cast<int32_t>(depth) }, subresLayers);
 
-						blitFunction(&data);
+						slices.push_back(data);
 					}
 				}
 			}
 		}
+
+		execute(blitFunction, slices);
+
+		blitRoutine->unbind();
 	}
 
 	bool Blitter::fastClear(void *pixel, vk::Format format, vk::Image *dest, const vk::Format& viewFormat, const VkImageSubresourceRange& subresourceRange, const VkRect2D* renderArea)
@@ -1533,7 +1547,6 @@ namespace sw
 
 	Routine *Blitter::getRoutine(const State &state)
 	{
-		criticalSection.lock();
 		Routine *blitRoutine = blitCache->query(state);
 
 		if(!blitRoutine)
@@ -1542,19 +1555,64 @@ namespace sw
 
 			if(!blitRoutine)
 			{
-				criticalSection.unlock();
 				UNIMPLEMENTED("blitRoutine");
 				return nullptr;
 			}
 
-			blitCache->add(state, blitRoutine);
+			blitRoutine = blitCache->add(state, blitRoutine);
 		}
 
-		criticalSection.unlock();
-
 		return blitRoutine;
 	}
 
+	void Blitter::execute(void(*blitFunction)(const BlitData *data), const std::vector<BlitData> &slices)
+	{
+		int64_t pixels = 0;
+		for(const auto &slice : slices)
+		{
+			pixels += int64_t(std::max(slice.y1d - slice.y0d, 0)) * std::max(slice.x1d - slice.x0d, 0);
+		}
+
+		ThreadPool &pool = ThreadPool::get();
+
+		if(pixels < BLIT_PARALLEL_PIXELS || pool.getThreadCount() == 1)
+		{
+			for(const auto &slice : slices)
+			{
+				blitFunction(&slice);
+			}
+
+			return;
+		}
+
+		// The blit routine computes the source coordinates from the absolute
+		// destination row, so each band only needs its own range of rows. Bands
+		// start on even rows to keep the quads of quad layout formats whole.
+		std::vector<BlitData> bands;
+		for(const auto &slice : slices)
+		{
+			int width = std::max(slice.x1d - slice.x0d, 1);
+			int bandRows = (((BLIT_BAND_PIXELS + width - 1) / width) + 1) & ~1;
+
+			for(int y = slice.y0d; y < slice.y1d;)
+			{
+				int y1 = std::min((y + bandRows) & ~1, slice.y1d);
+
+				BlitData band = slice;
+				band.y0d = y;
+				band.y1d = y1;
+				bands.push_back(band);
+
+				y = y1;
+			}
+		}
+
+		pool.parallelFor(bands.size(), [&](size_t band)
+		{
+			blitFunction(&bands[band]);
+		});
+	}
+
 	void Blitter::blitToBuffer(const vk::Image *src, VkImageSubresourceLayers subresource, VkOffset3D offset, VkExtent3D extent, uint8_t *dst, int bufferRowPitch, int bufferSlicePitch)
 	{
 		auto aspect = static_cast<VkImageAspectFlagBits>(subresource.aspectMask);
@@ -1606,6 +1664,8 @@ namespace sw
 
 		uint32_t lastLayer = src->getLastLayerIndex(srcSubresRange);
 
+		std::vector<BlitData> slices;
+
 		for(; srcSubresLayers.baseArrayLayer <= lastLayer; srcSubresLayers.baseArrayLayer++)
 		{
 			srcOffset.z = offset.z;
@@ -1614,11 +1674,15 @@ namespace sw
 			{
 				data.source = src->getTexelPointer(srcOffset, srcSubresLayers);
 				ASSERT(data.source < src->end());
-				blitFunction(&data);
+				slices.push_back(data);
 				srcOffset.z++;
 				data.dest = (dst += bufferSlicePitch);
 			}
 		}
+
+		execute(blitFunction, slices);
+
+		blitRoutine->unbind();
 	}
 
 	void Blitter::blitFromBuffer(const vk::Image *dst, VkImageSubresourceLayers subresource, VkOffset3D offset, VkExtent3D extent, uint8_t *src, int bufferRowPitch, int bufferSlicePitch)
@@ -1672,6 +1736,8 @@ namespace sw
 
 		uint32_t lastLayer = dst->getLastLayerIndex(dstSubresRange);
 
+		std::vector<BlitData> slices;
+
 		for(; dstSubresLayers.baseArrayLayer <= lastLayer; dstSubresLayers.baseArrayLayer++)
 		{
 			dstOffset.z = offset.z;
@@ -1680,11 +1746,15 @@ namespace sw
 			{
 				data.dest = dst->getTexelPointer(dstOffset, dstSubresLayers);
 				ASSERT(data.dest < dst->end());
-				blitFunction(&data);
+				slices.push_back(data);
 				dstOffset.z++;
 				data.source = (src += bufferSlicePitch);
 			}
 		}
+
+		execute(blitFunction, slices);
+
+		blitRoutine->unbind();
 	}
 
 	void Blitter::blit(const vk::Image *src, vk::Image *dst, VkImageBlit region, VkFilter filter)
@@ -1796,6 +1866,8 @@ namespace sw
 
 		uint32_t lastLayer = src->getLastLayerIndex(srcSubresRange);
 
+		std::vector<BlitData> slices;
+
 		for(; srcSubresLayers.baseArrayLayer <= lastLayer; srcSubresLayers.baseArrayLayer++, dstSubresLayers.baseArrayLayer++)
 		{
 			srcOffset.z = region.srcOffsets[0].z;
@@ -1809,11 +1881,15 @@ namespace sw
 				ASSERT(data.source < src->end());
 				ASSERT(data.dest < dst->end());
 
-				blitFunction(&data);
+				slices.push_back(data);
 				srcOffset.z++;
 				dstOffset.z++;
 			}
 		}
+
+		execute(blitFunction, slices);
+
+		blitRoutine->unbind();
 	}
 
 	void Blitter::computeCubeCorner(Pointer<Byte>& layer, Int& x0, Int& x1, Int& y0, Int& y1, Int& pitchB, const State& state)
@@ -1933,7 +2009,6 @@ namespace sw
 			UNIMPLEMENTED("Multi-sampled cube: %d samples", static_cast<int>(samples));
 		}
 
-		criticalSection.lock();
 		Routine *cornerUpdateRoutine = cornerUpdateCache->query(state);
 
 		if(!cornerUpdateRoutine)
@@ -1942,16 +2017,13 @@ namespace sw
 
 			if(!cornerUpdateRoutine)
 			{
-				criticalSection.unlock();
 				UNIMPLEMENTED("cornerUpdateRoutine");
 				return;
 			}
 
-			cornerUpdateCache->add(state, cornerUpdateRoutine);
+			cornerUpdateRoutine = cornerUpdateCache->add(state, cornerUpdateRoutine);
 		}
 
-		criticalSection.unlock();
-
 		void(*cornerUpdateFunction)(const CubeBorderData *data) = (void(*)(const CubeBorderData*))cornerUpdateRoutine->getEntry();
 
 		VkExtent3D extent = image->getMipLevelExtent(aspect, subresourceLayers.mipLevel);
@@ -1963,6 +2035,8 @@ namespace sw
 			extent.width
 		};
 		cornerUpdateFunction(&data);
+
+		cornerUpdateRoutine->unbind();
 	}
 
 	void Blitter::copyCubeEdge(vk::Image* image,
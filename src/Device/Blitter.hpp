@@ -19,8 +19,8 @@
 #include "Reactor/Reactor.hpp"
 #include "Vulkan/VkFormat.h"
 
-#include <mutex>
 #include <string.h>
+#include <vector>
 
 namespace vk
 {
@@ -71,6 +71,23 @@ namespace sw
 				return memcmp(this, &state, sizeof(State)) == 0;
 			}
 
+			// Hashes the bytes compared by operator==.
+			struct Hash
+			{
+				size_t operator()(const State &state) const
+				{
+					const unsigned char *bytes = reinterpret_cast<const unsigned char*>(&state);
+					size_t hash = 2166136261u;
+
+					for(size_t i = 0; i < sizeof(State); i++)
+					{
+						hash = (hash ^ bytes[i]) * 16777619u;
+					}
+
+					return hash;
+				}
+			};
+
 			vk::Format sourceFormat;
 			vk::Format destFormat;
 			int srcSamples = 0;
@@ -133,8 +150,9 @@ namespace sw
 		static Int ComputeOffset(Int &x, Int &y, Int &pitchB, int bytes, bool quadLayout);
 		static Float4 LinearToSRGB(Float4 &color);
 		static Float4 sRGBtoLinear(Float4 &color);
-		Routine *getRoutine(const State &state);
+		Routine *getRoutine(const State &state);   // Bound for the caller, which must unbind() it
 		Routine *generate(const State &state);
+		void execute(void(*blitFunction)(const BlitData *data), const std::vector<BlitData> &slices);
 		Routine *generateCornerUpdate(const State& state);
 		void computeCubeCorner(Pointer<Byte>& layer, Int& x0, Int& x1, Int& y0, Int& y1, Int& pitchB, const State& state);
 
@@ -142,9 +160,8 @@ namespace sw
 	                      const VkImageSubresourceLayers& dstSubresourceLayers, Edge dstEdge,
 	                      const VkImageSubresourceLayers& srcSubresourceLayers, Edge srcEdge);
 
-		RoutineCache<State> *blitCache;
-		RoutineCache<State> *cornerUpdateCache;
-		std::mutex criticalSection;
+		RoutineCache<State, State::Hash> *blitCache;
+		RoutineCache<State, State::Hash> *cornerUpdateCache;
 	};
 }
 
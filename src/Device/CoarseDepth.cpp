@@ -0,0 +1,147 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "CoarseDepth.hpp"
+
+#include "System/Math.hpp"
+#include "Vulkan/VkDebug.hpp"
+
+namespace sw
+{
+	CoarseDepth::CoarseDepth(int width, int height, VkFormat format)
+		: width(width),
+		  height(height),
+		  format(format),
+		  tilesX((width + COARSE_DEPTH_TILE_SIZE - 1) >> COARSE_DEPTH_TILE_SHIFT),
+		  tilesY((height + COARSE_DEPTH_TILE_SIZE - 1) >> COARSE_DEPTH_TILE_SHIFT),
+		  epsilon((format == VK_FORMAT_D16_UNORM) ? 1.0f / 0x8000 : 1.0f / 0x100000),
+		  valid(false)
+	{
+		ASSERT(isSupported(format));
+
+		bound = new std::atomic<float>[tilesX * tilesY];
+
+		for(int i = 0; i < tilesX * tilesY; i++)
+		{
+			bound[i] = 1.0f;
+		}
+	}
+
+	CoarseDepth::~CoarseDepth()
+	{
+		delete[] bound;
+	}
+
+	bool CoarseDepth::isSupported(VkFormat format)
+	{
+		// The pixel routines store X8_D24 depth as floats, unlike the other
+		// operations on it, so the precision the bounds allow for is unknown.
+		return (format == VK_FORMAT_D16_UNORM) || (format == VK_FORMAT_D32_SFLOAT);
+	}
+
+	void CoarseDepth::invalidate()
+	{
+		valid = false;
+	}
+
+	void CoarseDepth::clear(float depth, const VkRect2D &rect)
+	{
+		int x0 = sw::max(rect.offset.x, 0);
+		int y0 = sw::max(rect.offset.y, 0);
+		int x1 = sw::min(rect.offset.x + static_cast<int>(rect.extent.width), width);
+		int y1 = sw::min(rect.offset.y + static_cast<int>(rect.extent.height), height);
+
+		if(x0 >= x1 || y0 >= y1)
+		{
+			return;
+		}
+
+		bool coversAll = (x0 == 0) && (y0 == 0) && (x1 == width) && (y1 == height);
+
+		if(!valid && !coversAll)
+		{
+			return;
+		}
+
+		// Unsigned normalized formats clamp negative clear values to 0.
+		depth = sw::max(depth, 0.0f);
+
+		for(int tileY = y0 >> COARSE_DEPTH_TILE_SHIFT; tileY <= (y1 - 1) >> COARSE_DEPTH_TILE_SHIFT; tileY++)
+		{
+			int tileY0 = tileY << COARSE_DEPTH_TILE_SHIFT;
+			int tileY1 = sw::min(tileY0 + COARSE_DEPTH_TILE_SIZE, height);
+
+			for(int tileX = x0 >> COARSE_DEPTH_TILE_SHIFT; tileX <= (x1 - 1) >> COARSE_DEPTH_TILE_SHIFT; tileX++)
+			{
+				int tileX0 = tileX << COARSE_DEPTH_TILE_SHIFT;
+				int tileX1 = sw::min(tileX0 + COARSE_DEPTH_TILE_SIZE, width);
+				int tile = tileY * tilesX + tileX;
+
+				if(x0 <= tileX0 && tileX1 <= x1 && y0 <= tileY0 && tileY1 <= y1)
+				{
+					bound[tile] = depth;
+				}
+				else if(bound[tile] < depth)
+				{
+					bound[tile] = depth;
+				}
+			}
+		}
+
+		if(coversAll)
+		{
+			valid = true;
+		}
+	}
+
+	bool CoarseDepth::occludes(int x0, int y0, int x1, int y1, float z) const
+	{
+		x0 = sw::max(x0, 0);
+		y0 = sw::max(y0, 0);
+		x1 = sw::min(x1, width);
+		y1 = sw::min(y1, height);
+
+		if(!valid || x0 >= x1 || y0 >= y1)
+		{
+			return false;
+		}
+
+		z -= epsilon;
+
+		for(int tileY = y0 >> COARSE_DEPTH_TILE_SHIFT; tileY <= (y1 - 1) >> COARSE_DEPTH_TILE_SHIFT; tileY++)
+		{
+			for(int tileX = x0 >> COARSE_DEPTH_TILE_SHIFT; tileX <= (x1 - 1) >> COARSE_DEPTH_TILE_SHIFT; tileX++)
+			{
+				// NaN bounds never occlude.
+				if(!(z > bound[tileY * tilesX + tileX].load(std::memory_order_relaxed)))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	void CoarseDepth::lower(int tileX, int tileY, float depth)
+	{
+		std::atomic<float> &tileBound = bound[tileY * tilesX + tileX];
+		float current = tileBound.load(std::memory_order_relaxed);
+
+		// Bounds lowered concurrently by other batches are kept if lower.
+		while(depth < current && !tileBound.compare_exchange_weak(current, depth, std::memory_order_relaxed))
+		{
+		}
+	}
+}
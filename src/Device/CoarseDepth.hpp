@@ -0,0 +1,77 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_CoarseDepth_hpp
+#define sw_CoarseDepth_hpp
+
+#include "Device/Config.hpp"
+#include "Vulkan/VkFormat.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace sw
+{
+	// CoarseDepth holds an upper bound of the depth of each tile of
+	// COARSE_DEPTH_TILE_SIZE x COARSE_DEPTH_TILE_SIZE pixels of a depth buffer,
+	// over all of its samples. Primitives whose depth exceeds the bound of every
+	// tile they overlap fail a LESS or LESS_OR_EQUAL depth test, and are culled
+	// before rasterization.
+	//
+	// The bounds stay conservative as long as depth writes only lower the depth,
+	// so they are invalidated by any other kind of write, and become valid again
+	// when the whole buffer is cleared. The renderer lowers the bound of a tile
+	// when a primitive which writes every sample of it has completed, without
+	// reading the depth buffer back.
+	class CoarseDepth
+	{
+	public:
+		CoarseDepth(int width, int height, VkFormat format);
+		~CoarseDepth();
+
+		static bool isSupported(VkFormat format);
+
+		bool isValid() const { return valid; }
+		void invalidate();
+
+		// Depth clears set the bounds of the tiles covered by the rectangle, and
+		// revalidate the buffer if it is covered entirely.
+		void clear(float depth, const VkRect2D &rect);
+
+		// Returns true if a primitive covering only pixels of the rectangle
+		// [x0, x1) x [y0, y1), at depth z or more, is behind every pixel of it.
+		bool occludes(int x0, int y0, int x1, int y1, float z) const;
+
+		// Lowers the bound of the tile to depth, once every pixel of it is known
+		// to be at depth or less. The bound is kept if it is already lower.
+		void lower(int tileX, int tileY, float depth);
+
+		int getWidth() const { return width; }
+		int getHeight() const { return height; }
+		VkFormat getFormat() const { return format; }
+
+	private:
+		const int width;
+		const int height;
+		const VkFormat format;
+		const int tilesX;
+		const int tilesY;
+		const float epsilon;   // Depth buffer precision, and rounding of primitive depths
+
+		std::atomic<bool> valid;
+		std::atomic<float> *bound;   // Per tile
+	};
+}
+
+#endif   // sw_CoarseDepth_hpp
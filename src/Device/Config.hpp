@@ -76,6 +76,10 @@ namespace sw
 	enum
 	{
 		OUTLINE_RESOLUTION = 8192,   // Maximum vertical resolution of the render target
+		TILE_SIZE_SHIFT = 6,         // Tiles of the binning rasterizer are 64x64 pixels
+		TILE_SIZE = 1 << TILE_SIZE_SHIFT,
+		COARSE_DEPTH_TILE_SHIFT = 4,   // Coarse depth bounds are kept per 16x16 pixels
+		COARSE_DEPTH_TILE_SIZE = 1 << COARSE_DEPTH_TILE_SHIFT,
 		MIPMAP_LEVELS = 14,
 		FRAGMENT_UNIFORM_VECTORS = 264,
 		VERTEX_UNIFORM_VECTORS = 259,
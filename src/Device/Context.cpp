@@ -33,6 +33,7 @@ namespace sw
 	bool exactColorRounding = false;
 	TransparencyAntialiasing transparencyAntialiasing = TRANSPARENCY_NONE;
 	bool forceClearRegisters = false;
+	bool tileBinning = false;
 
 	Context::Context()
 	{
@@ -162,6 +163,7 @@ namespace sw
 		instanceID = 0;
 
 		occlusionEnabled = false;
+		statisticsEnabled = false;
 
 		lineWidth = 1.0f;
 
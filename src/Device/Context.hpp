@@ -160,6 +160,7 @@ namespace sw
 		int instanceID;
 
 		bool occlusionEnabled;
+		bool statisticsEnabled;
 
 		// Pixel processor states
 		bool rasterizerDiscard;
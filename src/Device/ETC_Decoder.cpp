@@ -14,6 +14,14 @@
 
 #include "ETC_Decoder.hpp"
 
+#include <stdint.h>
+#include <string.h>
+
+// x86 builds enable SSE2, so texels are decoded four at a time.
+#if defined(__i386__) || defined(__x86_64__)
+	#include <emmintrin.h>
+#endif
+
 namespace
 {
 	inline int clampByte(int value)
@@ -91,6 +99,12 @@ namespace
 		// Decodes unsigned single or dual channel block to bytes
 		static void DecodeBlock(const ETC2** sources, unsigned char *dest, int nbChannels, int x, int y, int w, int h, int pitch, bool isSigned, bool isEAC)
 		{
+			int values[2][16];
+			for(int c = 0; c < nbChannels; c++)
+			{
+				sources[c]->getSingleChannel(values[c], isSigned, isEAC);
+			}
+
 			if(isEAC)
 			{
 				for(int j = 0; j < 4 && (y + j) < h; j++)
@@ -100,7 +114,7 @@ namespace
 					{
 						for(int c = nbChannels - 1; c >= 0; c--)
 						{
-							sDst[i * nbChannels + c] = clampEAC(sources[c]->getSingleChannel(i, j, isSigned, true), isSigned);
+							sDst[i * nbChannels + c] = clampEAC(values[c][i * 4 + j], isSigned);
 						}
 					}
 					dest += pitch;
@@ -117,7 +131,7 @@ namespace
 						{
 							for(int c = nbChannels - 1; c >= 0; c--)
 							{
-								sDst[i * nbChannels + c] = clampSByte(sources[c]->getSingleChannel(i, j, isSigned, false));
+								sDst[i * nbChannels + c] = clampSByte(values[c][i * 4 + j]);
 							}
 						}
 						sDst += pitch;
@@ -131,7 +145,7 @@ namespace
 						{
 							for(int c = nbChannels - 1; c >= 0; c--)
 							{
-								dest[i * nbChannels + c] = clampByte(sources[c]->getSingleChannel(i, j, isSigned, false));
+								dest[i * nbChannels + c] = clampByte(values[c][i * 4 + j]);
 							}
 						}
 						dest += pitch;
@@ -436,47 +450,7 @@ namespace
 			subblockColors1[2].set(r2 + i22, g2 + i22, b2 + i22);
 			subblockColors1[3].set(r2 + i23, g2 + i23, b2 + i23);
 
-			unsigned char* destStart = dest;
-
-			if(flipbit)
-			{
-				for(int j = 0; j < 2 && (y + j) < h; j++)
-				{
-					bgra8* color = (bgra8*)dest;
-					if((x + 0) < w) color[0] = subblockColors0[getIndex(0, j)].addA(alphaValues[j][0]);
-					if((x + 1) < w) color[1] = subblockColors0[getIndex(1, j)].addA(alphaValues[j][1]);
-					if((x + 2) < w) color[2] = subblockColors0[getIndex(2, j)].addA(alphaValues[j][2]);
-					if((x + 3) < w) color[3] = subblockColors0[getIndex(3, j)].addA(alphaValues[j][3]);
-					dest += pitch;
-				}
-
-				for(int j = 2; j < 4 && (y + j) < h; j++)
-				{
-					bgra8* color = (bgra8*)dest;
-					if((x + 0) < w) color[0] = subblockColors1[getIndex(0, j)].addA(alphaValues[j][0]);
-					if((x + 1) < w) color[1] = subblockColors1[getIndex(1, j)].addA(alphaValues[j][1]);
-					if((x + 2) < w) color[2] = subblockColors1[getIndex(2, j)].addA(alphaValues[j][2]);
-					if((x + 3) < w) color[3] = subblockColors1[getIndex(3, j)].addA(alphaValues[j][3]);
-					dest += pitch;
-				}
-			}
-			else
-			{
-				for(int j = 0; j < 4 && (y + j) < h; j++)
-				{
-					bgra8* color = (bgra8*)dest;
-					if((x + 0) < w) color[0] = subblockColors0[getIndex(0, j)].addA(alphaValues[j][0]);
-					if((x + 1) < w) color[1] = subblockColors0[getIndex(1, j)].addA(alphaValues[j][1]);
-					if((x + 2) < w) color[2] = subblockColors1[getIndex(2, j)].addA(alphaValues[j][2]);
-					if((x + 3) < w) color[3] = subblockColors1[getIndex(3, j)].addA(alphaValues[j][3]);
-					dest += pitch;
-				}
-			}
-
-			if(nonOpaquePunchThroughAlpha)
-			{
-				decodePunchThroughAlphaBlock(destStart, x, y, w, h, pitch);
-			}
+			writeIndexedBlock(dest, x, y, w, h, pitch, subblockColors0, subblockColors1, flipbit, alphaValues, nonOpaquePunchThroughAlpha);
 		}
 
 		void decodeTBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4], bool nonOpaquePunchThroughAlpha) const
@@ -501,22 +475,7 @@ namespace
 			paintColors[2].set(r2, g2, b2);
 			paintColors[3].set(r2 - d, g2 - d, b2 - d);
 
-			unsigned char* destStart = dest;
-
-			for(int j = 0; j < 4 && (y + j) < h; j++)
-			{
-				bgra8* color = (bgra8*)dest;
-				if((x + 0) < w) color[0] = paintColors[getIndex(0, j)].addA(alphaValues[j][0]);
-				if((x + 1) < w) color[1] = paintColors[getIndex(1, j)].addA(alphaValues[j][1]);
-				if((x + 2) < w) color[2] = paintColors[getIndex(2, j)].addA(alphaValues[j][2]);
-				if((x + 3) < w) color[3] = paintColors[getIndex(3, j)].addA(alphaValues[j][3]);
-				dest += pitch;
-			}
-
-			if(nonOpaquePunchThroughAlpha)
-			{
-				decodePunchThroughAlphaBlock(destStart, x, y, w, h, pitch);
-			}
+			writeIndexedBlock(dest, x, y, w, h, pitch, paintColors, paintColors, false, alphaValues, nonOpaquePunchThroughAlpha);
 		}
 
 		void decodeHBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4], bool nonOpaquePunchThroughAlpha) const
@@ -541,22 +500,7 @@ namespace
 			paintColors[2].set(r2 + d, g2 + d, b2 + d);
 			paintColors[3].set(r2 - d, g2 - d, b2 - d);
 
-			unsigned char* destStart = dest;
-
-			for(int j = 0; j < 4 && (y + j) < h; j++)
-			{
-				bgra8* color = (bgra8*)dest;
-				if((x + 0) < w) color[0] = paintColors[getIndex(0, j)].addA(alphaValues[j][0]);
-				if((x + 1) < w) color[1] = paintColors[getIndex(1, j)].addA(alphaValues[j][1]);
-				if((x + 2) < w) color[2] = paintColors[getIndex(2, j)].addA(alphaValues[j][2]);
-				if((x + 3) < w) color[3] = paintColors[getIndex(3, j)].addA(alphaValues[j][3]);
-				dest += pitch;
-			}
-
-			if(nonOpaquePunchThroughAlpha)
-			{
-				decodePunchThroughAlphaBlock(destStart, x, y, w, h, pitch);
-			}
+			writeIndexedBlock(dest, x, y, w, h, pitch, paintColors, paintColors, false, alphaValues, nonOpaquePunchThroughAlpha);
 		}
 
 		void decodePlanarBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, unsigned char alphaValues[4][4]) const
@@ -573,6 +517,40 @@ namespace
 			int gv = extend_7to8bits(GVa << 2 | GVb);
 			int bv = extend_6to8bits(BV);
 
+#if defined(__i386__) || defined(__x86_64__)
+			// Blue and red are interpolated in one vector of words, and green in
+			// another, whose upper half receives the alpha.
+			const __m128i column = _mm_setr_epi16(0, 1, 2, 3, 0, 1, 2, 3);
+			const __m128i originBR = _mm_setr_epi16(bo, bo, bo, bo, ro, ro, ro, ro);
+			const __m128i slopeBR = _mm_setr_epi16(bh - bo, bh - bo, bh - bo, bh - bo, rh - ro, rh - ro, rh - ro, rh - ro);
+			const __m128i originG = _mm_set1_epi16(go);
+			const __m128i slopeG = _mm_set1_epi16(gh - go);
+
+			for(int j = 0; j < 4 && (y + j) < h; j++)
+			{
+				int by = j * (bv - bo) + 2;
+				int ry = j * (rv - ro) + 2;
+				int gy = j * (gv - go) + 2;
+
+				__m128i br = _mm_add_epi16(_mm_mullo_epi16(column, slopeBR), _mm_setr_epi16(by, by, by, by, ry, ry, ry, ry));
+				br = _mm_add_epi16(_mm_srai_epi16(br, 2), originBR);
+				__m128i g = _mm_add_epi16(_mm_mullo_epi16(column, slopeG), _mm_set1_epi16(gy));
+				g = _mm_add_epi16(_mm_srai_epi16(g, 2), originG);
+
+				int alphas;
+				memcpy(&alphas, alphaValues[j], sizeof(alphas));
+				__m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128(alphas), _mm_setzero_si128());
+
+				// Saturates to bytes ordered b0..b3 r0..r3 g0..g3 a0..a3, then
+				// interleaves them into b g r a texels.
+				__m128i bytes = _mm_packus_epi16(br, _mm_unpacklo_epi64(g, a));
+				bytes = _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 8));
+				bytes = _mm_unpacklo_epi16(bytes, _mm_srli_si128(bytes, 8));
+
+				storeRow(dest, bytes, w - x);
+				dest += pitch;
+			}
+#else
 			for(int j = 0; j < 4 && (y + j) < h; j++)
 			{
 				int ry = j * (rv - ro) + 2;
@@ -587,7 +565,97 @@ namespace
 				}
 				dest += pitch;
 			}
+#endif
+		}
+
+		// Writes a block whose texels pick one of four colors by their index.
+		// The right or bottom half of the block, if flipped, picks from
+		// colors1 instead of colors0.
+		void writeIndexedBlock(unsigned char *dest, int x, int y, int w, int h, int pitch, bgra8 colors0[4], bgra8 colors1[4], bool flipped, unsigned char alphaValues[4][4], bool nonOpaquePunchThroughAlpha) const
+		{
+#if defined(__i386__) || defined(__x86_64__)
+			// Bit x * 4 + y of these words holds the index bits of texel (x, y).
+			const int lsbWord = (pixelIndexLSB[0] << 8) | pixelIndexLSB[1];
+			const int msbWord = (pixelIndexMSB[0] << 8) | pixelIndexMSB[1];
+			const __m128i lsbBits = _mm_set1_epi32(lsbWord);
+			const __m128i msbBits = _mm_set1_epi32(msbWord);
+			const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+
+			// The colors of the left and right halves of a row, or of the top and bottom rows.
+			__m128i colors[2][4];
+			for(int k = 0; k < 4; k++)
+			{
+				int color0, color1;
+				memcpy(&color0, &colors0[k], sizeof(color0));
+				memcpy(&color1, &colors1[k], sizeof(color1));
+
+				colors[0][k] = _mm_and_si128(flipped ? _mm_set1_epi32(color0) : _mm_setr_epi32(color0, color0, color1, color1), rgbMask);
+				colors[1][k] = _mm_and_si128(flipped ? _mm_set1_epi32(color1) : _mm_setr_epi32(color0, color0, color1, color1), rgbMask);
+			}
+
+			for(int j = 0; j < 4 && (y + j) < h; j++)
+			{
+				const __m128i (&c)[4] = colors[flipped && (j >= 2)];
+
+				const __m128i texelBits = _mm_setr_epi32(1 << j, 1 << (4 + j), 1 << (8 + j), 1 << (12 + j));
+				__m128i lsb = _mm_cmpeq_epi32(_mm_and_si128(lsbBits, texelBits), texelBits);
+				__m128i msb = _mm_cmpeq_epi32(_mm_and_si128(msbBits, texelBits), texelBits);
+
+				__m128i low = _mm_or_si128(_mm_and_si128(lsb, c[1]), _mm_andnot_si128(lsb, c[0]));
+				__m128i high = _mm_or_si128(_mm_and_si128(lsb, c[3]), _mm_andnot_si128(lsb, c[2]));
+				__m128i color = _mm_or_si128(_mm_and_si128(msb, high), _mm_andnot_si128(msb, low));
+
+				int alphas;
+				memcpy(&alphas, alphaValues[j], sizeof(alphas));
+				__m128i a = _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_cvtsi32_si128(alphas));
+				color = _mm_or_si128(color, _mm_unpacklo_epi16(_mm_setzero_si128(), a));
+
+				if(nonOpaquePunchThroughAlpha)
+				{
+					// Texels with index 2 are transparent black.
+					color = _mm_andnot_si128(_mm_andnot_si128(lsb, msb), color);
+				}
+
+				storeRow(dest, color, w - x);
+				dest += pitch;
+			}
+#else
+			unsigned char* destStart = dest;
+
+			for(int j = 0; j < 4 && (y + j) < h; j++)
+			{
+				bgra8* color = (bgra8*)dest;
+				for(int i = 0; i < 4 && (x + i) < w; i++)
+				{
+					bgra8* colors = (flipped ? (j >= 2) : (i >= 2)) ? colors1 : colors0;
+					color[i] = colors[getIndex(i, j)].addA(alphaValues[j][i]);
+				}
+				dest += pitch;
+			}
+
+			if(nonOpaquePunchThroughAlpha)
+			{
+				decodePunchThroughAlphaBlock(destStart, x, y, w, h, pitch);
+			}
+#endif
+		}
+
+#if defined(__i386__) || defined(__x86_64__)
+		// Stores a row of four bgra8 texels, of which the first 'count' are in the image.
+		static void storeRow(unsigned char *dest, __m128i texels, int count)
+		{
+			if(count >= 4)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), texels);
+			}
+			else
+			{
+				int row[4];
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(row), texels);
+				memcpy(dest, row, count * sizeof(bgra8));
+			}
 		}
+#endif
 
 		// Index for individual, differential, H and T modes
 		inline int getIndex(int x, int y) const
@@ -616,40 +684,32 @@ namespace
 		}
 
 		// Single channel utility functions
-		inline int getSingleChannel(int x, int y, bool isSigned, bool isEAC) const
+
+		// Decodes the value of texel (x, y) into values[x * 4 + y]
+		inline void getSingleChannel(int values[16], bool isSigned, bool isEAC) const
 		{
 			int codeword = isSigned ? signed_base_codeword : base_codeword;
-			return isEAC ?
-			       ((multiplier == 0) ?
-			        (codeword * 8 + 4 + getSingleChannelModifier(x, y)) :
-			        (codeword * 8 + 4 + getSingleChannelModifier(x, y) * multiplier * 8)) :
-			       codeword + getSingleChannelModifier(x, y) * multiplier;
-		}
+			int base = isEAC ? (codeword * 8 + 4) : codeword;
+			int scale = isEAC ? ((multiplier == 0) ? 1 : (multiplier * 8)) : multiplier;
 
-		inline int getSingleChannelIndex(int x, int y) const
-		{
-			switch(x * 4 + y)
+			const int* modifiers = getSingleChannelModifiers();
+
+			// The 3-bit indices are stored from the most significant bit of the
+			// last six bytes, in texel order.
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(this);
+			uint64_t indices = 0;
+			for(int i = 2; i < 8; i++)
+			{
+				indices = (indices << 8) | bytes[i];
+			}
+
+			for(int i = 0; i < 16; i++)
 			{
-			case 0: return ma;
-			case 1: return mb;
-			case 2: return mc1 << 1 | mc2;
-			case 3: return md;
-			case 4: return me;
-			case 5: return mf1 << 2 | mf2;
-			case 6: return mg;
-			case 7: return mh;
-			case 8: return mi;
-			case 9: return mj;
-			case 10: return mk1 << 1 | mk2;
-			case 11: return ml;
-			case 12: return mm;
-			case 13: return mn1 << 2 | mn2;
-			case 14: return mo;
-			default: return mp; // 15
+				values[i] = base + modifiers[(indices >> (45 - 3 * i)) & 7] * scale;
 			}
 		}
 
-		inline int getSingleChannelModifier(int x, int y) const
+		inline const int* getSingleChannelModifiers() const
 		{
 			static const int modifierTable[16][8] = { { -3, -6, -9, -15, 2, 5, 8, 14 },
 			{ -3, -7, -10, -13, 2, 6, 9, 12 },
@@ -668,16 +728,15 @@ namespace
 			{ -4, -6, -8, -9, 3, 5, 7, 8 },
 			{ -3, -5, -7, -9, 2, 4, 6, 8 } };
 
-			return modifierTable[table_index][getSingleChannelIndex(x, y)];
+			return modifierTable[table_index];
 		}
 	};
 }
 
 // Decodes 1 to 4 channel images to 8 bit output
-bool ETC_Decoder::Decode(const unsigned char* src, unsigned char *dst, int w, int h, int dstW, int dstH, int dstPitch, int dstBpp, InputType inputType)
+bool ETC_Decoder::Decode(const unsigned char* src, unsigned char *dst, int w, int h, int dstW, int dstH, int srcPitch, int dstPitch, int dstBpp, InputType inputType)
 {
 	const ETC2* sources[2];
-	sources[0] = (const ETC2*)src;
 
 	unsigned char alphaValues[4][4] = { { 255, 255, 255, 255 }, { 255, 255, 255, 255 }, { 255, 255, 255, 255 }, { 255, 255, 255, 255 } };
 
@@ -687,6 +746,7 @@ bool ETC_Decoder::Decode(const unsigned char* src, unsigned char *dst, int w, in
 	case ETC_R_UNSIGNED:
 		for(int y = 0; y < h; y += 4)
 		{
+			sources[0] = (const ETC2*)(src + (y / 4) * srcPitch);
 			unsigned char *dstRow = dst + (y * dstPitch);
 			for(int x = 0; x < w; x += 4, sources[0]++)
 			{
@@ -696,9 +756,10 @@ bool ETC_Decoder::Decode(const unsigned char* src, unsigned char *dst, int w, in
 		break;
 	case ETC_RG_SIGNED:
 	case ETC_RG_UNSIGNED:
-		sources[1] = sources[0] + 1;
 		for(int y = 0; y < h; y += 4)
 		{
+			sources[0] = (const ETC2*)(src + (y / 4) * srcPitch);
+			sources[1] = sources[0] + 1;
 			unsigned char *dstRow = dst + (y * dstPitch);
 			for(int x = 0; x < w; x += 4, sources[0] += 2, sources[1] += 2)
 			{
@@ -710,6 +771,7 @@ bool ETC_Decoder::Decode(const unsigned char* src, unsigned char *dst, int w, in
 	case ETC_RGB_PUNCHTHROUGH_ALPHA:
 		for(int y = 0; y < h; y += 4)
 		{
+			sources[0] = (const ETC2*)(src + (y / 4) * srcPitch);
 			unsigned char *dstRow = dst + (y * dstPitch);
 			for(int x = 0; x < w; x += 4, sources[0]++)
 			{
@@ -720,6 +782,7 @@ bool ETC_Decoder::Decode(const unsigned char* src, unsigned char *dst, int w, in
 	case ETC_RGBA:
 		for(int y = 0; y < h; y += 4)
 		{
+			sources[0] = (const ETC2*)(src + (y / 4) * srcPitch);
 			unsigned char *dstRow = dst + (y * dstPitch);
 			for(int x = 0; x < w; x += 4)
 			{
@@ -33,9 +33,10 @@ public:
 	/// @param h              src image height
 	/// @param dstW           dst image width
 	/// @param dstH           dst image height
+	/// @param srcPitch       src image pitch (bytes per row of blocks)
 	/// @param dstPitch       dst image pitch (bytes per row)
 	/// @param dstBpp         dst image bytes per pixel
 	/// @param inputType      src's format
 	/// @return               true if the decoding was performed
-	static bool Decode(const unsigned char* src, unsigned char *dst, int w, int h, int dstW, int dstH, int dstPitch, int dstBpp, InputType inputType);
+	static bool Decode(const unsigned char* src, unsigned char *dst, int w, int h, int dstW, int dstH, int srcPitch, int dstPitch, int dstBpp, InputType inputType);
 };
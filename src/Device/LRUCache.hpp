@@ -15,131 +15,203 @@
 #ifndef sw_LRUCache_hpp
 #define sw_LRUCache_hpp
 
-#include "System/Math.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
 
 namespace sw
 {
-	template<class Key, class Data>
+	// Hashes a key by its precomputed hash field.
+	template<class Key>
+	struct KeyHash
+	{
+		size_t operator()(const Key &key) const
+		{
+			return key.hash;
+		}
+	};
+
+	// LRUCache maps keys to reference counted data, evicting the least
+	// recently used entry once it holds its maximum number of entries.
+	//
+	// Lookups are hashed, and all methods may be called concurrently. The
+	// cache holds a reference to its data, which it releases on eviction.
+	// Data returned by query() and add() is bound for the caller before the
+	// lock is released, so it remains valid until the caller unbinds it.
+	template<class Key, class Data, class Hash = KeyHash<Key>>
 	class LRUCache
 	{
 	public:
+		struct Statistics
+		{
+			uint64_t hits;
+			uint64_t misses;
+			uint64_t evictions;
+		};
+
 		LRUCache(int n);
 
 		~LRUCache();
 
-		Data *query(const Key &key) const;
+		Data *query(const Key &key);
+
+		// add() returns the data cached for the key. If another thread added
+		// the key first, that data is kept and the new data is released.
 		Data *add(const Key &key, Data *data);
-	
-		int getSize() {return size;}
-		Key &getKey(int i) {return key[i];}
+
+		int getSize() const { return size; }
+		Statistics getStatistics() const;
 
 	private:
-		int size;
-		int mask;
-		int top;
-		int fill;
-
-		Key *key;
-		Key **ref;
-		Data **data;
+		struct Entry
+		{
+			Data *data;
+			const Key *key;   // Points into the map node holding this entry
+			Entry *prev;      // More recently used
+			Entry *next;      // Less recently used
+		};
+
+		Entry *find(const Key &key);
+		void unlink(Entry *entry);
+		void pushFront(Entry *entry);
+
+		const int size;
+
+		mutable std::mutex mutex;
+		std::unordered_map<Key, Entry, Hash> map;   // guarded by mutex
+		Entry *head;                                // guarded by mutex
+		Entry *tail;                                // guarded by mutex
+		Statistics statistics;                      // guarded by mutex
 	};
 }
 
 namespace sw
 {
-	template<class Key, class Data>
-	LRUCache<Key, Data>::LRUCache(int n)
+	template<class Key, class Data, class Hash>
+	LRUCache<Key, Data, Hash>::LRUCache(int n) : size(n), head(nullptr), tail(nullptr), statistics{0, 0, 0}
 	{
-		size = ceilPow2(n);
-		mask = size - 1;
-		top = 0;
-		fill = 0;
+		map.reserve(size);
+	}
 
-		key = new Key[size];
-		ref = new Key*[size];
-		data = new Data*[size];
+	template<class Key, class Data, class Hash>
+	LRUCache<Key, Data, Hash>::~LRUCache()
+	{
+		for(auto &it : map)
+		{
+			it.second.data->unbind();
+		}
+	}
+
+	template<class Key, class Data, class Hash>
+	void LRUCache<Key, Data, Hash>::unlink(Entry *entry)
+	{
+		(entry->prev ? entry->prev->next : head) = entry->next;
+		(entry->next ? entry->next->prev : tail) = entry->prev;
+	}
+
+	template<class Key, class Data, class Hash>
+	void LRUCache<Key, Data, Hash>::pushFront(Entry *entry)
+	{
+		entry->prev = nullptr;
+		entry->next = head;
+		(head ? head->prev : tail) = entry;
+		head = entry;
+	}
+
+	template<class Key, class Data, class Hash>
+	typename LRUCache<Key, Data, Hash>::Entry *LRUCache<Key, Data, Hash>::find(const Key &key)
+	{
+		auto it = map.find(key);
 
-		for(int i = 0; i < size; i++)
+		if(it == map.end())
 		{
-			data[i] = nullptr;
+			statistics.misses++;
+			return nullptr;
+		}
+
+		Entry *entry = &it->second;
 
-			ref[i] = &key[i];
+		if(entry != head)
+		{
+			unlink(entry);
+			pushFront(entry);
 		}
+
+		statistics.hits++;
+		return entry;
 	}
 
-	template<class Key, class Data>
-	LRUCache<Key, Data>::~LRUCache()
+	template<class Key, class Data, class Hash>
+	Data *LRUCache<Key, Data, Hash>::query(const Key &key)
 	{
-		delete[] key;
-		key = nullptr;
+		std::unique_lock<std::mutex> lock(mutex);
 
-		delete[] ref;
-		ref = nullptr;
+		Entry *entry = find(key);
 
-		for(int i = 0; i < size; i++)
+		if(!entry)
 		{
-			if(data[i])
-			{
-				data[i]->unbind();
-				data[i] = nullptr;
-			}
+			return nullptr;
 		}
 
-		delete[] data;
-		data = nullptr;
+		entry->data->bind();
+		return entry->data;
 	}
 
-	template<class Key, class Data>
-	Data *LRUCache<Key, Data>::query(const Key &key) const
+	template<class Key, class Data, class Hash>
+	Data *LRUCache<Key, Data, Hash>::add(const Key &key, Data *data)
 	{
-		for(int i = top; i > top - fill; i--)
-		{
-			int j = i & mask;
+		data->bind();   // The caller's reference
 
-			if(key == *ref[j])
-			{
-				Data *hit = data[j];
+		Data *evicted = nullptr;
 
-				if(i != top)
-				{
-					// Move one up
-					int k = (j + 1) & mask;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
 
-					Data *swapD = data[k];
-					data[k] = data[j];
-					data[j] = swapD;
+			auto it = map.find(key);
 
-					Key *swapK = ref[k];
-					ref[k] = ref[j];
-					ref[j] = swapK;
-				}
+			if(it != map.end())
+			{
+				Data *cached = it->second.data;
+				cached->bind();
+				lock.unlock();
 
-				return hit;
+				data->unbind();
+				return cached;
 			}
-		}
 
-		return nullptr;   // Not found
-	}
-
-	template<class Key, class Data>
-	Data *LRUCache<Key, Data>::add(const Key &key, Data *data)
-	{
-		top = (top + 1) & mask;
-		fill = fill + 1 < size ? fill + 1 : size;
+			data->bind();   // The cache's reference
 
-		*ref[top] = key;
+			if(static_cast<int>(map.size()) >= size)
+			{
+				Entry *lru = tail;
+				unlink(lru);
+				evicted = lru->data;
+				map.erase(*lru->key);
+				statistics.evictions++;
+			}
 
-		data->bind();
+			auto inserted = map.emplace(key, Entry{data, nullptr, nullptr, nullptr});
+			Entry *entry = &inserted.first->second;
+			entry->key = &inserted.first->first;
+			pushFront(entry);
+		}
 
-		if(this->data[top])
+		if(evicted)
 		{
-			this->data[top]->unbind();
+			evicted->unbind();
 		}
 
-		this->data[top] = data;
-
 		return data;
 	}
+
+	template<class Key, class Data, class Hash>
+	typename LRUCache<Key, Data, Hash>::Statistics LRUCache<Key, Data, Hash>::getStatistics() const
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		return statistics;
+	}
 }
 
 #endif   // sw_LRUCache_hpp
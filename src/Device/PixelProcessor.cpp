@@ -25,6 +25,7 @@
 namespace sw
 {
 	extern TransparencyAntialiasing transparencyAntialiasing;
+	extern bool tileBinning;
 
 	bool precachePixel = false;
 
@@ -202,6 +203,8 @@ namespace sw
 		}
 
 		state.occlusionEnabled = context->occlusionEnabled;
+		state.statisticsEnabled = context->statisticsEnabled;
+		state.tileBinning = tileBinning;
 		state.depthClamp = (context->depthBias != 0.0f) || (context->slopeDepthBias != 0.0f);
 
 		if(context->alphaBlendActive())
@@ -250,7 +253,7 @@ namespace sw
 			routine = (*generator)("PixelRoutine_%0.8X", state.shaderID);
 			delete generator;
 
-			routineCache->add(state, routine);
+			routine = routineCache->add(state, routine);
 		}
 
 		return routine;
@@ -45,6 +45,8 @@ namespace sw
 
 			bool depthTestActive;
 			bool occlusionEnabled;
+			bool statisticsEnabled;
+			bool tileBinning;   // Each call rasterizes a whole tile, rather than the scanlines of a cluster
 			bool perspective;
 			bool depthClamp;
 
@@ -118,7 +120,7 @@ namespace sw
 		};
 
 	public:
-		typedef void (*RoutinePointer)(const Primitive *primitive, int count, int thread, DrawData *draw);
+		typedef void (*RoutinePointer)(const Primitive *primitive, int count, int cluster, int tile, DrawData *draw);
 
 		PixelProcessor();
 
@@ -128,6 +130,8 @@ namespace sw
 
 	protected:
 		const State update(const Context* context) const;
+
+		// Returns the routine bound for the caller, which must unbind() it.
 		Routine *routine(const State &state, vk::PipelineLayout const *pipelineLayout,
 		                 SpirvShader const *pixelShader, const vk::DescriptorSet::Bindings &descriptorSets);
 		void setRoutineCacheSize(int routineCacheSize);
@@ -39,6 +39,10 @@ namespace sw
 		int yMin;
 		int yMax;
 
+		// Horizontal bounds, for tile binning and coarse depth culling
+		int xMin;
+		int xMax;
+
 		float4 xQuad;
 		float4 yQuad;
 
@@ -48,15 +52,33 @@ namespace sw
 		PlaneEquation z;
 		PlaneEquation w;
 
-		union
-		{
-			PlaneEquation V[MAX_INTERFACE_COMPONENTS];
-		};
-
 		// Masks for two-sided stencil
 		int64_t clockwiseMask;
 		int64_t invClockwiseMask;
 
+		// The (clipped) polygon, in 1/16th pixel units, from which the pixel
+		// routine computes the outline. X[n] and Y[n] repeat the first vertex.
+		int n;
+		int d;   // Winding direction
+		int X[17];
+		int Y[17];
+
+		// Plane equations of the interpolants which the fragment shader reads,
+		// packed in component order. Only the first interpolantCount planes
+		// are allocated, so primitives are size(interpolantCount) bytes apart.
+		PlaneEquation V[MAX_INTERFACE_COMPONENTS];
+
+		static int size(int interpolantCount)
+		{
+			return OFFSET(Primitive,V) + interpolantCount * static_cast<int>(sizeof(PlaneEquation));
+		}
+	};
+
+	// Outline holds the horizontal extent of each scanline covered by a
+	// primitive, for one sample. The pixel routine computes it from the
+	// primitive's edges, only for the scanlines it rasterizes.
+	struct Outline
+	{
 		struct Span
 		{
 			unsigned short left;
@@ -65,9 +87,9 @@ namespace sw
 
 		// The rasterizer adds a zero length span to the top and bottom of the polygon to allow
 		// for 2x2 pixel processing. We need an even number of spans to keep accesses aligned.
-		Span outlineUnderflow[2];
-		Span outline[OUTLINE_RESOLUTION];
-		Span outlineOverflow[2];
+		Span underflow[2];
+		Span span[OUTLINE_RESOLUTION];
+		Span overflow[2];
 	};
 }
 
@@ -28,6 +28,20 @@ namespace sw
 
 	QuadRasterizer::QuadRasterizer(const PixelProcessor::State &state, SpirvShader const *spirvShader) : state(state), spirvShader{spirvShader}
 	{
+		// Setup packs the plane equations of the interpolants the shader reads.
+		int planes = 0;
+
+		for(int interpolant = 0; interpolant < MAX_INTERFACE_COMPONENTS; interpolant++)
+		{
+			plane[interpolant] = planes;
+
+			if(spirvShader && spirvShader->inputs[interpolant].Type != SpirvShader::ATTRIBTYPE_UNUSED)
+			{
+				planes++;
+			}
+		}
+
+		primitiveSize = Primitive::size(planes);
 	}
 
 	QuadRasterizer::~QuadRasterizer()
@@ -46,34 +60,70 @@ namespace sw
 		#endif
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
+		outline = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,outline)) + cluster * Int(4 * sizeof(Outline));
 		occlusion = 0;
+		fragmentInvocations = 0;
 		int clusterCount = Renderer::getClusterCount();
 
+		Int tileY0;
+		Int tileY1;
+
+		if(state.tileBinning)
+		{
+			tileX0 = (tile & 0xFFF) << TILE_SIZE_SHIFT;
+			tileX1 = tileX0 + TILE_SIZE;
+			tileY0 = (tile >> 12) << TILE_SIZE_SHIFT;
+			tileY1 = tileY0 + TILE_SIZE;
+		}
+
 		Do
 		{
 			Int yMin = *Pointer<Int>(primitive + OFFSET(Primitive,yMin));
 			Int yMax = *Pointer<Int>(primitive + OFFSET(Primitive,yMax));
 
-			Int cluster2 = cluster + cluster;
-			yMin += clusterCount * 2 - 2 - cluster2;
-			yMin &= -clusterCount * 2;
-			yMin += cluster2;
+			if(state.tileBinning)
+			{
+				// The whole tile is rasterized by this call.
+				yMin = Max(yMin & -2, tileY0);
+				yMax = Min(yMax, tileY1);
+			}
+			else
+			{
+				// Round up to the first pair of scanlines belonging to this cluster.
+				Int cluster2 = cluster + cluster;
+				yMin += clusterCount * 2 - 2 - cluster2;
+				if(isPow2(clusterCount))
+				{
+					yMin &= -clusterCount * 2;
+				}
+				else
+				{
+					yMin -= yMin % Int(clusterCount * 2);
+				}
+				yMin += cluster2;
+			}
 
 			If(yMin < yMax)
 			{
+				computeOutline(yMin, yMax);
 				rasterize(yMin, yMax);
 			}
 
-			primitive += sizeof(Primitive) * state.multiSample;
+			primitive += primitiveSize;
 			count--;
 		}
 		Until(count == 0)
 
 		if(state.occlusionEnabled)
 		{
-			UInt clusterOcclusion = *Pointer<UInt>(data + OFFSET(DrawData,occlusion) + 4 * cluster);
-			clusterOcclusion += occlusion;
-			*Pointer<UInt>(data + OFFSET(DrawData,occlusion) + 4 * cluster) = clusterOcclusion;
+			Pointer<Byte> clusterOcclusion = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,occlusion)) + 4 * cluster;
+			*Pointer<UInt>(clusterOcclusion) += occlusion;
+		}
+
+		if(state.statisticsEnabled)
+		{
+			Pointer<Byte> clusterInvocations = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,fragmentInvocations)) + 4 * cluster;
+			*Pointer<UInt>(clusterInvocations) += fragmentInvocations;
 		}
 
 		#if PERF_PROFILE
@@ -81,13 +131,179 @@ namespace sw
 
 			for(int i = 0; i < PERF_TIMERS; i++)
 			{
-				*Pointer<Long>(data + OFFSET(DrawData,cycles[i]) + 8 * cluster) += cycles[i];
+				*Pointer<Long>(*Pointer<Pointer<Byte>>(data + OFFSET(DrawData,cycles[i])) + 8 * cluster) += cycles[i];
 			}
 		#endif
 
 		Return();
 	}
 
+	void QuadRasterizer::computeOutline(Int &yMin, Int &yMax)
+	{
+		// Only the scanlines rasterized by this call are computed: pairs of
+		// scanlines, step apart, starting at yMin and below yMax. Without tile
+		// binning the clusters rasterize interleaved pairs.
+		int step = 2 * (state.tileBinning ? 1 : Renderer::getClusterCount());
+
+		Int n = *Pointer<Int>(primitive + OFFSET(Primitive,n));
+		Int d = *Pointer<Int>(primitive + OFFSET(Primitive,d));
+
+		Int xMin = *Pointer<Int>(data + OFFSET(DrawData,scissorX0));
+		Int xMax = *Pointer<Int>(data + OFFSET(DrawData,scissorX1));
+		Short x = Short(Clamp((*Pointer<Int>(primitive + OFFSET(Primitive,X)) + 0xF) >> 4, xMin, xMax));
+
+		for(unsigned int q = 0; q < state.multiSample; q++)
+		{
+			Pointer<Byte> leftEdge = outline + q * sizeof(Outline) + OFFSET(Outline,span[0].left);
+			Pointer<Byte> rightEdge = outline + q * sizeof(Outline) + OFFSET(Outline,span[0].right);
+
+			// Scanlines outside of the polygon have zero length spans.
+			For(Int y = yMin, y < yMax, y += step)
+			{
+				*Pointer<Short>(leftEdge + y * sizeof(Outline::Span)) = x;
+				*Pointer<Short>(rightEdge + y * sizeof(Outline::Span)) = x;
+				*Pointer<Short>(leftEdge + (y + 1) * sizeof(Outline::Span)) = x;
+				*Pointer<Short>(rightEdge + (y + 1) * sizeof(Outline::Span)) = x;
+			}
+
+			Int Xf = 0;
+			Int Yf = 0;
+
+			if(state.multiSample > 1)
+			{
+				Xf = *Pointer<Int>(constants + OFFSET(Constants,Xf) + q * sizeof(int));
+				Yf = *Pointer<Int>(constants + OFFSET(Constants,Yf) + q * sizeof(int));
+			}
+
+			Int i = 0;
+
+			Do
+			{
+				Pointer<Byte> a = primitive + (i + 1 - d) * sizeof(int);
+				Pointer<Byte> b = primitive + (i + d) * sizeof(int);
+
+				Int Xa = *Pointer<Int>(a + OFFSET(Primitive,X)) + Xf;
+				Int Ya = *Pointer<Int>(a + OFFSET(Primitive,Y)) + Yf;
+				Int Xb = *Pointer<Int>(b + OFFSET(Primitive,X)) + Xf;
+				Int Yb = *Pointer<Int>(b + OFFSET(Primitive,Y)) + Yf;
+
+				edge(leftEdge, rightEdge, Xa, Ya, Xb, Yb, yMin, yMax, step);
+
+				i++;
+			}
+			Until(i >= n)
+		}
+	}
+
+	void QuadRasterizer::edge(Pointer<Byte> &leftEdge, Pointer<Byte> &rightEdge, const Int &Xa, const Int &Ya, const Int &Xb, const Int &Yb, Int &yMin, Int &yMax, int step)
+	{
+		If(Ya != Yb)
+		{
+			Bool swap = Yb < Ya;
+
+			Int X1 = IfThenElse(swap, Xb, Xa);
+			Int X2 = IfThenElse(swap, Xa, Xb);
+			Int Y1 = IfThenElse(swap, Yb, Ya);
+			Int Y2 = IfThenElse(swap, Ya, Yb);
+
+			Int y1 = Max((Y1 + 0x0000000F) >> 4, *Pointer<Int>(data + OFFSET(DrawData,scissorY0)));
+			Int y2 = Min((Y2 + 0x0000000F) >> 4, *Pointer<Int>(data + OFFSET(DrawData,scissorY1)));
+
+			Int yStart = Max(y1, yMin);
+			Int yEnd = Min(y2, yMax + 1);
+
+			If(yStart < yEnd)
+			{
+				Int xMin = *Pointer<Int>(data + OFFSET(DrawData,scissorX0));
+				Int xMax = *Pointer<Int>(data + OFFSET(DrawData,scissorX1));
+
+				Pointer<Byte> edge = IfThenElse(swap, rightEdge, leftEdge);
+
+				// Deltas
+				Int DX12 = X2 - X1;
+				Int DY12 = Y2 - Y1;
+
+				Int FDX12 = DX12 << 4;
+				Int FDY12 = DY12 << 4;
+
+				Int X = DX12 * ((y1 << 4) - Y1) + (X1 & 0x0000000F) * DY12;
+				Int x = (X1 >> 4) + X / FDY12;   // Edge
+				Int d = X % FDY12;               // Error-term
+				Int ceil = -d >> 31;             // Ceiling division: remainder <= 0
+				x -= ceil;
+				d -= ceil & FDY12;
+
+				Int Q = FDX12 / FDY12;   // Edge-step
+				Int R = FDX12 % FDY12;   // Error-step
+				Int floor = R >> 31;     // Flooring division: remainder >= 0
+				Q += floor;
+				R += floor & FDY12;
+
+				Int D = FDY12;   // Error-overflow
+
+				// Edge-step and error-step from the second scanline of a pair
+				// to the first one of the next pair. R < D, so the error-term
+				// overflows at most once per step.
+				Int Qs = Q;
+				Int Rs = R;
+
+				if(step > 2)
+				{
+					Int Rn = R * (step - 1);
+					Qs = Q * (step - 1) + Rn / D;
+					Rs = Rn % D;
+				}
+
+				// Start at the first scanline of the edge which belongs to a pair.
+				Int r = (yStart - yMin) % Int(step);
+				Int y = IfThenElse(r > 1, yStart + step - r, yStart);
+				Bool second = (r == 1);
+
+				// Skip the scanlines above the ones rasterized by this call. The
+				// number of error overflows is estimated, then corrected so the
+				// error-term stays in (-D, 0]. Only the result has to fit in 32 bits.
+				Int k = y - y1;
+
+				If(k > 0)
+				{
+					Int overflows = Int((Float(d) + Float(R) * Float(k)) / Float(D));
+					Int error = d + R * k - overflows * D;
+
+					While(error > 0)
+					{
+						error -= D;
+						overflows++;
+					}
+
+					While(error <= -D)
+					{
+						error += D;
+						overflows--;
+					}
+
+					x += Q * k + overflows;
+					d = error;
+				}
+
+				While(y < yEnd)
+				{
+					*Pointer<Short>(edge + y * sizeof(Outline::Span)) = Short(Clamp(x, xMin, xMax));
+
+					x += IfThenElse(second, Qs, Q);
+					d += IfThenElse(second, Rs, R);
+
+					Int overflow = -d >> 31;
+
+					d -= D & overflow;
+					x -= overflow;
+
+					y += IfThenElse(second, Int(step - 1), Int(1));
+					second = !second;
+				}
+			}
+		}
+	}
+
 	void QuadRasterizer::rasterize(Int &yMin, Int &yMax)
 	{
 		Pointer<Byte> cBuffer[RENDERTARGETS];
@@ -116,30 +332,36 @@ namespace sw
 
 		Do
 		{
-			Int x0a = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->left) + (y + 0) * sizeof(Primitive::Span)));
-			Int x0b = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->left) + (y + 1) * sizeof(Primitive::Span)));
+			Int x0a = Int(*Pointer<Short>(outline + OFFSET(Outline,span[0].left) + (y + 0) * sizeof(Outline::Span)));
+			Int x0b = Int(*Pointer<Short>(outline + OFFSET(Outline,span[0].left) + (y + 1) * sizeof(Outline::Span)));
 			Int x0 = Min(x0a, x0b);
 
 			for(unsigned int q = 1; q < state.multiSample; q++)
 			{
-				x0a = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->left) + (y + 0) * sizeof(Primitive::Span)));
-				x0b = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->left) + (y + 1) * sizeof(Primitive::Span)));
+				x0a = Int(*Pointer<Short>(outline + q * sizeof(Outline) + OFFSET(Outline,span[0].left) + (y + 0) * sizeof(Outline::Span)));
+				x0b = Int(*Pointer<Short>(outline + q * sizeof(Outline) + OFFSET(Outline,span[0].left) + (y + 1) * sizeof(Outline::Span)));
 				x0 = Min(x0, Min(x0a, x0b));
 			}
 
 			x0 &= 0xFFFFFFFE;
 
-			Int x1a = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->right) + (y + 0) * sizeof(Primitive::Span)));
-			Int x1b = Int(*Pointer<Short>(primitive + OFFSET(Primitive,outline->right) + (y + 1) * sizeof(Primitive::Span)));
+			Int x1a = Int(*Pointer<Short>(outline + OFFSET(Outline,span[0].right) + (y + 0) * sizeof(Outline::Span)));
+			Int x1b = Int(*Pointer<Short>(outline + OFFSET(Outline,span[0].right) + (y + 1) * sizeof(Outline::Span)));
 			Int x1 = Max(x1a, x1b);
 
 			for(unsigned int q = 1; q < state.multiSample; q++)
 			{
-				x1a = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->right) + (y + 0) * sizeof(Primitive::Span)));
-				x1b = Int(*Pointer<Short>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->right) + (y + 1) * sizeof(Primitive::Span)));
+				x1a = Int(*Pointer<Short>(outline + q * sizeof(Outline) + OFFSET(Outline,span[0].right) + (y + 0) * sizeof(Outline::Span)));
+				x1b = Int(*Pointer<Short>(outline + q * sizeof(Outline) + OFFSET(Outline,span[0].right) + (y + 1) * sizeof(Outline::Span)));
 				x1 = Max(x1, Max(x1a, x1b));
 			}
 
+			if(state.tileBinning)
+			{
+				x0 = Max(x0, tileX0);
+				x1 = Min(x1, tileX1);
+			}
+
 			Float4 yyyy = Float4(Float(y)) + *Pointer<Float4>(primitive + OFFSET(Primitive,yQuad), 16);
 
 			if(interpolateZ())
@@ -171,11 +393,11 @@ namespace sw
 						if (spirvShader->inputs[interpolant].Type == SpirvShader::ATTRIBTYPE_UNUSED)
 							continue;
 
-						Dv[interpolant] = *Pointer<Float4>(primitive + OFFSET(Primitive, V[interpolant].C), 16);
+						Dv[interpolant] = *Pointer<Float4>(primitive + OFFSET(Primitive, V[plane[interpolant]].C), 16);
 						if (!spirvShader->inputs[interpolant].Flat)
 						{
 							Dv[interpolant] +=
-									yyyy * *Pointer<Float4>(primitive + OFFSET(Primitive, V[interpolant].B), 16);
+									yyyy * *Pointer<Float4>(primitive + OFFSET(Primitive, V[plane[interpolant]].B), 16);
 						}
 					}
 				}
@@ -185,7 +407,7 @@ namespace sw
 
 				for(unsigned int q = 0; q < state.multiSample; q++)
 				{
-					xLeft[q] = *Pointer<Short4>(primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline) + y * sizeof(Primitive::Span));
+					xLeft[q] = *Pointer<Short4>(outline + q * sizeof(Outline) + OFFSET(Outline,span) + y * sizeof(Outline::Span));
 					xRight[q] = xLeft[q];
 
 					xLeft[q] = Swizzle(xLeft[q], 0xA0) - Short4(1, 2, 1, 2);
@@ -207,24 +429,25 @@ namespace sw
 				}
 			}
 
-			int clusterCount = Renderer::getClusterCount();
+			// With tile binning each call covers all the scanlines of its tile.
+			int clusterCount = state.tileBinning ? 1 : Renderer::getClusterCount();
 
 			for(int index = 0; index < RENDERTARGETS; index++)
 			{
 				if(state.colorWriteActive(index))
 				{
-					cBuffer[index] += *Pointer<Int>(data + OFFSET(DrawData,colorPitchB[index])) << (1 + sw::log2(clusterCount));   // FIXME: Precompute
+					cBuffer[index] += *Pointer<Int>(data + OFFSET(DrawData,colorPitchB[index])) * (2 * clusterCount);   // FIXME: Precompute
 				}
 			}
 
 			if(state.depthTestActive)
 			{
-				zBuffer += *Pointer<Int>(data + OFFSET(DrawData,depthPitchB)) << (1 + sw::log2(clusterCount));   // FIXME: Precompute
+				zBuffer += *Pointer<Int>(data + OFFSET(DrawData,depthPitchB)) * (2 * clusterCount);   // FIXME: Precompute
 			}
 
 			if(state.stencilActive)
 			{
-				sBuffer += *Pointer<Int>(data + OFFSET(DrawData,stencilPitchB)) << (1 + sw::log2(clusterCount));   // FIXME: Precompute
+				sBuffer += *Pointer<Int>(data + OFFSET(DrawData,stencilPitchB)) * (2 * clusterCount);   // FIXME: Precompute
 			}
 
 			y += 2 * clusterCount;
@@ -39,6 +39,7 @@ namespace sw
 		Float4 Df;
 
 		UInt occlusion;
+		UInt fragmentInvocations;
 
 #if PERF_PROFILE
 		Long cycles[PERF_TIMERS];
@@ -53,8 +54,20 @@ namespace sw
 		const PixelProcessor::State &state;
 		const SpirvShader *const spirvShader;
 
+		// Index of each interpolant's plane equation in Primitive::V
+		int plane[MAX_INTERFACE_COMPONENTS];
+
 	private:
+		void computeOutline(Int &yMin, Int &yMax);
+		void edge(Pointer<Byte> &leftEdge, Pointer<Byte> &rightEdge, const Int &Xa, const Int &Ya, const Int &Xb, const Int &Yb, Int &yMin, Int &yMax, int step);
 		void rasterize(Int &yMin, Int &yMax);
+
+		Pointer<Byte> outline;   // Scratch outlines of this cluster
+		int primitiveSize;
+
+		// Horizontal bounds of the tile, when tile binning
+		Int tileX0;
+		Int tileX1;
 	};
 }
 
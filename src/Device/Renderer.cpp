@@ -15,6 +15,7 @@
 #include "Renderer.hpp"
 
 #include "Clipper.hpp"
+#include "CoarseDepth.hpp"
 #include "Primitive.hpp"
 #include "Polygon.hpp"
 #include "Device/SwiftConfig.hpp"
@@ -34,6 +35,10 @@
 #include "Pipeline/SpirvShader.hpp"
 #include "Vertex.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #undef max
 
 bool disableServer = true;
@@ -53,6 +58,7 @@ namespace sw
 	extern bool exactColorRounding;
 	extern TransparencyAntialiasing transparencyAntialiasing;
 	extern bool forceClearRegisters;
+	extern bool tileBinning;
 
 	extern bool precacheVertex;
 	extern bool precacheSetup;
@@ -172,11 +178,224 @@ namespace sw
 		return true;
 	}
 
-	struct Parameters
+	static bool setBatchIndices(unsigned int batch[][3], VkPrimitiveTopology topology, VkIndexType indexType, const void *indices, unsigned int start, unsigned int triangleCount)
+	{
+		if(!indices)
+		{
+			struct LinearIndex
+			{
+				unsigned int operator[](unsigned int i) { return i; }
+			};
+
+			return setBatchIndices(batch, topology, LinearIndex(), start, triangleCount);
+		}
+
+		switch(indexType)
+		{
+		case VK_INDEX_TYPE_UINT16:
+			return setBatchIndices(batch, topology, static_cast<const uint16_t*>(indices), start, triangleCount);
+		case VK_INDEX_TYPE_UINT32:
+			return setBatchIndices(batch, topology, static_cast<const uint32_t*>(indices), start, triangleCount);
+		default:
+			ASSERT(false);
+			return false;
+		}
+	}
+
+	// Fills in the task's unique vertex set from the batch's primitive vertex
+	// indices and the instance of each primitive, and returns the number of
+	// unique vertices.
+	static unsigned int setBatchVertices(VertexTask *task, const unsigned int *indices, const unsigned int *instances, unsigned int vertexCount)
+	{
+		ASSERT(vertexCount <= VertexTask::MAX_VERTICES);
+
+		// Open addressing hash table from vertex index to unique vertex,
+		// sized to stay at most 3/8 full.
+		const unsigned int tableSize = 1024;
+		unsigned int table[tableSize];
+		memset(table, 0xFF, sizeof(table));
+
+		unsigned int uniqueCount = 0;
+
+		for(unsigned int i = 0; i < vertexCount; i++)
+		{
+			unsigned int index = indices[i];
+			unsigned int instance = instances[i / 3];
+			unsigned int h = ((index ^ (instance * 0x01000193u)) * 0x9E3779B1u) >> 22;   // Top 10 bits index the table
+
+			while(table[h] != ~0u && (task->indices[table[h]] != index || task->instances[table[h]] != instance))
+			{
+				h = (h + 1) & (tableSize - 1);
+			}
+
+			if(table[h] == ~0u)
+			{
+				table[h] = uniqueCount;
+				task->indices[uniqueCount] = index;
+				task->instances[uniqueCount] = instance;
+				task->slots[uniqueCount] = i;
+				uniqueCount++;
+			}
+
+			task->sources[i] = task->slots[table[h]];
+		}
+
+		// Pad the last group of four by shading its last vertex again.
+		task->uniqueCount = (uniqueCount + 3) & ~3u;
+
+		for(unsigned int i = uniqueCount; i < task->uniqueCount; i++)
+		{
+			task->indices[i] = task->indices[uniqueCount - 1];
+			task->instances[i] = task->instances[uniqueCount - 1];
+			task->slots[i] = task->slots[uniqueCount - 1];
+		}
+
+		return uniqueCount;
+	}
+
+	// Number of vertices the input assembler reads for primitiveCount primitives.
+	static unsigned int assembledVertexCount(VkPrimitiveTopology topology, unsigned int primitiveCount)
+	{
+		switch(topology)
+		{
+		case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+			return primitiveCount;
+		case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+			return primitiveCount * 2;
+		case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+			return primitiveCount + 1;
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
+			return primitiveCount * 3;
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
+			return primitiveCount + 2;
+		default:
+			UNIMPLEMENTED("topology %d", int(topology));
+		}
+
+		return 0;
+	}
+
+	// Returns true if fragments failing the stencil or depth test may still
+	// write to the stencil buffer.
+	static bool writesStencilOnFailure(const PixelProcessor::State &state)
+	{
+		if(!state.stencilActive)
+		{
+			return false;
+		}
+
+		auto writesOnFailure = [](const VkStencilOpState &stencil)
+		{
+			return (stencil.writeMask != 0) &&
+			       ((stencil.failOp != VK_STENCIL_OP_KEEP) || (stencil.depthFailOp != VK_STENCIL_OP_KEEP));
+		};
+
+		return writesOnFailure(state.frontStencil) || (state.twoSidedStencil && writesOnFailure(state.backStencil));
+	}
+
+	// Returns the minimum or maximum depth of the primitive over the pixels
+	// of [x0, x1) x [y0, y1), widened by the rounding of the pixel routine.
+	static double depthExtremum(const DrawCall &draw, const Primitive &primitive, int x0, int y0, int x1, int y1, bool maximum)
+	{
+		// The depth plane is relative to the first vertex, and evaluated at
+		// sample positions within half a pixel of the pixel centers. Its
+		// extrema over the rectangle widened by a pixel are at its corners.
+		double A = primitive.z.A.x;
+		double B = primitive.z.B.x;
+		double C = primitive.z.C.x;
+
+		double xa = x0 - 1 + primitive.xQuad.x;
+		double xb = x1 + primitive.xQuad.x;
+		double ya = y0 - 1 + primitive.yQuad.x;
+		double yb = y1 + primitive.yQuad.x;
+
+		double z = maximum ? A * ((A >= 0.0) ? xb : xa) + B * ((B >= 0.0) ? yb : ya) + C
+		                   : A * ((A >= 0.0) ? xa : xb) + B * ((B >= 0.0) ? ya : yb) + C;
+
+		// Allow for the rounding of the pixel routine's single precision interpolation.
+		double magnitude = std::abs(A) * std::max(std::abs(xa), std::abs(xb)) +
+		                   std::abs(B) * std::max(std::abs(ya), std::abs(yb)) +
+		                   std::abs(C);
+		z += (maximum ? magnitude : -magnitude) * (1.0 / 0x100000);
+
+		if(draw.depthClamp)
+		{
+			z = clamp(z, 0.0, 1.0);
+		}
+
+		return z;
+	}
+
+	// Returns true if the pixel routine writes the depth of every sample inside
+	// a primitive which passes the depth test, or keeps a lower depth.
+	static bool writesEverySample(const Context *context, const PixelProcessor::State &state)
+	{
+		unsigned int allSamples = (1u << state.multiSample) - 1;
+
+		if(state.stencilActive || state.alphaToCoverage || ((state.multiSampleMask & allSamples) != allSamples))
+		{
+			return false;
+		}
+
+		if(context->pixelShader)
+		{
+			const SpirvShader *shader = context->pixelShader;
+
+			if(shader->getModes().ContainsKill || shader->hasBuiltinOutput(spv::BuiltInSampleMask))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Returns true if the primitive is behind the coarse depth bounds of the
+	// pixels it covers within [x0, x1) x [y0, y1).
+	static bool isOccluded(const DrawCall &draw, const Primitive &primitive, int x0, int y0, int x1, int y1)
+	{
+		double z = depthExtremum(draw, primitive, x0, y0, x1, y1, false);
+
+		return draw.coarseDepth->occludes(x0, y0, x1, y1, static_cast<float>(z));
+	}
+
+	// Returns true if every sample of the pixels of [x0, x1) x [y0, y1) is
+	// inside the primitive's polygon.
+	static bool coversRectangle(const Primitive &primitive, int x0, int y0, int x1, int y1)
 	{
-		Renderer *renderer;
-		int threadIndex;
-	};
+		// The polygon is in 1/16th pixel units, with pixel centers at multiples
+		// of 16. Samples are within half a pixel of them, so the rectangle is
+		// widened by a pixel to allow for the rasterizer's rounding too.
+		const int64_t cornerX[4] = { (x0 - 1) * 16, (x1 + 0) * 16, (x1 + 0) * 16, (x0 - 1) * 16 };
+		const int64_t cornerY[4] = { (y0 - 1) * 16, (y0 - 1) * 16, (y1 + 0) * 16, (y1 + 0) * 16 };
+
+		int64_t area = 0;
+		for(int i = 0; i < primitive.n; i++)
+		{
+			area += static_cast<int64_t>(primitive.X[i]) * primitive.Y[i + 1] - static_cast<int64_t>(primitive.X[i + 1]) * primitive.Y[i];
+		}
+
+		// The polygon is convex, so it contains the rectangle if it contains
+		// its corners, which are then on the inner side of every edge.
+		for(int i = 0; i < primitive.n; i++)
+		{
+			int64_t dx = primitive.X[i + 1] - primitive.X[i];
+			int64_t dy = primitive.Y[i + 1] - primitive.Y[i];
+
+			for(int c = 0; c < 4; c++)
+			{
+				int64_t side = dx * (cornerY[c] - primitive.Y[i]) - dy * (cornerX[c] - primitive.X[i]);
+
+				if((area > 0) ? (side < 0) : (side > 0))
+				{
+					return false;
+				}
+			}
+		}
+
+		return area != 0;
+	}
 
 	DrawCall::DrawCall()
 	{
@@ -186,8 +405,31 @@ namespace sw
 
 		events = nullptr;
 
+		coarseDepth = nullptr;
+		coarseDepthCull = false;
+		coarseDepthLower = false;
+		depthClamp = false;
+		tileBinning = false;
+
+		statisticsEnabled = false;
+		assemblyVertices = 0;
+		assemblyPrimitives = 0;
+		vertexInvocations = 0;
+		clippingInvocations = 0;
+		clippingPrimitives = 0;
+
 		data = (DrawData*)allocate(sizeof(DrawData));
 		data->constants = &constants;
+		data->occlusion = nullptr;
+		data->fragmentInvocations = nullptr;
+		data->outline = nullptr;
+
+		#if PERF_PROFILE
+			for(int i = 0; i < PERF_TIMERS; i++)
+			{
+				data->cycles[i] = nullptr;
+			}
+		#endif
 	}
 
 	DrawCall::~DrawCall()
@@ -205,44 +447,23 @@ namespace sw
 			resetTimers();
 		#endif
 
-		for(int i = 0; i < 16; i++)
-		{
-			vertexTask[i] = nullptr;
-
-			worker[i] = nullptr;
-			resume[i] = nullptr;
-			suspend[i] = nullptr;
-		}
-
-		threadsAwake = 0;
 		resumeApp = new Event();
+		outlines = nullptr;
 
-		currentDraw = 0;
-		nextDraw = 0;
+		vertexRoutine = nullptr;
+		setupRoutine = nullptr;
+		pixelRoutine = nullptr;
 
-		qHead = 0;
-		qSize = 0;
+		nextDrawID = 0;
 
-		for(int i = 0; i < 16; i++)
-		{
-			triangleBatch[i] = nullptr;
-			primitiveBatch[i] = nullptr;
-		}
+		shadedVertexCount = 0;
+		shadedPrimitiveCount = 0;
+		coarseDepthTestCount = 0;
+		coarseDepthCullCount = 0;
 
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
 			drawCall[draw] = new DrawCall();
-			drawList[draw] = drawCall[draw];
-		}
-
-		for(int unit = 0; unit < 16; unit++)
-		{
-			primitiveProgress[unit].init();
-		}
-
-		for(int cluster = 0; cluster < 16; cluster++)
-		{
-			pixelProgress[cluster].init();
 		}
 
 		clipFlags = 0;
@@ -263,6 +484,13 @@ namespace sw
 		delete resumeApp;
 		resumeApp = nullptr;
 
+		if(vertexRoutine)
+		{
+			vertexRoutine->unbind();
+			setupRoutine->unbind();
+			pixelRoutine->unbind();
+		}
+
 		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
 			delete drawCall[draw];
@@ -298,9 +526,9 @@ namespace sw
 		return false;
 	}
 
-	void Renderer::draw(const sw::Context* context, VkIndexType indexType, unsigned int count, int baseVertex, TaskEvents *events, bool update)
+	void Renderer::draw(const sw::Context* context, VkIndexType indexType, unsigned int count, unsigned int instanceCount, int baseVertex, TaskEvents *events, bool update)
 	{
-		if(count == 0) { return; }
+		if(count == 0 || instanceCount == 0) { return; }
 
 		#ifndef NDEBUG
 			if(count < minPrimitives || count > maxPrimitives)
@@ -326,14 +554,21 @@ namespace sw
 			setupState = SetupProcessor::update(context);
 			pixelState = PixelProcessor::update(context);
 
+			if(vertexRoutine)
+			{
+				vertexRoutine->unbind();
+				setupRoutine->unbind();
+				pixelRoutine->unbind();
+			}
+
 			vertexRoutine = VertexProcessor::routine(vertexState, context->pipelineLayout, context->vertexShader, context->descriptorSets);
 			setupRoutine = SetupProcessor::routine(setupState);
 			pixelRoutine = PixelProcessor::routine(pixelState, context->pipelineLayout, context->pixelShader, context->descriptorSets);
 		}
 
-		int batch = batchSize / ms;
+		int batch = batchSize;
 
-		int (Renderer::*setupPrimitives)(int batch, int count);
+		int (Renderer::*setupPrimitives)(BatchData *batch);
 
 		if(context->isDrawTriangle())
 		{
@@ -357,7 +592,6 @@ namespace sw
 				if(drawCall[i]->references == -1)
 				{
 					draw = drawCall[i];
-					drawList[nextDraw & DRAW_COUNT_BITS] = draw;
 
 					break;
 				}
@@ -399,6 +633,17 @@ namespace sw
 		draw->setupPrimitives = setupPrimitives;
 		draw->setupState = setupState;
 
+		int interpolants = 0;
+		for(int interpolant = 0; interpolant < MAX_INTERFACE_COMPONENTS; interpolant++)
+		{
+			if(setupState.gradient[interpolant].Type != SpirvShader::ATTRIBTYPE_UNUSED)
+			{
+				interpolants++;
+			}
+		}
+
+		draw->primitiveStride = Primitive::size(interpolants);
+
 		data->descriptorSets = context->descriptorSets;
 		data->descriptorDynamicOffsets = context->descriptorDynamicOffsets;
 
@@ -414,14 +659,11 @@ namespace sw
 		{
 			data->input[i] = context->input[i].buffer;
 			data->stride[i] = context->input[i].vertexStride;
+			data->instanceStride[i] = context->input[i].instanceStride;
 		}
 
 		data->indices = context->indexBuffer;
-
-		if(context->vertexShader->hasBuiltinInput(spv::BuiltInInstanceIndex))
-		{
-			data->instanceID = context->instanceID;
-		}
+		data->firstInstance = context->instanceID;
 
 		data->baseVertex = baseVertex;
 
@@ -460,6 +702,25 @@ namespace sw
 			}
 		}
 
+		// The global setting can change while earlier draws are still being
+		// rasterized, so each draw keeps the one its pixel routine was built for.
+		draw->tileBinning = pixelState.tileBinning;
+		draw->statisticsEnabled = pixelState.statisticsEnabled;
+
+		if(pixelState.statisticsEnabled)
+		{
+			draw->assemblyVertices = int64_t(assembledVertexCount(context->topology, count)) * instanceCount;
+			draw->assemblyPrimitives = int64_t(count) * instanceCount;
+			draw->vertexInvocations = 0;
+			draw->clippingInvocations = 0;
+			draw->clippingPrimitives = 0;
+
+			for(int cluster = 0; cluster < clusterCount; cluster++)
+			{
+				data->fragmentInvocations[cluster] = 0;
+			}
+		}
+
 		#if PERF_PROFILE
 			for(int cluster = 0; cluster < clusterCount; cluster++)
 			{
@@ -521,6 +782,32 @@ namespace sw
 				data->depthSliceB = context->depthBuffer->slicePitchBytes(VK_IMAGE_ASPECT_DEPTH_BIT, 0);
 			}
 
+			draw->coarseDepth = nullptr;
+			draw->coarseDepthCull = false;
+			draw->coarseDepthLower = false;
+			draw->depthClamp = pixelState.depthClamp;
+
+			CoarseDepth *coarseDepth = draw->depthBuffer ? draw->depthBuffer->getCoarseDepth() : nullptr;
+
+			if(coarseDepth && pixelState.depthTestActive)
+			{
+				VkCompareOp compare = pixelState.depthCompareMode;
+				bool lessCompare = (compare == VK_COMPARE_OP_LESS) || (compare == VK_COMPARE_OP_LESS_OR_EQUAL);
+
+				// The bounds only remain conservative while depth decreases.
+				if(pixelState.depthWriteEnable && !lessCompare && (compare != VK_COMPARE_OP_EQUAL) && (compare != VK_COMPARE_OP_NEVER))
+				{
+					coarseDepth->invalidate();
+				}
+
+				bool depthReplacing = context->pixelShader && context->pixelShader->getModes().DepthReplacing;
+
+				draw->coarseDepth = coarseDepth;
+				draw->coarseDepthCull = lessCompare && coarseDepth->isValid() && !depthReplacing && !writesStencilOnFailure(pixelState);
+				draw->coarseDepthLower = draw->coarseDepthCull && pixelState.depthWriteEnable && context->isDrawTriangle() &&
+				                         writesEverySample(context, pixelState);
+			}
+
 			if(draw->stencilBuffer)
 			{
 				data->stencilBuffer = (unsigned char*)context->stencilBuffer->getOffsetPointer({0, 0, 0}, VK_IMAGE_ASPECT_STENCIL_BIT, 0, 0);
@@ -542,269 +829,391 @@ namespace sw
 			data->pushConstants = context->pushConstants;
 		}
 
-		draw->primitive = 0;
-		draw->count = count;
+		draw->id = nextDrawID++;
+		draw->count = count * instanceCount;
+		draw->instancePrimitives = count;
 
+		// Instances follow each other in the primitive stream, and batches
+		// may straddle them.
+		count = draw->count;
 		draw->references = (count + batch - 1) / batch;
 
-		schedulerMutex.lock();
-		++nextDraw; // Atomic
-		schedulerMutex.unlock();
+		for(unsigned int firstPrimitive = 0; firstPrimitive < count; firstPrimitive += batch)
+		{
+			// Blocks until the pipeline has drained enough to accept the batch.
+			BatchData *batchData = freeBatches.take();
+
+			batchData->draw = draw;
+			batchData->firstPrimitive = firstPrimitive;
+			batchData->numPrimitives = std::min(count - firstPrimitive, static_cast<unsigned int>(batch));
+			batchData->numVisible = 0;
+
+			batchData->clustersRemaining = clusterCount;
+			for(int cluster = 0; cluster < clusterCount; cluster++)
+			{
+				batchData->clusterTickets[cluster] = clusterQueues[cluster].take();
+			}
+
+			#if PERF_HUD
+				int64_t scheduled = Timer::ticks();
+			#endif
+
+			schedule([=]
+			{
+				#if PERF_HUD
+					int64_t start = Timer::ticks();
+					queueLatency[VERTEX_STAGE] += start - scheduled;
+				#endif
+
+				processVertices(batchData);
 
+				#if PERF_HUD
+					stageTime[VERTEX_STAGE] += Timer::ticks() - start;
+					taskCount[VERTEX_STAGE]++;
+				#endif
+			});
+		}
+	}
+
+	void Renderer::schedule(ThreadPool::Task &&task)
+	{
 		#ifndef NDEBUG
 		if(threadCount == 1)   // Use main thread for draw execution
 		{
-			threadsAwake = 1;
-			task[0].type = Task::RESUME;
-
-			taskLoop(0);
+			task();
+			return;
 		}
-		else
 		#endif
+
+		ThreadPool::get().schedule([task]
 		{
-			if(!threadsAwake)
+			if(logPrecision < IEEE)
 			{
-				suspend[0]->wait();
-
-				threadsAwake = 1;
-				task[0].type = Task::RESUME;
-
-				resume[0]->signal();
+				CPUID::setFlushToZero(true);
+				CPUID::setDenormalsAreZero(true);
 			}
-		}
+
+			task();
+		});
 	}
 
-	void Renderer::threadFunction(void *parameters)
+	void Renderer::processVertices(BatchData *batch)
 	{
-		Renderer *renderer = static_cast<Parameters*>(parameters)->renderer;
-		int threadIndex = static_cast<Parameters*>(parameters)->threadIndex;
+		processPrimitiveVertices(batch);
 
-		if(logPrecision < IEEE)
+		if(batch->draw->setupState.rasterizerDiscard)
 		{
-			CPUID::setFlushToZero(true);
-			CPUID::setDenormalsAreZero(true);
+			for(int cluster = 0; cluster < clusterCount; cluster++)
+			{
+				batch->clusterTickets[cluster].done();
+				finishCluster(batch);
+			}
+
+			return;
 		}
 
-		renderer->threadLoop(threadIndex);
+		#if PERF_HUD
+			int64_t scheduled = Timer::ticks();
+		#endif
+
+		// Setup runs as a separate task, which the pool executes next on this
+		// thread unless another worker is idle and steals it.
+		schedule([=]
+		{
+			#if PERF_HUD
+				int64_t start = Timer::ticks();
+				queueLatency[SETUP_STAGE] += start - scheduled;
+			#endif
+
+			processPrimitives(batch);
+
+			#if PERF_HUD
+				stageTime[SETUP_STAGE] += Timer::ticks() - start;
+				taskCount[SETUP_STAGE]++;
+			#endif
+
+			processPixels(batch);
+		});
 	}
 
-	void Renderer::threadLoop(int threadIndex)
+	void Renderer::processPrimitives(BatchData *batch)
 	{
-		while(!exitThreads)
+		DrawCall *draw = batch->draw;
+
+		batch->numVisible = (this->*draw->setupPrimitives)(batch);
+
+		if(draw->statisticsEnabled)
 		{
-			taskLoop(threadIndex);
+			draw->clippingInvocations += batch->numPrimitives;
+			draw->clippingPrimitives += batch->numVisible;
+		}
 
-			suspend[threadIndex]->signal();
-			resume[threadIndex]->wait();
+		if(draw->tileBinning)
+		{
+			binPrimitives(batch);
+		}
+		else if(draw->coarseDepthCull)
+		{
+			cullOccludedPrimitives(batch);
 		}
-	}
 
-	void Renderer::taskLoop(int threadIndex)
-	{
-		while(task[threadIndex].type != Task::SUSPEND)
+		if(draw->coarseDepthLower)
 		{
-			scheduleTask(threadIndex);
-			executeTask(threadIndex);
+			findCoveredTiles(batch);
 		}
 	}
 
-	void Renderer::findAvailableTasks()
+	void Renderer::findCoveredTiles(BatchData *batch)
 	{
-		// Find pixel tasks
-		for(int cluster = 0; cluster < clusterCount; cluster++)
+		batch->coveredTiles.clear();
+
+		const DrawCall &draw = *batch->draw;
+		const CoarseDepth &coarseDepth = *draw.coarseDepth;
+		int stride = draw.primitiveStride;
+
+		// Unsigned normalized depth is clamped when written.
+		bool clamped = (coarseDepth.getFormat() == VK_FORMAT_D16_UNORM);
+
+		for(int i = 0; i < batch->numVisible; i++)
 		{
-			if(!pixelProgress[cluster].executing)
+			const Primitive &primitive = *reinterpret_cast<const Primitive*>(reinterpret_cast<const char*>(batch->primitives) + i * stride);
+
+			// Only tiles within the scissored bounds can be written entirely.
+			int tileX0 = (primitive.xMin + COARSE_DEPTH_TILE_SIZE - 1) >> COARSE_DEPTH_TILE_SHIFT;
+			int tileY0 = (primitive.yMin + COARSE_DEPTH_TILE_SIZE - 1) >> COARSE_DEPTH_TILE_SHIFT;
+
+			for(int tileY = tileY0; (tileY << COARSE_DEPTH_TILE_SHIFT) < coarseDepth.getHeight(); tileY++)
 			{
-				for(int unit = 0; unit < unitCount; unit++)
+				int y0 = tileY << COARSE_DEPTH_TILE_SHIFT;
+				int y1 = std::min(y0 + COARSE_DEPTH_TILE_SIZE, coarseDepth.getHeight());
+
+				if(y1 > primitive.yMax)
 				{
-					if(primitiveProgress[unit].references > 0)   // Contains processed primitives
+					break;
+				}
+
+				for(int tileX = tileX0; (tileX << COARSE_DEPTH_TILE_SHIFT) < coarseDepth.getWidth(); tileX++)
+				{
+					int x0 = tileX << COARSE_DEPTH_TILE_SHIFT;
+					int x1 = std::min(x0 + COARSE_DEPTH_TILE_SIZE, coarseDepth.getWidth());
+
+					if(x1 > primitive.xMax)
 					{
-						if(pixelProgress[cluster].drawCall == primitiveProgress[unit].drawCall)
-						{
-							if(pixelProgress[cluster].processedPrimitives == primitiveProgress[unit].firstPrimitive)   // Previous primitives have been rendered
-							{
-								Task &task = taskQueue[qHead];
-								task.type = Task::PIXELS;
-								task.primitiveUnit = unit;
-								task.pixelCluster = cluster;
+						break;
+					}
 
-								pixelProgress[cluster].executing = true;
+					if(!coversRectangle(primitive, x0, y0, x1, y1))
+					{
+						continue;
+					}
 
-								// Commit to the task queue
-								qHead = (qHead + 1) & TASK_COUNT_BITS;
-								qSize++;
+					double z = depthExtremum(draw, primitive, x0, y0, x1, y1, true);
 
-								break;
-							}
-						}
+					if(clamped)
+					{
+						z = clamp(z, 0.0, 1.0);
 					}
+
+					batch->coveredTiles.push_back({ tileX, tileY, static_cast<float>(z) });
 				}
 			}
 		}
+	}
 
-		// Find primitive tasks
-		if(currentDraw == nextDraw)
+	void Renderer::cullOccludedPrimitives(BatchData *batch)
+	{
+		const DrawCall &draw = *batch->draw;
+		int stride = draw.primitiveStride;
+		int culled = 0;
+
+		for(int i = 0; i < batch->numVisible; i++)
 		{
-			return;   // No more primitives to process
+			Primitive &primitive = *reinterpret_cast<Primitive*>(reinterpret_cast<char*>(batch->primitives) + i * stride);
+
+			if(isOccluded(draw, primitive, primitive.xMin, primitive.yMin, primitive.xMax, primitive.yMax))
+			{
+				// Leave no scanlines for the pixel routine to rasterize.
+				primitive.yMax = primitive.yMin;
+				culled++;
+			}
 		}
 
-		for(int unit = 0; unit < unitCount; unit++)
-		{
-			DrawCall *draw = drawList[currentDraw & DRAW_COUNT_BITS];
+		coarseDepthTestCount += batch->numVisible;
+		coarseDepthCullCount += culled;
+	}
 
-			int primitive = draw->primitive;
-			int count = draw->count;
+	void Renderer::binPrimitives(BatchData *batch)
+	{
+		for(auto &bin : batch->clusterBins)
+		{
+			bin.clear();
+		}
 
-			if(primitive >= count)
-			{
-				++currentDraw; // Atomic
+		const DrawCall &draw = *batch->draw;
+		int stride = draw.primitiveStride;
+		int culled = 0;
 
-				if(currentDraw == nextDraw)
-				{
-					return;   // No more primitives to process
-				}
+		for(int i = 0; i < batch->numVisible; i++)
+		{
+			const Primitive &primitive = *reinterpret_cast<const Primitive*>(reinterpret_cast<const char*>(batch->primitives) + i * stride);
 
-				draw = drawList[currentDraw & DRAW_COUNT_BITS];
+			if(primitive.xMin >= primitive.xMax)
+			{
+				continue;
 			}
 
-			if(!primitiveProgress[unit].references)   // Task not already being executed and not still in use by a pixel unit
+			int tileX0 = primitive.xMin >> TILE_SIZE_SHIFT;
+			int tileX1 = (primitive.xMax - 1) >> TILE_SIZE_SHIFT;
+			int tileY0 = primitive.yMin >> TILE_SIZE_SHIFT;
+			int tileY1 = (primitive.yMax - 1) >> TILE_SIZE_SHIFT;
+			bool binned = false;
+
+			for(int tileY = tileY0; tileY <= tileY1; tileY++)
 			{
-				primitive = draw->primitive;
-				count = draw->count;
-				int batch = draw->batchSize;
+				for(int tileX = tileX0; tileX <= tileX1; tileX++)
+				{
+					if(draw.coarseDepthCull)
+					{
+						int x0 = std::max(primitive.xMin, tileX << TILE_SIZE_SHIFT);
+						int y0 = std::max(primitive.yMin, tileY << TILE_SIZE_SHIFT);
+						int x1 = std::min(primitive.xMax, (tileX + 1) << TILE_SIZE_SHIFT);
+						int y1 = std::min(primitive.yMax, (tileY + 1) << TILE_SIZE_SHIFT);
 
-				primitiveProgress[unit].drawCall = currentDraw;
-				primitiveProgress[unit].firstPrimitive = primitive;
-				primitiveProgress[unit].primitiveCount = count - primitive >= batch ? batch : count - primitive;
+						if(isOccluded(draw, primitive, x0, y0, x1, y1))
+						{
+							continue;
+						}
+					}
 
-				draw->primitive += batch;
+					binned = true;
 
-				Task &task = taskQueue[qHead];
-				task.type = Task::PRIMITIVES;
-				task.primitiveUnit = unit;
+					// Tiles are assigned to clusters diagonally, so that the
+					// tiles of neighboring primitives are spread over clusters.
+					int cluster = (tileX + tileY) % clusterCount;
+					unsigned int tile = (tileY << 12) | tileX;
 
-				primitiveProgress[unit].references = -1;
+					batch->clusterBins[cluster].push_back((tile << 8) | i);
+				}
+			}
 
-				// Commit to the task queue
-				qHead = (qHead + 1) & TASK_COUNT_BITS;
-				qSize++;
+			if(!binned)
+			{
+				culled++;
 			}
 		}
-	}
-
-	void Renderer::scheduleTask(int threadIndex)
-	{
-		schedulerMutex.lock();
 
-		int curThreadsAwake = threadsAwake;
+		if(draw.coarseDepthCull)
+		{
+			coarseDepthTestCount += batch->numVisible;
+			coarseDepthCullCount += culled;
+		}
 
-		if((int)qSize < threadCount - curThreadsAwake + 1)
+		// Sort the primitives of each cluster by tile, keeping them in order
+		// within each tile.
+		for(auto &bin : batch->clusterBins)
 		{
-			findAvailableTasks();
+			std::sort(bin.begin(), bin.end());
 		}
+	}
 
-		if(qSize != 0)
+	void Renderer::processPixels(BatchData *batch)
+	{
+		for(int cluster = 0; cluster < clusterCount; cluster++)
 		{
-			task[threadIndex] = taskQueue[(qHead - qSize) & TASK_COUNT_BITS];
-			qSize--;
+			if(batch->numVisible == 0 || (batch->draw->tileBinning && batch->clusterBins[cluster].empty()))
+			{
+				batch->clusterTickets[cluster].done();
+				finishCluster(batch);
+				continue;
+			}
 
-			if(curThreadsAwake != threadCount)
+			// Each cluster has to process the batches in order, so the pixel
+			// task is only scheduled once the cluster is done with all the
+			// previously submitted batches.
+			batch->clusterTickets[cluster].onCall([=]
 			{
-				int wakeup = qSize - curThreadsAwake + 1;
+				#if PERF_HUD
+					int64_t scheduled = Timer::ticks();
+				#endif
 
-				for(int i = 0; i < threadCount && wakeup > 0; i++)
+				schedule([=]
 				{
-					if(task[i].type == Task::SUSPEND)
-					{
-						suspend[i]->wait();
-						task[i].type = Task::RESUME;
-						resume[i]->signal();
+					#if PERF_HUD
+						int64_t start = Timer::ticks();
+						queueLatency[PIXEL_STAGE] += start - scheduled;
+					#endif
 
-						++threadsAwake; // Atomic
-						wakeup--;
-					}
-				}
-			}
-		}
-		else
-		{
-			task[threadIndex].type = Task::SUSPEND;
+					rasterize(batch, cluster);
 
-			--threadsAwake; // Atomic
-		}
+					#if PERF_HUD
+						stageTime[PIXEL_STAGE] += Timer::ticks() - start;
+						taskCount[PIXEL_STAGE]++;
+					#endif
 
-		schedulerMutex.unlock();
+					batch->clusterTickets[cluster].done();
+					finishCluster(batch);
+				});
+			});
+		}
 	}
 
-	void Renderer::executeTask(int threadIndex)
+	void Renderer::rasterize(BatchData *batch, int cluster)
 	{
-		#if PERF_HUD
-			int64_t startTick = Timer::ticks();
-		#endif
+		DrawCall *draw = batch->draw;
 
-		switch(task[threadIndex].type)
+		if(!draw->tileBinning)
 		{
-		case Task::PRIMITIVES:
-			{
-				int unit = task[threadIndex].primitiveUnit;
+			draw->pixelPointer(batch->primitives, batch->numVisible, cluster, 0, draw->data);
+			return;
+		}
 
-				int input = primitiveProgress[unit].firstPrimitive;
-				int count = primitiveProgress[unit].primitiveCount;
-				DrawCall *draw = drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-				int (Renderer::*setupPrimitives)(int batch, int count) = draw->setupPrimitives;
+		// Rasterize runs of consecutive primitives overlapping the same tile.
+		const std::vector<unsigned int> &bin = batch->clusterBins[cluster];
+		char *primitives = reinterpret_cast<char*>(batch->primitives);
 
-				processPrimitiveVertices(unit, input, count, draw->count, threadIndex);
+		for(size_t i = 0; i < bin.size();)
+		{
+			unsigned int tile = bin[i] >> 8;
+			unsigned int first = bin[i] & 0xFF;
+			size_t count = 1;
 
-				#if PERF_HUD
-					int64_t time = Timer::ticks();
-					vertexTime[threadIndex] += time - startTick;
-					startTick = time;
-				#endif
+			while(i + count < bin.size() && bin[i + count] == bin[i] + count)
+			{
+				count++;
+			}
 
-				int visible = 0;
+			draw->pixelPointer(reinterpret_cast<Primitive*>(primitives + first * draw->primitiveStride), static_cast<int>(count), cluster, tile, draw->data);
 
-				if(!draw->setupState.rasterizerDiscard)
-				{
-					visible = (this->*setupPrimitives)(unit, count);
-				}
+			i += count;
+		}
+	}
 
-				primitiveProgress[unit].visible = visible;
-				primitiveProgress[unit].references = clusterCount;
+	void Renderer::finishCluster(BatchData *batch)
+	{
+		int ref = batch->clustersRemaining--;   // Atomic
 
-				#if PERF_HUD
-					setupTime[threadIndex] += Timer::ticks() - startTick;
-				#endif
-			}
-			break;
-		case Task::PIXELS:
-			{
-				int unit = task[threadIndex].primitiveUnit;
-				int visible = primitiveProgress[unit].visible;
+		if(ref == 0)
+		{
+			DrawCall &draw = *batch->draw;
 
-				if(visible > 0)
+			// Every cluster has written the batch, after all the earlier
+			// batches, so no primitive they culled was in front of these.
+			if(draw.coarseDepthLower)
+			{
+				for(auto &tile : batch->coveredTiles)
 				{
-					int cluster = task[threadIndex].pixelCluster;
-					Primitive *primitive = primitiveBatch[unit];
-					DrawCall *draw = drawList[pixelProgress[cluster].drawCall & DRAW_COUNT_BITS];
-					DrawData *data = draw->data;
-					PixelProcessor::RoutinePointer pixelRoutine = draw->pixelPointer;
-
-					pixelRoutine(primitive, visible, cluster, data);
+					draw.coarseDepth->lower(tile.x, tile.y, tile.depth);
 				}
+			}
 
-				finishRendering(task[threadIndex]);
+			ref = draw.references--;   // Atomic
 
-				#if PERF_HUD
-					pixelTime[threadIndex] += Timer::ticks() - startTick;
-				#endif
+			if(ref == 0)
+			{
+				finishRendering(draw);
 			}
-			break;
-		case Task::RESUME:
-			break;
-		case Task::SUSPEND:
-			break;
-		default:
-			ASSERT(false);
+
+			freeBatches.put(batch);
 		}
 	}
 
@@ -814,156 +1223,165 @@ namespace sw
 		sync->unlock();
 	}
 
-	void Renderer::finishRendering(Task &pixelTask)
+	void Renderer::finishRendering(DrawCall &draw)
 	{
-		int unit = pixelTask.primitiveUnit;
-		int cluster = pixelTask.pixelCluster;
-
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
 		DrawData &data = *draw.data;
-		int primitive = primitiveProgress[unit].firstPrimitive;
-		int count = primitiveProgress[unit].primitiveCount;
-		int processedPrimitives = primitive + count;
-
-		pixelProgress[cluster].processedPrimitives = processedPrimitives;
-
-		if(pixelProgress[cluster].processedPrimitives >= draw.count)
-		{
-			++pixelProgress[cluster].drawCall; // Atomic
-			pixelProgress[cluster].processedPrimitives = 0;
-		}
 
-		int ref = primitiveProgress[unit].references--; // Atomic
+		#if PERF_PROFILE
+			for(int cluster = 0; cluster < clusterCount; cluster++)
+			{
+				for(int i = 0; i < PERF_TIMERS; i++)
+				{
+					profiler.cycles[i] += data.cycles[i][cluster];
+				}
+			}
+		#endif
 
-		if(ref == 0)
+		if(draw.queries)
 		{
-			ref = draw.references--; // Atomic
-
-			if(ref == 0)
+			for(auto &query : *(draw.queries))
 			{
-				#if PERF_PROFILE
+				switch(query->getType())
+				{
+				case VK_QUERY_TYPE_OCCLUSION:
 					for(int cluster = 0; cluster < clusterCount; cluster++)
 					{
-						for(int i = 0; i < PERF_TIMERS; i++)
-						{
-							profiler.cycles[i] += data.cycles[i][cluster];
-						}
+						query->add(data.occlusion[cluster]);
 					}
-				#endif
-
-				if(draw.queries)
-				{
-					for(auto &query : *(draw.queries))
+					break;
+				case VK_QUERY_TYPE_PIPELINE_STATISTICS:
+					if(draw.statisticsEnabled)
 					{
-						switch(query->getType())
+						int64_t fragmentInvocations = 0;
+						for(int cluster = 0; cluster < clusterCount; cluster++)
 						{
-						case VK_QUERY_TYPE_OCCLUSION:
-							for(int cluster = 0; cluster < clusterCount; cluster++)
-							{
-								query->add(data.occlusion[cluster]);
-							}
-							break;
-						default:
-							break;
+							fragmentInvocations += data.fragmentInvocations[cluster];
 						}
 
-						query->finish();
+						query->addStatistic(VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT, draw.assemblyVertices);
+						query->addStatistic(VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT, draw.assemblyPrimitives);
+						query->addStatistic(VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT, draw.vertexInvocations);
+						query->addStatistic(VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT, draw.clippingInvocations);
+						query->addStatistic(VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT, draw.clippingPrimitives);
+						query->addStatistic(VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT, fragmentInvocations);
 					}
-
-					delete draw.queries;
-					draw.queries = nullptr;
+					break;
+				default:
+					break;
 				}
 
-				draw.vertexRoutine->unbind();
-				draw.setupRoutine->unbind();
-				draw.pixelRoutine->unbind();
+				query->finish();
+			}
 
-				if(draw.events)
-				{
-					draw.events->finish();
-					draw.events = nullptr;
-				}
+			delete draw.queries;
+			draw.queries = nullptr;
+		}
 
-				sync->unlock();
+		draw.vertexRoutine->unbind();
+		draw.setupRoutine->unbind();
+		draw.pixelRoutine->unbind();
 
-				draw.references = -1;
-				resumeApp->signal();
-			}
+		if(draw.events)
+		{
+			draw.events->finish();
+			draw.events = nullptr;
 		}
 
-		pixelProgress[cluster].executing = false;
+		sync->unlock();
+
+		draw.references = -1;
+		resumeApp->signal();
 	}
 
-	void Renderer::processPrimitiveVertices(int unit, unsigned int start, unsigned int triangleCount, unsigned int loop, int thread)
+	void Renderer::processPrimitiveVertices(BatchData *batch)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		int primitiveDrawCall = primitiveProgress[unit].drawCall;
-		DrawCall *draw = drawList[primitiveDrawCall & DRAW_COUNT_BITS];
+		Triangle *triangle = batch->triangles;
+		DrawCall *draw = batch->draw;
 		DrawData *data = draw->data;
-		VertexTask *task = vertexTask[thread];
+		VertexTask *task = batch->vertexTask;
+		unsigned int start = batch->firstPrimitive;
+		unsigned int triangleCount = batch->numPrimitives;
 
 		const void *indices = data->indices;
 		VertexProcessor::RoutinePointer vertexRoutine = draw->vertexPointer;
 
-		if(task->vertexCache.drawCall != primitiveDrawCall)
-		{
-			task->vertexCache.clear();
-			task->vertexCache.drawCall = primitiveDrawCall;
-		}
-
-		unsigned int batch[128][3];   // FIXME: Adjust to dynamic batch size
+		unsigned int triangleIndices[128][3];   // FIXME: Adjust to dynamic batch size
+		unsigned int triangleInstances[128];
 		VkPrimitiveTopology topology = static_cast<VkPrimitiveTopology>(static_cast<int>(draw->topology));
+		VkIndexType indexType = static_cast<VkIndexType>(static_cast<int>(draw->indexType));
 
-		if(!indices)
+		// A batch can span several instances. Assemble each instance's run of
+		// primitives separately.
+		for(unsigned int i = 0; i < triangleCount;)
 		{
-			struct LinearIndex
-			{
-				unsigned int operator[](unsigned int i) { return i; }
-			};
+			unsigned int instance = (start + i) / draw->instancePrimitives;
+			unsigned int first = (start + i) % draw->instancePrimitives;
+			unsigned int count = std::min(triangleCount - i, draw->instancePrimitives - first);
 
-			if(!setBatchIndices(batch, topology, LinearIndex(), start, triangleCount))
+			if(!setBatchIndices(triangleIndices + i, topology, indexType, indices, first, count))
 			{
 				return;
 			}
-		}
-		else
-		{
-			switch(draw->indexType)
+
+			for(unsigned int j = i; j < i + count; j++)
 			{
-			case VK_INDEX_TYPE_UINT16:
-				if(!setBatchIndices(batch, topology, static_cast<const uint16_t*>(indices), start, triangleCount))
-				{
-					return;
-				}
-				break;
-			case VK_INDEX_TYPE_UINT32:
-				if(!setBatchIndices(batch, topology, static_cast<const uint32_t*>(indices), start, triangleCount))
-				{
-					return;
-				}
-				break;
-			break;
-			default:
-				ASSERT(false);
-				return;
+				triangleInstances[j] = instance;
 			}
+
+			i += count;
 		}
 
 		task->primitiveStart = start;
 		task->vertexCount = triangleCount * 3;
-		vertexRoutine(&triangle->v0, (unsigned int*)&batch, task, data);
+
+		unsigned int uniqueCount = setBatchVertices(task, &triangleIndices[0][0], triangleInstances, task->vertexCount);
+		shadedVertexCount += uniqueCount;
+		shadedPrimitiveCount += triangleCount;
+
+		if(draw->statisticsEnabled)
+		{
+			draw->vertexInvocations += uniqueCount;
+		}
+
+		vertexRoutine(&triangle->v0, task->indices, task, data);
+	}
+
+	int64_t Renderer::getShadedVertexCount() const
+	{
+		return shadedVertexCount;
+	}
+
+	int64_t Renderer::getShadedPrimitiveCount() const
+	{
+		return shadedPrimitiveCount;
+	}
+
+	void Renderer::resetShadingCounts()
+	{
+		shadedVertexCount = 0;
+		shadedPrimitiveCount = 0;
+	}
+
+	int64_t Renderer::getCoarseDepthTestCount() const
+	{
+		return coarseDepthTestCount;
+	}
+
+	int64_t Renderer::getCoarseDepthCullCount() const
+	{
+		return coarseDepthCullCount;
 	}
 
-	int Renderer::setupTriangles(int unit, int count)
+	int Renderer::setupTriangles(BatchData *batch)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		Primitive *primitive = primitiveBatch[unit];
+		Triangle *triangle = batch->triangles;
+		Primitive *primitive = batch->primitives;
+		int count = batch->numPrimitives;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-		SetupProcessor::State &state = draw.setupState;
+		DrawCall &draw = *batch->draw;
 		const SetupProcessor::RoutinePointer &setupRoutine = draw.setupPointer;
 
-		int ms = state.multiSample;
+		int stride = draw.primitiveStride;
 		const DrawData *data = draw.data;
 		int visible = 0;
 
@@ -989,7 +1407,7 @@ namespace sw
 
 				if(setupRoutine(primitive, triangle, &polygon, data))
 				{
-					primitive += ms;
+					primitive = reinterpret_cast<Primitive*>(reinterpret_cast<char*>(primitive) + stride);
 					visible++;
 				}
 			}
@@ -998,22 +1416,21 @@ namespace sw
 		return visible;
 	}
 
-	int Renderer::setupLines(int unit, int count)
+	int Renderer::setupLines(BatchData *batch)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		Primitive *primitive = primitiveBatch[unit];
+		Triangle *triangle = batch->triangles;
+		Primitive *primitive = batch->primitives;
+		int count = batch->numPrimitives;
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-		SetupProcessor::State &state = draw.setupState;
-
-		int ms = state.multiSample;
+		DrawCall &draw = *batch->draw;
+		int stride = draw.primitiveStride;
 
 		for(int i = 0; i < count; i++)
 		{
 			if(setupLine(*primitive, *triangle, draw))
 			{
-				primitive += ms;
+				primitive = reinterpret_cast<Primitive*>(reinterpret_cast<char*>(primitive) + stride);
 				visible++;
 			}
 
@@ -1023,22 +1440,21 @@ namespace sw
 		return visible;
 	}
 
-	int Renderer::setupPoints(int unit, int count)
+	int Renderer::setupPoints(BatchData *batch)
 	{
-		Triangle *triangle = triangleBatch[unit];
-		Primitive *primitive = primitiveBatch[unit];
+		Triangle *triangle = batch->triangles;
+		Primitive *primitive = batch->primitives;
+		int count = batch->numPrimitives;
 		int visible = 0;
 
-		DrawCall &draw = *drawList[primitiveProgress[unit].drawCall & DRAW_COUNT_BITS];
-		SetupProcessor::State &state = draw.setupState;
-
-		int ms = state.multiSample;
+		DrawCall &draw = *batch->draw;
+		int stride = draw.primitiveStride;
 
 		for(int i = 0; i < count; i++)
 		{
 			if(setupPoint(*primitive, *triangle, draw))
 			{
-				primitive += ms;
+				primitive = reinterpret_cast<Primitive*>(reinterpret_cast<char*>(primitive) + stride);
 				visible++;
 			}
 
@@ -1308,72 +1724,82 @@ namespace sw
 
 	void Renderer::initializeThreads()
 	{
-		unitCount = ceilPow2(threadCount);
-		clusterCount = ceilPow2(threadCount);
+		// Neither count has to be a power of two. Each cluster rasterizes
+		// every clusterCount-th pair of scanlines.
+		unitCount = threadCount;
+		clusterCount = threadCount;
 
-		for(int i = 0; i < unitCount; i++)
-		{
-			triangleBatch[i] = (Triangle*)allocate(batchSize * sizeof(Triangle));
-			primitiveBatch[i] = (Primitive*)allocate(batchSize * sizeof(Primitive));
-		}
+		clusterQueues.resize(clusterCount);
+		outlines = (Outline*)allocate(clusterCount * 4 * sizeof(Outline));
 
-		for(int i = 0; i < threadCount; i++)
+		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
-			vertexTask[i] = (VertexTask*)allocate(sizeof(VertexTask));
-			vertexTask[i]->vertexCache.drawCall = -1;
+			DrawData *data = drawCall[draw]->data;
+			data->occlusion = (unsigned int*)allocate(clusterCount * sizeof(unsigned int));
+			data->fragmentInvocations = (unsigned int*)allocate(clusterCount * sizeof(unsigned int));
+			data->outline = outlines;
 
-			task[i].type = Task::SUSPEND;
-
-			resume[i] = new Event();
-			suspend[i] = new Event();
-
-			Parameters parameters;
-			parameters.threadIndex = i;
-			parameters.renderer = this;
+			#if PERF_PROFILE
+				for(int i = 0; i < PERF_TIMERS; i++)
+				{
+					data->cycles[i] = (int64_t*)allocate(clusterCount * sizeof(int64_t));
+				}
+			#endif
+		}
 
-			exitThreads = false;
-			worker[i] = new std::thread(threadFunction, &parameters);
+		for(int i = 0; i < unitCount; i++)
+		{
+			BatchData *batch = new BatchData();
+			batch->triangles = (Triangle*)allocate(batchSize * sizeof(Triangle));
+			batch->primitives = (Primitive*)allocate(batchSize * sizeof(Primitive));
+			batch->vertexTask = (VertexTask*)allocate(sizeof(VertexTask));
+			batch->clusterTickets.resize(clusterCount);
+			batch->clusterBins.resize(clusterCount);
 
-			suspend[i]->wait();
-			suspend[i]->signal();
+			batches.push_back(batch);
+			freeBatches.put(batch);
 		}
 	}
 
 	void Renderer::terminateThreads()
 	{
-		while(threadsAwake != 0)
+		// Wait for all the batches to be released by the pipeline.
+		for(size_t i = 0; i < batches.size(); i++)
 		{
-			std::this_thread::yield();
+			freeBatches.take();
 		}
 
-		for(int thread = 0; thread < threadCount; thread++)
+		for(auto batch : batches)
 		{
-			if(worker[thread])
-			{
-				exitThreads = true;
-				resume[thread]->signal();
-				worker[thread]->join();
-
-				delete worker[thread];
-				worker[thread] = 0;
-				delete resume[thread];
-				resume[thread] = 0;
-				delete suspend[thread];
-				suspend[thread] = 0;
-			}
-
-			deallocate(vertexTask[thread]);
-			vertexTask[thread] = 0;
+			deallocate(batch->triangles);
+			deallocate(batch->primitives);
+			deallocate(batch->vertexTask);
+			delete batch;
 		}
 
-		for(int i = 0; i < 16; i++)
+		batches.clear();
+
+		for(int draw = 0; draw < DRAW_COUNT; draw++)
 		{
-			deallocate(triangleBatch[i]);
-			triangleBatch[i] = 0;
+			DrawData *data = drawCall[draw]->data;
+			deallocate(data->occlusion);
+			data->occlusion = nullptr;
+			deallocate(data->fragmentInvocations);
+			data->fragmentInvocations = nullptr;
+			data->outline = nullptr;
 
-			deallocate(primitiveBatch[i]);
-			primitiveBatch[i] = 0;
+			#if PERF_PROFILE
+				for(int i = 0; i < PERF_TIMERS; i++)
+				{
+					deallocate(data->cycles[i]);
+					data->cycles[i] = nullptr;
+				}
+			#endif
 		}
+
+		clusterQueues.clear();
+		deallocate(outlines);
+		outlines = nullptr;
 	}
 
 	void Renderer::addQuery(vk::Query *query)
@@ -1386,6 +1812,17 @@ namespace sw
 		queries.remove(query);
 	}
 
+	void Renderer::addComputeInvocations(int64_t invocations)
+	{
+		for(auto query : queries)
+		{
+			if(query->getType() == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+			{
+				query->addStatistic(VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT, invocations);
+			}
+		}
+	}
+
 	void Renderer::advanceInstanceAttributes(Stream* inputs)
 	{
 		for(uint32_t i = 0; i < vk::MAX_VERTEX_INPUT_BINDINGS; i++)
@@ -1402,31 +1839,31 @@ namespace sw
 	#if PERF_HUD
 		int Renderer::getThreadCount()
 		{
-			return threadCount;
+			return ThreadPool::get().getThreadCount();
 		}
 
-		int64_t Renderer::getVertexTime(int thread)
+		int64_t Renderer::getStageTime(Stage stage)
 		{
-			return vertexTime[thread];
+			return stageTime[stage];
 		}
 
-		int64_t Renderer::getSetupTime(int thread)
+		int64_t Renderer::getQueueLatency(Stage stage)
 		{
-			return setupTime[thread];
+			return queueLatency[stage];
 		}
 
-		int64_t Renderer::getPixelTime(int thread)
+		int64_t Renderer::getTaskCount(Stage stage)
 		{
-			return pixelTime[thread];
+			return taskCount[stage];
 		}
 
 		void Renderer::resetTimers()
 		{
-			for(int thread = 0; thread < threadCount; thread++)
+			for(int stage = 0; stage < STAGE_COUNT; stage++)
 			{
-				vertexTime[thread] = 0;
-				setupTime[thread] = 0;
-				pixelTime[thread] = 0;
+				stageTime[stage] = 0;
+				queueLatency[stage] = 0;
+				taskCount[stage] = 0;
 			}
 		}
 	#endif
@@ -1529,6 +1966,7 @@ namespace sw
 			postBlendSRGB = configuration.postBlendSRGB;
 			exactColorRounding = configuration.exactColorRounding;
 			forceClearRegisters = configuration.forceClearRegisters;
+			tileBinning = configuration.tileBinning;
 
 		#ifndef NDEBUG
 			minPrimitives = configuration.minPrimitives;
@@ -1536,7 +1974,7 @@ namespace sw
 		#endif
 		}
 
-		if(!initialUpdate && !worker[0])
+		if(!initialUpdate && batches.empty())
 		{
 			initializeThreads();
 		}
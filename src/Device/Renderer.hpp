@@ -23,11 +23,12 @@
 #include "Device/Config.hpp"
 #include "System/Synchronization.hpp"
 #include "System/Thread.hpp"
+#include "System/ThreadPool.hpp"
 #include "Vulkan/VkDescriptorSet.hpp"
 
+#include <atomic>
 #include <list>
-#include <mutex>
-#include <thread>
+#include <vector>
 
 namespace vk
 {
@@ -38,6 +39,10 @@ namespace vk
 namespace sw
 {
 	struct DrawCall;
+	struct BatchData;
+	struct Primitive;
+	class CoarseDepth;
+	struct Outline;
 	class PixelShader;
 	class VertexShader;
 	class SwiftConfig;
@@ -93,18 +98,21 @@ namespace sw
 
 		const void *input[MAX_VERTEX_INPUTS];
 		unsigned int stride[MAX_VERTEX_INPUTS];
+		unsigned int instanceStride[MAX_VERTEX_INPUTS];
 		const void *indices;
 
-		int instanceID;
+		int firstInstance;
 		int baseVertex;
 		float lineWidth;
 
 		PixelProcessor::Stencil stencil[2];   // clockwise, counterclockwise
 		PixelProcessor::Factor factor;
-		unsigned int occlusion[16];   // Number of pixels passing depth test
+		unsigned int *occlusion;   // Number of pixels passing depth test, per cluster
+		unsigned int *fragmentInvocations;   // Number of pixels shaded, per cluster, when gathering pipeline statistics
+		Outline *outline;   // Scratch outline of each sample, per cluster
 
 		#if PERF_PROFILE
-			int64_t cycles[PERF_TIMERS][16];
+			int64_t *cycles[PERF_TIMERS];   // Per cluster
 		#endif
 
 		float4 Wx16;
@@ -144,54 +152,6 @@ namespace sw
 
 	class Renderer : public VertexProcessor, public PixelProcessor, public SetupProcessor
 	{
-		struct Task
-		{
-			enum Type
-			{
-				PRIMITIVES,
-				PIXELS,
-
-				RESUME,
-				SUSPEND
-			};
-
-			AtomicInt type;
-			AtomicInt primitiveUnit;
-			AtomicInt pixelCluster;
-		};
-
-		struct PrimitiveProgress
-		{
-			void init()
-			{
-				drawCall = 0;
-				firstPrimitive = 0;
-				primitiveCount = 0;
-				visible = 0;
-				references = 0;
-			}
-
-			AtomicInt drawCall;
-			AtomicInt firstPrimitive;
-			AtomicInt primitiveCount;
-			AtomicInt visible;
-			AtomicInt references;
-		};
-
-		struct PixelProgress
-		{
-			void init()
-			{
-				drawCall = 0;
-				processedPrimitives = 0;
-				executing = false;
-			}
-
-			AtomicInt drawCall;
-			AtomicInt processedPrimitives;
-			AtomicInt executing;
-		};
-
 	public:
 		Renderer(Conventions conventions, bool exactColorRounding);
 
@@ -202,7 +162,9 @@ namespace sw
 
 		bool hasQueryOfType(VkQueryType type) const;
 
-		void draw(const sw::Context* context, VkIndexType indexType, unsigned int count, int baseVertex, TaskEvents *events, bool update = true);
+		// Draws count primitives for each of instanceCount instances, starting
+		// with context->instanceID.
+		void draw(const sw::Context* context, VkIndexType indexType, unsigned int count, unsigned int instanceCount, int baseVertex, TaskEvents *events, bool update = true);
 
 		// Viewport & Clipper
 		void setViewport(const VkViewport &viewport);
@@ -211,35 +173,67 @@ namespace sw
 		void addQuery(vk::Query *query);
 		void removeQuery(vk::Query *query);
 
+		// Adds the invocations of a compute dispatch to the active pipeline
+		// statistics queries.
+		void addComputeInvocations(int64_t invocations);
+
 		void advanceInstanceAttributes(Stream* inputs);
 
 		void synchronize();
 
 		#if PERF_HUD
-			// Performance timers
+			enum Stage
+			{
+				VERTEX_STAGE,
+				SETUP_STAGE,
+				PIXEL_STAGE,
+
+				STAGE_COUNT
+			};
+
+			// Performance timers, in ticks summed over all the tasks of each
+			// stage. Queue latency is the time from a task being scheduled
+			// until it starts executing.
 			int getThreadCount();
-			int64_t getVertexTime(int thread);
-			int64_t getSetupTime(int thread);
-			int64_t getPixelTime(int thread);
+			int64_t getStageTime(Stage stage);
+			int64_t getQueueLatency(Stage stage);
+			int64_t getTaskCount(Stage stage);
 			void resetTimers();
 		#endif
 
 		static int getClusterCount() { return clusterCount; }
 
+		// Vertex shading totals over the renderer's draw calls, since it was
+		// created or they were last reset. Vertices referenced by several
+		// primitives of a batch are shaded once.
+		int64_t getShadedVertexCount() const;
+		int64_t getShadedPrimitiveCount() const;
+		void resetShadingCounts();
+
+		// Coarse depth culling totals over the renderer's draw calls. Primitives
+		// are culled when they're behind the coarse depth bounds of every pixel
+		// they overlap, or with tile binning, of every tile they overlap.
+		int64_t getCoarseDepthTestCount() const;
+		int64_t getCoarseDepthCullCount() const;
+
 	private:
-		static void threadFunction(void *parameters);
-		void threadLoop(int threadIndex);
-		void taskLoop(int threadIndex);
-		void findAvailableTasks();
-		void scheduleTask(int threadIndex);
-		void executeTask(int threadIndex);
-		void finishRendering(Task &pixelTask);
+		void schedule(ThreadPool::Task &&task);
+
+		void processVertices(BatchData *batch);
+		void processPrimitives(BatchData *batch);
+		void binPrimitives(BatchData *batch);
+		void cullOccludedPrimitives(BatchData *batch);
+		void findCoveredTiles(BatchData *batch);
+		void processPixels(BatchData *batch);
+		void rasterize(BatchData *batch, int cluster);
+		void finishCluster(BatchData *batch);
+		void finishRendering(DrawCall &draw);
 
-		void processPrimitiveVertices(int unit, unsigned int start, unsigned int count, unsigned int loop, int thread);
+		void processPrimitiveVertices(BatchData *batch);
 
-		int setupTriangles(int batch, int count);
-		int setupLines(int batch, int count);
-		int setupPoints(int batch, int count);
+		int setupTriangles(BatchData *batch);
+		int setupLines(BatchData *batch);
+		int setupPoints(BatchData *batch);
 
 		bool setupLine(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
 		bool setupPoint(Primitive &primitive, Triangle &triangle, const DrawCall &draw);
@@ -252,50 +246,33 @@ namespace sw
 		VkRect2D scissor;
 		int clipFlags;
 
-		Triangle *triangleBatch[16];
-		Primitive *primitiveBatch[16];
-
-		AtomicInt exitThreads;
-		AtomicInt threadsAwake;
-		std::thread *worker[16];
-		Event *resume[16];         // Events for resuming threads
-		Event *suspend[16];        // Events for suspending threads
+		std::vector<BatchData*> batches;
+		Chan<BatchData*> freeBatches;   // Batches not in use by any draw call
+		std::vector<Ticket::Queue> clusterQueues;   // Per cluster
+		Outline *outlines;   // Per cluster, one for each sample
 		Event *resumeApp;          // Event for resuming the application thread
 
-		PrimitiveProgress primitiveProgress[16];
-		PixelProgress pixelProgress[16];
-		Task task[16];   // Current tasks for threads
-
 		enum {
 			DRAW_COUNT = 16,   // Number of draw calls buffered (must be power of 2)
 			DRAW_COUNT_BITS = DRAW_COUNT - 1,
 		};
 		DrawCall *drawCall[DRAW_COUNT];
-		DrawCall *drawList[DRAW_COUNT];
 
-		AtomicInt currentDraw;
-		AtomicInt nextDraw;
-
-		enum {
-			TASK_COUNT = 32,   // Size of the task queue (must be power of 2)
-			TASK_COUNT_BITS = TASK_COUNT - 1,
-		};
-		Task taskQueue[TASK_COUNT];
-		AtomicInt qHead;
-		AtomicInt qSize;
+		int nextDrawID;
 
 		static AtomicInt unitCount;
 		static AtomicInt clusterCount;
 
-		std::mutex schedulerMutex;
-
 		#if PERF_HUD
-			int64_t vertexTime[16];
-			int64_t setupTime[16];
-			int64_t pixelTime[16];
+			std::atomic<int64_t> stageTime[STAGE_COUNT];
+			std::atomic<int64_t> queueLatency[STAGE_COUNT];
+			std::atomic<int64_t> taskCount[STAGE_COUNT];
 		#endif
 
-		VertexTask *vertexTask[16];
+		std::atomic<int64_t> shadedVertexCount;
+		std::atomic<int64_t> shadedPrimitiveCount;
+		std::atomic<int64_t> coarseDepthTestCount;
+		std::atomic<int64_t> coarseDepthCullCount;
 
 		SwiftConfig *swiftConfig;
 
@@ -329,22 +306,66 @@ namespace sw
 		SetupProcessor::RoutinePointer setupPointer;
 		PixelProcessor::RoutinePointer pixelPointer;
 
-		int (Renderer::*setupPrimitives)(int batch, int count);
+		int (Renderer::*setupPrimitives)(BatchData *batch);
 		SetupProcessor::State setupState;
+		int primitiveStride;   // Primitives only hold the plane equations of the used interpolants
 
 		vk::ImageView *renderTarget[RENDERTARGETS];
 		vk::ImageView *depthBuffer;
 		vk::ImageView *stencilBuffer;
 		TaskEvents *events;
 
+		CoarseDepth *coarseDepth;   // Coarse depth bounds of the depth buffer, if it has them
+		bool coarseDepthCull;       // Primitives behind the bounds are culled
+		bool coarseDepthLower;      // Bounds of the tiles primitives write entirely are lowered
+		bool depthClamp;
+		bool tileBinning;           // Primitives are binned into tiles, as the pixel routine expects
+
 		std::list<vk::Query*> *queries;
 
-		AtomicInt primitive;    // Current primitive to enter pipeline
-		AtomicInt count;        // Number of primitives to render
-		AtomicInt references;   // Remaining references to this draw call, 0 when done drawing, -1 when resources unlocked and slot is free
+		// Pipeline statistics, only gathered while a query needs them. The
+		// fragment shader invocations are counted per cluster in DrawData.
+		bool statisticsEnabled;
+		int64_t assemblyVertices;
+		int64_t assemblyPrimitives;
+		std::atomic<int64_t> vertexInvocations;
+		std::atomic<int64_t> clippingInvocations;
+		std::atomic<int64_t> clippingPrimitives;
+
+		int id;                 // Sequence number of the draw call, used for vertex caching
+		AtomicInt count;        // Number of primitives to render, over all instances
+		unsigned int instancePrimitives;   // Number of primitives of each instance
+		AtomicInt references;   // Remaining batches of this draw call, 0 when done drawing, -1 when resources unlocked and slot is free
 
 		DrawData *data;
 	};
+
+	// BatchData holds a batch of primitives of a draw call, from vertex
+	// processing until it has been rasterized by every pixel cluster.
+	struct BatchData
+	{
+		Triangle *triangles;
+		Primitive *primitives;
+		VertexTask *vertexTask;
+
+		DrawCall *draw;
+		unsigned int firstPrimitive;
+		unsigned int numPrimitives;
+		int numVisible;
+
+		std::vector<Ticket> clusterTickets;   // Orders the rasterization of batches by each cluster
+		std::vector<std::vector<unsigned int>> clusterBins;   // Tiles of each cluster overlapped by each primitive, when tile binning
+
+		struct CoveredTile
+		{
+			int x;
+			int y;
+			float depth;   // Maximum depth written to the tile
+		};
+
+		std::vector<CoveredTile> coveredTiles;   // Coarse depth tiles written entirely by the batch's primitives
+		AtomicInt clustersRemaining;
+	};
 }
 
 #endif   // sw_Renderer_hpp
@@ -23,8 +23,8 @@ namespace sw
 {
 	using namespace rr;
 
-	template<class State>
-	using RoutineCache = LRUCache<State, Routine>;
+	template<class State, class Hash = KeyHash<State>>
+	using RoutineCache = LRUCache<State, Routine, Hash>;
 }
 
 #endif   // sw_RoutineCache_hpp
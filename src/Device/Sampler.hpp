@@ -153,6 +153,7 @@ namespace sw
 		VkBorderColor border;
 		bool unnormalizedCoordinates;
 		bool largeTexture;
+		bool tiled;          // Texels are stored in 4x4 tiles
 
 		VkSamplerYcbcrModelConversion ycbcrModel;
 		bool studioSwing;    // Narrow range
@@ -89,12 +89,9 @@ namespace sw
 		state.multiSample = context->sampleCount;
 		state.rasterizerDiscard = context->rasterizerDiscard;
 
-		if (context->pixelShader)
+		for (int interpolant = 0; interpolant < MAX_INTERFACE_COMPONENTS; interpolant++)
 		{
-			for (int interpolant = 0; interpolant < MAX_INTERFACE_COMPONENTS; interpolant++)
-			{
-				state.gradient[interpolant] = context->pixelShader->inputs[interpolant];
-			}
+			state.gradient[interpolant] = context->pixelShader ? context->pixelShader->inputs[interpolant] : SpirvShader::InterfaceComponent();
 		}
 
 		state.hash = state.computeHash();
@@ -113,7 +110,7 @@ namespace sw
 			routine = generator->getRoutine();
 			delete generator;
 
-			routineCache->add(state, routine);
+			routine = routineCache->add(state, routine);
 		}
 
 		return routine;
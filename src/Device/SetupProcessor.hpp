@@ -69,6 +69,8 @@ namespace sw
 
 	protected:
 		State update(const sw::Context* context) const;
+
+		// Returns the routine bound for the caller, which must unbind() it.
 		Routine *routine(const State &state);
 
 		void setRoutineCacheSize(int cacheSize);
@@ -46,6 +46,7 @@ namespace sw
 			int mipmapQuality;
 			int transcendentalPrecision;
 			int threadCount;
+			bool tileBinning;
 			bool enableSSE;
 			bool enableSSE2;
 			bool enableSSE3;
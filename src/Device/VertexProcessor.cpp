@@ -25,14 +25,6 @@ namespace sw
 {
 	bool precacheVertex = false;
 
-	void VertexCache::clear()
-	{
-		for(int i = 0; i < 16; i++)
-		{
-			tag[i] = 0x80000000;
-		}
-	}
-
 	unsigned int VertexProcessor::States::computeHash()
 	{
 		unsigned int *state = (unsigned int*)this;
@@ -127,14 +119,28 @@ namespace sw
 
 		if(!routine)   // Create one
 		{
-			VertexRoutine *generator = new VertexProgram(state, pipelineLayout, vertexShader, descriptorSets);
-			generator->generate();
-			routine = (*generator)("VertexRoutine_%0.8X", state.shaderID);
-			delete generator;
-
-			routineCache->add(state, routine);
+			routine = generate(state, pipelineLayout, vertexShader, descriptorSets);
+			routine = routineCache->add(state, routine);
 		}
 
 		return routine;
 	}
+
+	Routine *VertexProcessor::generate(const State &state,
+	                                   vk::PipelineLayout const *pipelineLayout,
+	                                   SpirvShader const *vertexShader,
+	                                   const vk::DescriptorSet::Bindings &descriptorSets)
+	{
+		VertexRoutine *generator = new VertexProgram(state, pipelineLayout, vertexShader, descriptorSets);
+		generator->generate();
+		Routine *routine = (*generator)("VertexRoutine_%0.8X", state.shaderID);
+		delete generator;
+
+		return routine;
+	}
+
+	void VertexProcessor::addRoutine(const State &state, Routine *routine)
+	{
+		routineCache->add(state, routine)->unbind();
+	}
 }
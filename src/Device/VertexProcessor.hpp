@@ -24,21 +24,25 @@ namespace sw
 {
 	struct DrawData;
 
-	struct VertexCache   // FIXME: Variable size
-	{
-		void clear();
-
-		Vertex vertex[16][4];
-		unsigned int tag[16];
-
-		int drawCall;
-	};
-
+	// VertexTask describes the vertices of a batch of primitives. Each unique
+	// vertex index is shaded once, into the first primitive vertex which
+	// references it, and the other primitive vertices are copied from there.
 	struct VertexTask
 	{
-		unsigned int vertexCount;
+		enum
+		{
+			MAX_VERTICES = 3 * 128,                  // Three per primitive of a batch
+			MAX_UNIQUE_VERTICES = MAX_VERTICES + 3,  // Padded to a multiple of four
+		};
+
+		unsigned int vertexCount;    // Number of primitive vertices
 		unsigned int primitiveStart;
-		VertexCache vertexCache;
+		unsigned int uniqueCount;    // Number of unique vertices, padded to a multiple of four
+
+		unsigned int indices[MAX_UNIQUE_VERTICES];   // Vertex index of each unique vertex
+		unsigned int instances[MAX_UNIQUE_VERTICES]; // Instance of each unique vertex, from the draw's first one
+		unsigned int slots[MAX_UNIQUE_VERTICES];     // Primitive vertex each unique vertex is shaded into
+		unsigned int sources[MAX_VERTICES];          // Primitive vertex each primitive vertex is copied from
 	};
 
 	class VertexProcessor
@@ -84,8 +88,20 @@ namespace sw
 
 		virtual ~VertexProcessor();
 
+		// Only reads pipeline state, so that pipelines can generate the
+		// routine used by draw calls at creation.
+		static const State update(const sw::Context* context);
+
+		// Generates a routine without going through the cache, so pipelines
+		// can build their routines before the first draw call.
+		static Routine *generate(const State &state, vk::PipelineLayout const *pipelineLayout,
+		                         SpirvShader const *vertexShader, const vk::DescriptorSet::Bindings &descriptorSets);
+
+		// Makes a routine built by generate() available to draw calls.
+		void addRoutine(const State &state, Routine *routine);
+
 	protected:
-		const State update(const sw::Context* context);
+		// Returns the routine bound for the caller, which must unbind() it.
 		Routine *routine(const State &state, vk::PipelineLayout const *pipelineLayout,
 		                 SpirvShader const *vertexShader, const vk::DescriptorSet::Bindings &descriptorSets);
 
@@ -15,9 +15,13 @@
 #include "ComputeProgram.hpp"
 #include "Constants.hpp"
 
+#include "System/Synchronization.hpp"
+#include "System/ThreadPool.hpp"
 #include "Vulkan/VkDebug.hpp"
 #include "Vulkan/VkPipelineLayout.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <queue>
 
 namespace
@@ -95,14 +99,14 @@ namespace sw
 		setInputBuiltin(routine, spv::BuiltInSubgroupLocalInvocationId, [&](const SpirvShader::BuiltinMapping& builtin, Array<SIMD::Float>& value)
 		{
 			ASSERT(builtin.SizeInComponents == 1);
-			value[builtin.FirstComponent] = As<SIMD::Float>(SIMD::Int(0, 1, 2, 3));
+			value[builtin.FirstComponent] = As<SIMD::Float>(SIMD::LaneIndices());
 		});
 
 		setInputBuiltin(routine, spv::BuiltInDeviceIndex, [&](const SpirvShader::BuiltinMapping& builtin, Array<SIMD::Float>& value)
 		{
 			ASSERT(builtin.SizeInComponents == 1);
 			// Only a single physical device is supported.
-			value[builtin.FirstComponent] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
+			value[builtin.FirstComponent] = As<SIMD::Float>(SIMD::Int(0));
 		});
 	}
 
@@ -185,8 +189,7 @@ namespace sw
 		{
 			auto subgroupIndex = firstSubgroup + i;
 
-			// TODO: Replace SIMD::Int(0, 1, 2, 3) with SIMD-width equivalent
-			auto localInvocationIndex = SIMD::Int(subgroupIndex * SIMD::Width) + SIMD::Int(0, 1, 2, 3);
+			auto localInvocationIndex = SIMD::Int(subgroupIndex * SIMD::Width) + SIMD::LaneIndices();
 
 			// Disable lanes where (invocationIDs >= invocationsPerWorkgroup)
 			auto activeLaneMask = CmpLT(localInvocationIndex, SIMD::Int(invocationsPerWorkgroup));
@@ -220,11 +223,6 @@ namespace sw
 		auto invocationsPerWorkgroup = modes.WorkgroupSizeX * modes.WorkgroupSizeY * modes.WorkgroupSizeZ;
 		auto subgroupsPerWorkgroup = (invocationsPerWorkgroup + invocationsPerSubgroup - 1) / invocationsPerSubgroup;
 
-		// We're sharing a buffer here across all workgroups.
-		// We can only do this because we know a single workgroup is in flight
-		// at any time.
-		std::vector<uint8_t> workgroupMemory(shader->workgroupMemory.size());
-
 		Data data;
 		data.descriptorSets = descriptorSets;
 		data.descriptorDynamicOffsets = descriptorDynamicOffsets;
@@ -242,50 +240,93 @@ namespace sw
 		data.pushConstants = pushConstants;
 		data.constants = &sw::constants;
 
-		for (uint32_t groupZ = baseGroupZ; groupZ < baseGroupZ + groupCountZ; groupZ++)
+		uint32_t groupCount = groupCountX * groupCountY * groupCountZ;
+		if(groupCount == 0)
+		{
+			return;
+		}
+
+		// Workgroups are claimed one at a time from a shared counter by each
+		// batch, so that batches finishing early pick up the remaining work.
+		std::atomic<uint32_t> nextGroup(0);
+
+		auto runBatch = [&]()
+		{
+			// Workgroups of a batch are executed one after the other, so they
+			// can share the workgroup memory.
+			std::vector<uint8_t> workgroupMemory(shader->workgroupMemory.size());
+
+			for(uint32_t groupIndex = nextGroup++; groupIndex < groupCount; groupIndex = nextGroup++)
+			{
+				uint32_t modulo = groupIndex;
+				uint32_t groupOffsetZ = modulo / (groupCountX * groupCountY);
+				modulo -= groupOffsetZ * (groupCountX * groupCountY);
+				uint32_t groupOffsetY = modulo / groupCountX;
+				modulo -= groupOffsetY * groupCountX;
+				uint32_t groupOffsetX = modulo;
+
+				runWorkgroup(data, workgroupMemory.data(),
+				             baseGroupX + groupOffsetX,
+				             baseGroupY + groupOffsetY,
+				             baseGroupZ + groupOffsetZ);
+			}
+		};
+
+		ThreadPool &pool = ThreadPool::get();
+		uint32_t batchCount = std::min(groupCount, static_cast<uint32_t>(pool.getThreadCount()));
+
+		// The calling thread executes the first batch itself, and only waits
+		// for the others once it has run out of workgroups.
+		WaitGroup wg;
+		for(uint32_t batch = 1; batch < batchCount; batch++)
+		{
+			wg.add();
+			pool.schedule([&]()
+			{
+				runBatch();
+				wg.done();
+			});
+		}
+
+		runBatch();
+
+		wg.wait();
+	}
+
+	void ComputeProgram::runWorkgroup(Data &data, void *workgroupMemory, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
+	{
+		using Coroutine = std::unique_ptr<rr::Stream<SpirvShader::YieldResult>>;
+		std::queue<Coroutine> coroutines;
+
+		if(shader->getModes().ContainsControlBarriers)
 		{
-			for (uint32_t groupY = baseGroupY; groupY < baseGroupY + groupCountY; groupY++)
+			// Make a function call per subgroup so each subgroup
+			// can yield, bringing all subgroups to the barrier
+			// together.
+			for(uint32_t subgroupIndex = 0; subgroupIndex < data.subgroupsPerWorkgroup; subgroupIndex++)
 			{
-				for (uint32_t groupX = baseGroupX; groupX < baseGroupX + groupCountX; groupX++)
-				{
-
-					// TODO(bclayton): Split work across threads.
-					using Coroutine = std::unique_ptr<rr::Stream<SpirvShader::YieldResult>>;
-					std::queue<Coroutine> coroutines;
-
-					if (shader->getModes().ContainsControlBarriers)
-					{
-						// Make a function call per subgroup so each subgroup
-						// can yield, bringing all subgroups to the barrier
-						// together.
-						for(int subgroupIndex = 0; subgroupIndex < subgroupsPerWorkgroup; subgroupIndex++)
-						{
-							auto coroutine = (*this)(&data, groupX, groupY, groupZ, workgroupMemory.data(), subgroupIndex, 1);
-							coroutines.push(std::move(coroutine));
-						}
-					}
-					else
-					{
-						auto coroutine = (*this)(&data, groupX, groupY, groupZ, workgroupMemory.data(), 0, subgroupsPerWorkgroup);
-						coroutines.push(std::move(coroutine));
-					}
-
-					while (coroutines.size() > 0)
-					{
-						auto coroutine = std::move(coroutines.front());
-						coroutines.pop();
-
-						SpirvShader::YieldResult result;
-						if (coroutine->await(result))
-						{
-							// TODO: Consider result (when the enum is more than 1 entry).
-							coroutines.push(std::move(coroutine));
-						}
-					}
-
-				} // groupX
-			} // groupY
-		} // groupZ
+				auto coroutine = (*this)(&data, groupX, groupY, groupZ, workgroupMemory, subgroupIndex, 1);
+				coroutines.push(std::move(coroutine));
+			}
+		}
+		else
+		{
+			auto coroutine = (*this)(&data, groupX, groupY, groupZ, workgroupMemory, 0, data.subgroupsPerWorkgroup);
+			coroutines.push(std::move(coroutine));
+		}
+
+		while(coroutines.size() > 0)
+		{
+			auto coroutine = std::move(coroutines.front());
+			coroutines.pop();
+
+			SpirvShader::YieldResult result;
+			if(coroutine->await(result))
+			{
+				// TODO: Consider result (when the enum is more than 1 entry).
+				coroutines.push(std::move(coroutine));
+			}
+		}
 	}
 
 } // namespace sw
@@ -55,6 +55,8 @@ namespace sw
 		void generate();
 
 		// run executes the compute shader routine for all workgroups.
+		// Workgroups are distributed across the threads of the process-wide
+		// sw::ThreadPool, each with its own workgroup memory.
 		void run(
 			vk::DescriptorSet::Bindings const &descriptorSetBindings,
 			vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
@@ -83,6 +85,9 @@ namespace sw
 			const Constants *constants;
 		};
 
+		// runWorkgroup executes all the subgroups of a single workgroup.
+		void runWorkgroup(Data &data, void *workgroupMemory, uint32_t groupX, uint32_t groupY, uint32_t groupZ);
+
 		SpirvShader const * const shader;
 		vk::PipelineLayout const * const pipelineLayout;
 		const vk::DescriptorSet::Bindings &descriptorSets;
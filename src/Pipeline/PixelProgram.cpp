@@ -58,7 +58,7 @@ namespace sw
 		if (it != spirvShader->inputBuiltins.end())
 		{
 			ASSERT(it->second.SizeInComponents == 1);
-			routine.getVariable(it->second.Id)[it->second.FirstComponent] = As<SIMD::Float>(SIMD::Int(0, 1, 2, 3));
+			routine.getVariable(it->second.Id)[it->second.FirstComponent] = As<SIMD::Float>(SIMD::LaneIndices());
 		}
 
 		it = spirvShader->inputBuiltins.find(spv::BuiltInDeviceIndex);
@@ -66,7 +66,7 @@ namespace sw
 		{
 			ASSERT(it->second.SizeInComponents == 1);
 			// Only a single physical device is supported.
-			routine.getVariable(it->second.Id)[it->second.FirstComponent] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
+			routine.getVariable(it->second.Id)[it->second.FirstComponent] = As<SIMD::Float>(SIMD::Int(0));
 		}
 	}
 
@@ -109,6 +109,26 @@ namespace sw
 
 		If(depthPass || Bool(!earlyDepthTest))
 		{
+			if(state.statisticsEnabled && spirvShader)
+			{
+				// Pixels failing early tests don't invoke the fragment shader.
+				Int invocationMask = 0;
+
+				for(unsigned int q = 0; q < state.multiSample; q++)
+				{
+					if(earlyDepthTest)
+					{
+						invocationMask |= zMask[q] & sMask[q];
+					}
+					else
+					{
+						invocationMask |= cMask[q];
+					}
+				}
+
+				fragmentInvocations += *Pointer<UInt>(constants + OFFSET(Constants,occlusionCount) + 4 * invocationMask);
+			}
+
 			#if PERF_PROFILE
 				Long interpTime = Ticks();
 			#endif
@@ -160,14 +180,14 @@ namespace sw
 						{
 							routine.inputs[interpolant] =
 									interpolateCentroid(XXXX, YYYY, rhwCentroid,
-														primitive + OFFSET(Primitive, V[interpolant]),
+														primitive + OFFSET(Primitive, V[plane[interpolant]]),
 														input.Flat, !input.NoPerspective);
 						}
 						else
 						{
 							routine.inputs[interpolant] =
 									interpolate(xxxx, Dv[interpolant], rhw,
-												primitive + OFFSET(Primitive, V[interpolant]),
+												primitive + OFFSET(Primitive, V[plane[interpolant]]),
 												input.Flat, !input.NoPerspective, false);
 						}
 					}
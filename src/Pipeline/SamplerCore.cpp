@@ -872,19 +872,39 @@ namespace sw
 		address(w, z0, z0, fw, mipmap, offset.z, filter, OFFSET(Mipmap, depth), state.addressingModeW, function);
 
 		Int4 pitchP = *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16);
-		y0 *= pitchP;
+		bool point = (state.textureFilter == FILTER_POINT || (function == Fetch));
+		if(state.tiled)
+		{
+			x0 = tiledColumnOffset(x0);
+			y0 = tiledRowOffset(y0, pitchP);
+
+			if(!point)
+			{
+				x1 = tiledColumnOffset(x1);
+				y1 = tiledRowOffset(y1, pitchP);
+			}
+		}
+		else
+		{
+			y0 *= pitchP;
+
+			if(!point)
+			{
+				y1 *= pitchP;
+			}
+		}
+
 		if(state.addressingModeW != ADDRESSING_UNUSED)
 		{
 			z0 *= *Pointer<Int4>(mipmap + OFFSET(Mipmap, sliceP), 16);
 		}
 
-		if(state.textureFilter == FILTER_POINT || (function == Fetch))
+		if(point)
 		{
 			c = sampleTexel(x0, y0, z0, q, mipmap, buffer, function);
 		}
 		else
 		{
-			y1 *= pitchP;
 
 			Vector4f c00 = sampleTexel(x0, y0, z0, q, mipmap, buffer, function);
 			Vector4f c10 = sampleTexel(x1, y0, z0, q, mipmap, buffer, function);
@@ -1256,42 +1276,62 @@ namespace sw
 			                   texelFetch ? ADDRESSING_TEXELFETCH : state.addressingModeV);
 		}
 
-		Short4 uuu2 = uuuu;
-		uuuu = As<Short4>(UnpackLow(uuuu, vvvv));
-		uuu2 = As<Short4>(UnpackHigh(uuu2, vvvv));
-		uuuu = As<Short4>(MulAdd(uuuu, *Pointer<Short4>(mipmap + OFFSET(Mipmap,onePitchP))));
-		uuu2 = As<Short4>(MulAdd(uuu2, *Pointer<Short4>(mipmap + OFFSET(Mipmap,onePitchP))));
+		if(state.tiled)
+		{
+			ASSERT(state.textureType != TEXTURE_3D);
+
+			Int4 uv = tiledColumnOffset(Int4(As<UShort4>(uuuu))) +
+			          tiledRowOffset(Int4(As<UShort4>(vvvv)), *Pointer<Int4>(mipmap + OFFSET(Mipmap, pitchP), 16));
+
+			if(hasThirdCoordinate())
+			{
+				uv += Int4(As<UShort4>(wwww)) * *Pointer<Int4>(mipmap + OFFSET(Mipmap, sliceP));
+			}
 
-		if(hasThirdCoordinate())
+			for(int i = 0; i < 4; i++)
+			{
+				index[i] = Extract(uv, i);
+			}
+		}
+		else
 		{
-			if(state.textureType == TEXTURE_3D)
+			Short4 uuu2 = uuuu;
+			uuuu = As<Short4>(UnpackLow(uuuu, vvvv));
+			uuu2 = As<Short4>(UnpackHigh(uuu2, vvvv));
+			uuuu = As<Short4>(MulAdd(uuuu, *Pointer<Short4>(mipmap + OFFSET(Mipmap,onePitchP))));
+			uuu2 = As<Short4>(MulAdd(uuu2, *Pointer<Short4>(mipmap + OFFSET(Mipmap,onePitchP))));
+
+			if(hasThirdCoordinate())
 			{
-				if(!texelFetch)
+				if(state.textureType == TEXTURE_3D)
 				{
-					wwww = MulHigh(As<UShort4>(wwww), UShort4(*Pointer<Int4>(mipmap + OFFSET(Mipmap, depth))));
-				}
+					if(!texelFetch)
+					{
+						wwww = MulHigh(As<UShort4>(wwww), UShort4(*Pointer<Int4>(mipmap + OFFSET(Mipmap, depth))));
+					}
 
-				if(hasOffset)
-				{
-					wwww = applyOffset(wwww, offset.z, *Pointer<Int4>(mipmap + OFFSET(Mipmap, depth)),
-					                   texelFetch ? ADDRESSING_TEXELFETCH : state.addressingModeW);
+					if(hasOffset)
+					{
+						wwww = applyOffset(wwww, offset.z, *Pointer<Int4>(mipmap + OFFSET(Mipmap, depth)),
+						                   texelFetch ? ADDRESSING_TEXELFETCH : state.addressingModeW);
+					}
 				}
-			}
 
-			UInt4 uv(As<UInt2>(uuuu), As<UInt2>(uuu2));
-			uv += As<UInt4>(Int4(As<UShort4>(wwww))) * *Pointer<UInt4>(mipmap + OFFSET(Mipmap, sliceP));
+				UInt4 uv(As<UInt2>(uuuu), As<UInt2>(uuu2));
+				uv += As<UInt4>(Int4(As<UShort4>(wwww))) * *Pointer<UInt4>(mipmap + OFFSET(Mipmap, sliceP));
 
-			index[0] = Extract(As<Int4>(uv), 0);
-			index[1] = Extract(As<Int4>(uv), 1);
-			index[2] = Extract(As<Int4>(uv), 2);
-			index[3] = Extract(As<Int4>(uv), 3);
-		}
-		else
-		{
-			index[0] = Extract(As<Int2>(uuuu), 0);
-			index[1] = Extract(As<Int2>(uuuu), 1);
-			index[2] = Extract(As<Int2>(uuu2), 0);
-			index[3] = Extract(As<Int2>(uuu2), 1);
+				index[0] = Extract(As<Int4>(uv), 0);
+				index[1] = Extract(As<Int4>(uv), 1);
+				index[2] = Extract(As<Int4>(uv), 2);
+				index[3] = Extract(As<Int4>(uv), 3);
+			}
+			else
+			{
+				index[0] = Extract(As<Int2>(uuuu), 0);
+				index[1] = Extract(As<Int2>(uuuu), 1);
+				index[2] = Extract(As<Int2>(uuu2), 0);
+				index[3] = Extract(As<Int2>(uuu2), 1);
+			}
 		}
 
 		if(texelFetch)
@@ -1333,6 +1373,20 @@ namespace sw
 		}
 	}
 
+	// Tiled textures store each 4x4 block of texels as 16 consecutive texels in
+	// row-major order, with the blocks of each row of blocks laid out left to right.
+	// The index of texel (x, y) is the sum of a column and a row offset, and these
+	// preserve the sign of the out-of-range coordinates used for border texels.
+	Int4 SamplerCore::tiledColumnOffset(const Int4 &x)
+	{
+		return ((x & Int4(~3)) << 2) | (x & Int4(3));
+	}
+
+	Int4 SamplerCore::tiledRowOffset(const Int4 &y, const Int4 &pitchP)
+	{
+		return (y & Int4(~3)) * pitchP + ((y & Int4(3)) << 2);
+	}
+
 	Vector4s SamplerCore::sampleTexel(UInt index[4], Pointer<Byte> buffer)
 	{
 		Vector4s c;
@@ -43,8 +43,6 @@ namespace sw
 			Pointer<Byte> polygon(function.Arg<2>());
 			Pointer<Byte> data(function.Arg<3>());
 
-			Pointer<Byte> constants = *Pointer<Pointer<Byte> >(data + OFFSET(DrawData,constants));
-
 			const bool point = state.isDrawPoint;
 			const bool line = state.isDrawLine;
 			const bool triangle = state.isDrawTriangle;
@@ -186,83 +184,46 @@ namespace sw
 				Return(0);
 			}
 
-			For(Int q = 0, q < state.multiSample, q++)
+			// Horizontal range, rounded outwards. It only has to be conservative.
 			{
-				Array<Int> Xq(16);
-				Array<Int> Yq(16);
+				Int xMin = X[0];
+				Int xMax = X[0];
 
-				Int i = 0;
+				Int j = 1;
 
 				Do
 				{
-					Xq[i] = X[i];
-					Yq[i] = Y[i];
-
-					if(state.multiSample > 1)
-					{
-						Xq[i] = Xq[i] + *Pointer<Int>(constants + OFFSET(Constants,Xf) + q * sizeof(int));
-						Yq[i] = Yq[i] + *Pointer<Int>(constants + OFFSET(Constants,Yf) + q * sizeof(int));
-					}
+					xMin = Min(X[j], xMin);
+					xMax = Max(X[j], xMax);
 
-					i++;
+					j++;
 				}
-				Until(i >= n)
+				Until(j >= n)
 
-				Pointer<Byte> leftEdge = Pointer<Byte>(primitive + OFFSET(Primitive,outline->left)) + q * sizeof(Primitive);
-				Pointer<Byte> rightEdge = Pointer<Byte>(primitive + OFFSET(Primitive,outline->right)) + q * sizeof(Primitive);
+				xMin = Max(xMin >> 4, *Pointer<Int>(data + OFFSET(DrawData,scissorX0)));
+				xMax = Min((xMax + 0x1F) >> 4, *Pointer<Int>(data + OFFSET(DrawData,scissorX1)));
 
-				if(state.multiSample > 1)
-				{
-					Int xMin = *Pointer<Int>(data + OFFSET(DrawData, scissorX0));
-					Int xMax = *Pointer<Int>(data + OFFSET(DrawData, scissorX1));
-					Short x = Short(Clamp((X[0] + 0xF) >> 4, xMin, xMax));
-
-					For(Int y = yMin - 1, y < yMax + 1, y++)
-					{
-						*Pointer<Short>(leftEdge + y * sizeof(Primitive::Span)) = x;
-						*Pointer<Short>(rightEdge + y * sizeof(Primitive::Span)) = x;
-					}
-				}
+				*Pointer<Int>(primitive + OFFSET(Primitive,xMin)) = xMin;
+				*Pointer<Int>(primitive + OFFSET(Primitive,xMax)) = xMax;
+			}
 
-				Xq[n] = Xq[0];
-				Yq[n] = Yq[0];
+			// The pixel routine computes the outline from the polygon.
+			*Pointer<Int>(primitive + OFFSET(Primitive,n)) = n;
+			*Pointer<Int>(primitive + OFFSET(Primitive,d)) = d;
 
-				// Rasterize
-				{
-					Int i = 0;
+			i = 0;
 
-					Do
-					{
-						edge(primitive, data, Xq[i + 1 - d], Yq[i + 1 - d], Xq[i + d], Yq[i + d], q);
-
-						i++;
-					}
-					Until(i >= n)
-				}
+			Do
+			{
+				*Pointer<Int>(primitive + OFFSET(Primitive,X) + i * sizeof(int)) = X[i];
+				*Pointer<Int>(primitive + OFFSET(Primitive,Y) + i * sizeof(int)) = Y[i];
 
-				if(state.multiSample == 1)
-				{
-					For(, yMin < yMax && *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span)) == *Pointer<Short>(rightEdge + yMin * sizeof(Primitive::Span)), yMin++)
-					{
-						// Increments yMin
-					}
-
-					For(, yMax > yMin && *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span)) == *Pointer<Short>(rightEdge + (yMax - 1) * sizeof(Primitive::Span)), yMax--)
-					{
-						// Decrements yMax
-					}
-
-					If(yMin == yMax)
-					{
-						Return(0);
-					}
-
-					*Pointer<Short>(leftEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
-					*Pointer<Short>(rightEdge + (yMin - 1) * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + yMin * sizeof(Primitive::Span));
-					*Pointer<Short>(leftEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
-					*Pointer<Short>(rightEdge + yMax * sizeof(Primitive::Span)) = *Pointer<Short>(leftEdge + (yMax - 1) * sizeof(Primitive::Span));
-				}
+				i++;
 			}
+			Until(i >= n)
+
+			*Pointer<Int>(primitive + OFFSET(Primitive,X) + n * sizeof(int)) = X[0];
+			*Pointer<Int>(primitive + OFFSET(Primitive,Y) + n * sizeof(int)) = Y[0];
 
 			*Pointer<Int>(primitive + OFFSET(Primitive,yMin)) = yMin;
 			*Pointer<Int>(primitive + OFFSET(Primitive,yMax)) = yMax;
@@ -442,6 +403,9 @@ namespace sw
 				*Pointer<Float4>(primitive + OFFSET(Primitive,z.C), 16) = C;
 			}
 
+			// Plane equations are packed, skipping unused interpolants.
+			int plane = 0;
+
 			for (int interpolant = 0; interpolant < MAX_INTERFACE_COMPONENTS; interpolant++)
 			{
 				// Note: `sprite` mode controls whether to replace this interpolant with the point sprite PointCoord value.
@@ -450,7 +414,7 @@ namespace sw
 				if (state.gradient[interpolant].Type != SpirvShader::ATTRIBTYPE_UNUSED)
 					setupGradient(primitive, tri, w012, M, v0, v1, v2,
 							OFFSET(Vertex, v[interpolant]),
-							OFFSET(Primitive, V[interpolant]),
+							OFFSET(Primitive, V[plane++]),
 							state.gradient[interpolant].Flat,
 							false /* is pointcoord */,
 							!state.gradient[interpolant].NoPerspective, 0);
@@ -525,71 +489,6 @@ namespace sw
 		}
 	}
 
-	void SetupRoutine::edge(Pointer<Byte> &primitive, Pointer<Byte> &data, const Int &Xa, const Int &Ya, const Int &Xb, const Int &Yb, Int &q)
-	{
-		If(Ya != Yb)
-		{
-			Bool swap = Yb < Ya;
-
-			Int X1 = IfThenElse(swap, Xb, Xa);
-			Int X2 = IfThenElse(swap, Xa, Xb);
-			Int Y1 = IfThenElse(swap, Yb, Ya);
-			Int Y2 = IfThenElse(swap, Ya, Yb);
-
-			Int y1 = Max((Y1 + 0x0000000F) >> 4, *Pointer<Int>(data + OFFSET(DrawData,scissorY0)));
-			Int y2 = Min((Y2 + 0x0000000F) >> 4, *Pointer<Int>(data + OFFSET(DrawData,scissorY1)));
-
-			If(y1 < y2)
-			{
-				Int xMin = *Pointer<Int>(data + OFFSET(DrawData,scissorX0));
-				Int xMax = *Pointer<Int>(data + OFFSET(DrawData,scissorX1));
-
-				Pointer<Byte> leftEdge = primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->left);
-				Pointer<Byte> rightEdge = primitive + q * sizeof(Primitive) + OFFSET(Primitive,outline->right);
-				Pointer<Byte> edge = IfThenElse(swap, rightEdge, leftEdge);
-
-				// Deltas
-				Int DX12 = X2 - X1;
-				Int DY12 = Y2 - Y1;
-
-				Int FDX12 = DX12 << 4;
-				Int FDY12 = DY12 << 4;
-
-				Int X = DX12 * ((y1 << 4) - Y1) + (X1 & 0x0000000F) * DY12;
-				Int x = (X1 >> 4) + X / FDY12;   // Edge
-				Int d = X % FDY12;               // Error-term
-				Int ceil = -d >> 31;             // Ceiling division: remainder <= 0
-				x -= ceil;
-				d -= ceil & FDY12;
-
-				Int Q = FDX12 / FDY12;   // Edge-step
-				Int R = FDX12 % FDY12;   // Error-step
-				Int floor = R >> 31;     // Flooring division: remainder >= 0
-				Q += floor;
-				R += floor & FDY12;
-
-				Int D = FDY12;   // Error-overflow
-				Int y = y1;
-
-				Do
-				{
-					*Pointer<Short>(edge + y * sizeof(Primitive::Span)) = Short(Clamp(x, xMin, xMax));
-
-					x += Q;
-					d += R;
-
-					Int overflow = -d >> 31;
-
-					d -= D & overflow;
-					x -= overflow;
-
-					y++;
-				}
-				Until(y >= y2)
-			}
-		}
-	}
-
 	void SetupRoutine::conditionalRotate1(Bool condition, Pointer<Byte> &v0, Pointer<Byte> &v1, Pointer<Byte> &v2)
 	{
 		#if 0   // Rely on LLVM optimization
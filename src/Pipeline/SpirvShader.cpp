@@ -33,6 +33,11 @@ namespace
 {
 	constexpr float PI = 3.141592653589793f;
 
+	// Blocks with at least this many instructions are skipped when none of
+	// their lanes are active. For smaller blocks the test costs more than it
+	// saves.
+	constexpr uint32_t MinSkippableBlockSize = 12;
+
 	rr::RValue<rr::Bool> AnyTrue(rr::RValue<sw::SIMD::Int> const &ints)
 	{
 		return rr::SignMask(ints) != 0;
@@ -307,7 +312,7 @@ namespace sw
 					auto offset = Extract(offsets, 0);
 					out = T(rr::Load(rr::Pointer<EL>(&ptr.base[offset]), sizeof(float), atomic, order));
 				}
-				Else If(ptr.hasSequentialOffsets() && !anyLanesDisabled)
+				Else If(ptr.hasSequentialOffsets(sizeof(float)) && !anyLanesDisabled)
 				{
 					// Load all elements in a single SIMD instruction.
 					auto offset = Extract(offsets, 0);
@@ -344,7 +349,7 @@ namespace sw
 			else
 			{
 				auto anyLanesDisabled = AnyFalse(mask);
-				If(ptr.hasSequentialOffsets() && !anyLanesDisabled)
+				If(ptr.hasSequentialOffsets(sizeof(float)) && !anyLanesDisabled)
 				{
 					// Store all elements in a single SIMD instruction.
 					auto offset = Extract(offsets, 0);
@@ -985,6 +990,7 @@ namespace sw
 
 		ASSERT_MSG(entryPointFunctionId != 0, "Entry point '%s' not found", createInfo->pName);
 		AssignBlockFields();
+		AnalyzeDivergence();
 	}
 
 	void SpirvShader::TraverseReachableBlocks(Block::ID id, SpirvShader::Block::Set& reachable)
@@ -1027,6 +1033,230 @@ namespace sw
 		}
 	}
 
+	void SpirvShader::AnalyzeDivergence()
+	{
+		auto isUniform = [this](uint32_t id) {
+			auto it = defs.find(id);
+			return it != defs.end() && (it->second.kind == Object::Kind::Constant || it->second.isUniform);
+		};
+
+		auto operandsUniform = [&](InsnIterator insn, uint32_t first, uint32_t last) {
+			for (auto w = first; w < last; w++)
+			{
+				if (!isUniform(insn.word(w))) { return false; }
+			}
+			return true;
+		};
+
+		// Results are defined before they are used, other than by OpPhi which
+		// merges values from divergent paths, so a single pass over the module
+		// finds the uniform values.
+		for (auto insn : *this)
+		{
+			switch (insn.opcode())
+			{
+			case spv::OpVariable:
+				// Storage buffers and workgroup memory may be written by other
+				// invocations, so loads through them can differ across lanes.
+				switch (static_cast<spv::StorageClass>(insn.word(3)))
+				{
+				case spv::StorageClassUniform:
+				{
+					Decorations d{};
+					ApplyDecorationsForId(&d, getType(insn.word(1)).element);
+					defs[insn.word(2)].isUniform = !d.BufferBlock;
+					break;
+				}
+				case spv::StorageClassUniformConstant:
+				case spv::StorageClassPushConstant:
+					defs[insn.word(2)].isUniform = true;
+					break;
+				default:
+					break;
+				}
+				break;
+
+			case spv::OpLoad:
+			case spv::OpCompositeExtract:
+				defs[insn.word(2)].isUniform = operandsUniform(insn, 3, 4);
+				break;
+
+			case spv::OpCompositeInsert:
+			case spv::OpVectorShuffle:
+				defs[insn.word(2)].isUniform = operandsUniform(insn, 3, 5);
+				break;
+
+			case spv::OpExtInst:
+				defs[insn.word(2)].isUniform = operandsUniform(insn, 5, insn.wordCount());
+				break;
+
+			case spv::OpAccessChain:
+			case spv::OpInBoundsAccessChain:
+			case spv::OpCopyObject:
+			case spv::OpCompositeConstruct:
+			case spv::OpVectorExtractDynamic:
+			case spv::OpVectorInsertDynamic:
+			case spv::OpVectorTimesScalar:
+			case spv::OpMatrixTimesScalar:
+			case spv::OpMatrixTimesVector:
+			case spv::OpVectorTimesMatrix:
+			case spv::OpMatrixTimesMatrix:
+			case spv::OpOuterProduct:
+			case spv::OpTranspose:
+			case spv::OpNot:
+			case spv::OpSNegate:
+			case spv::OpFNegate:
+			case spv::OpLogicalNot:
+			case spv::OpConvertFToU:
+			case spv::OpConvertFToS:
+			case spv::OpConvertSToF:
+			case spv::OpConvertUToF:
+			case spv::OpBitcast:
+			case spv::OpIsInf:
+			case spv::OpIsNan:
+			case spv::OpIAdd:
+			case spv::OpISub:
+			case spv::OpIMul:
+			case spv::OpSDiv:
+			case spv::OpUDiv:
+			case spv::OpFAdd:
+			case spv::OpFSub:
+			case spv::OpFMul:
+			case spv::OpFDiv:
+			case spv::OpFMod:
+			case spv::OpFRem:
+			case spv::OpSMod:
+			case spv::OpSRem:
+			case spv::OpUMod:
+			case spv::OpFOrdEqual:
+			case spv::OpFUnordEqual:
+			case spv::OpFOrdNotEqual:
+			case spv::OpFUnordNotEqual:
+			case spv::OpFOrdLessThan:
+			case spv::OpFUnordLessThan:
+			case spv::OpFOrdGreaterThan:
+			case spv::OpFUnordGreaterThan:
+			case spv::OpFOrdLessThanEqual:
+			case spv::OpFUnordLessThanEqual:
+			case spv::OpFOrdGreaterThanEqual:
+			case spv::OpFUnordGreaterThanEqual:
+			case spv::OpIEqual:
+			case spv::OpINotEqual:
+			case spv::OpUGreaterThan:
+			case spv::OpSGreaterThan:
+			case spv::OpUGreaterThanEqual:
+			case spv::OpSGreaterThanEqual:
+			case spv::OpULessThan:
+			case spv::OpSLessThan:
+			case spv::OpULessThanEqual:
+			case spv::OpSLessThanEqual:
+			case spv::OpShiftRightLogical:
+			case spv::OpShiftRightArithmetic:
+			case spv::OpShiftLeftLogical:
+			case spv::OpBitwiseOr:
+			case spv::OpBitwiseXor:
+			case spv::OpBitwiseAnd:
+			case spv::OpLogicalOr:
+			case spv::OpLogicalAnd:
+			case spv::OpLogicalEqual:
+			case spv::OpLogicalNotEqual:
+			case spv::OpDot:
+			case spv::OpSelect:
+			case spv::OpAny:
+			case spv::OpAll:
+				defs[insn.word(2)].isUniform = operandsUniform(insn, 3, insn.wordCount());
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		for (auto &it : blocks)
+		{
+			auto &block = it.second;
+			if (it.first == entryPointBlockId || block.kind == Block::Loop)
+			{
+				continue;
+			}
+
+			uint32_t size = 0;
+			for (auto insn = block.begin(); insn != block.end() && size < MinSkippableBlockSize; insn++)
+			{
+				size++;
+			}
+			block.skipWhenInactive = (size >= MinSkippableBlockSize);
+		}
+
+		// All the active lanes take the same edge of a uniform branch, leaving
+		// every other target with no active lanes from this block.
+		for (auto &it : blocks)
+		{
+			auto &block = it.second;
+			switch (block.kind)
+			{
+			case Block::StructuredBranchConditional:
+			case Block::UnstructuredBranchConditional:
+			case Block::StructuredSwitch:
+			case Block::UnstructuredSwitch:
+				if (isUniform(block.branchInstruction.word(1)))
+				{
+					for (auto out : block.outs)
+					{
+						auto &target = blocks[out];
+						if (out != entryPointBlockId && target.kind != Block::Loop)
+						{
+							target.skipWhenInactive = true;
+						}
+					}
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		// Intermediates and pointers are SSA values, which must be passed
+		// through variables to be used beyond a block that may be skipped.
+		std::unordered_map<Object::ID, Block::ID> definingBlock;
+		for (auto &it : blocks)
+		{
+			if (!it.second.skipWhenInactive)
+			{
+				continue;
+			}
+			for (auto insn : it.second)
+			{
+				if (insn.wordCount() <= 2)
+				{
+					continue;
+				}
+				auto defIt = defs.find(insn.word(2));
+				if (defIt != defs.end() && defIt->second.definition == insn &&
+				    (defIt->second.kind == Object::Kind::Intermediate || defIt->second.kind == Object::Kind::Pointer))
+				{
+					definingBlock.emplace(insn.word(2), it.first);
+				}
+			}
+		}
+
+		std::unordered_set<Object::ID> escaping;
+		for (auto &it : blocks)
+		{
+			for (auto insn : it.second)
+			{
+				for (uint32_t w = 1; w < insn.wordCount(); w++)
+				{
+					auto defIt = definingBlock.find(insn.word(w));
+					if (defIt != definingBlock.end() && defIt->second != it.first && escaping.emplace(defIt->first).second)
+					{
+						blocks[defIt->second].escapingResults.push_back(defIt->first);
+					}
+				}
+			}
+		}
+	}
+
 	void SpirvShader::DeclareType(InsnIterator insn)
 	{
 		Type::ID resultId = insn.word(1);
@@ -2079,7 +2309,14 @@ namespace sw
 			state->setActiveLaneMask(activeLaneMask);
 		}
 
-		EmitInstructions(block.begin(), block.end(), state);
+		if (block.skipWhenInactive)
+		{
+			EmitSkippableBlock(state);
+		}
+		else
+		{
+			EmitInstructions(block.begin(), block.end(), state);
+		}
 
 		for (auto out : block.outs)
 		{
@@ -2087,6 +2324,114 @@ namespace sw
 		}
 	}
 
+	void SpirvShader::EmitSkippableBlock(EmitState *state) const
+	{
+		auto blockId = state->currentBlock;
+		auto &block = getBlock(blockId);
+		auto routine = state->routine;
+
+		auto resultSize = [this](Object::ID id) { return getType(getObject(id).type).sizeInComponents; };
+
+		std::vector<Block::ID> outs(block.outs.begin(), block.outs.end());
+		std::vector<SIMD::Int> outMasks(outs.size(), SIMD::Int(0));
+
+		struct PointerVariable
+		{
+			rr::Pointer<Byte> base;
+			rr::Int limit = 0; // Disables all accesses if the block is skipped.
+			SIMD::Int dynamicOffsets;
+
+			// Known at emit time, and the same on both paths.
+			std::array<int32_t, SIMD::Width> staticOffsets;
+			bool hasDynamicOffsets;
+		};
+
+		std::unordered_map<Object::ID, SpirvRoutine::Variable> escaping;
+		std::unordered_map<Object::ID, PointerVariable> escapingPointers;
+		for (auto id : block.escapingResults)
+		{
+			if (getObject(id).kind == Object::Kind::Pointer)
+			{
+				escapingPointers[id];
+			}
+			else
+			{
+				escaping.emplace(id, SpirvRoutine::Variable(resultSize(id)));
+			}
+		}
+
+		SIMD::Int activeLaneMask = state->activeLaneMask();
+
+		auto activeBasicBlock = Nucleus::createBasicBlock();
+		auto mergeBasicBlock = Nucleus::createBasicBlock();
+		Nucleus::createCondBr(AnyTrue(activeLaneMask).value, activeBasicBlock, mergeBasicBlock);
+		Nucleus::setInsertBlock(activeBasicBlock);
+
+		EmitInstructions(block.begin(), block.end(), state);
+
+		for (size_t i = 0; i < outs.size(); i++)
+		{
+			auto it = state->edgeActiveLaneMasks.find(Block::Edge{blockId, outs[i]});
+			if (it != state->edgeActiveLaneMasks.end())
+			{
+				outMasks[i] = it->second;
+			}
+		}
+
+		for (auto &it : escaping)
+		{
+			auto const &intermediate = routine->getIntermediate(it.first);
+			for (uint32_t i = 0; i < resultSize(it.first); i++)
+			{
+				it.second[i] = intermediate.Float(i);
+			}
+		}
+
+		for (auto &it : escapingPointers)
+		{
+			auto const &ptr = routine->getPointer(it.first);
+			it.second.base = ptr.base;
+			it.second.limit = ptr.limit;
+			it.second.dynamicOffsets = ptr.dynamicOffsets;
+			it.second.staticOffsets = ptr.staticOffsets;
+			it.second.hasDynamicOffsets = ptr.hasDynamicOffsets;
+		}
+
+		Nucleus::createBr(mergeBasicBlock);
+		Nucleus::setInsertBlock(mergeBasicBlock);
+
+		// The values produced in activeBasicBlock do not dominate the code
+		// that follows, so replace them with loads of their variables.
+		for (size_t i = 0; i < outs.size(); i++)
+		{
+			auto edge = Block::Edge{blockId, outs[i]};
+			state->edgeActiveLaneMasks.erase(edge);
+			state->edgeActiveLaneMasks.emplace(edge, outMasks[i]);
+		}
+
+		for (auto &it : escaping)
+		{
+			routine->intermediates.erase(it.first);
+			auto &dst = routine->createIntermediate(it.first, resultSize(it.first));
+			for (uint32_t i = 0; i < resultSize(it.first); i++)
+			{
+				dst.move(i, it.second[i]);
+			}
+		}
+
+		for (auto &it : escapingPointers)
+		{
+			SIMD::Pointer ptr(it.second.base, it.second.limit, it.second.dynamicOffsets);
+			ptr.staticOffsets = it.second.staticOffsets;
+			ptr.hasDynamicOffsets = it.second.hasDynamicOffsets;
+			routine->pointers.erase(it.first);
+			routine->createPointer(it.first, ptr);
+		}
+
+		// The mask left by the block's terminator is in activeBasicBlock too.
+		state->setActiveLaneMask(activeLaneMask);
+	}
+
 	void SpirvShader::EmitLoop(EmitState *state) const
 	{
 		auto blockId = state->currentBlock;
@@ -4594,7 +4939,8 @@ namespace sw
 		auto cond = GenericValue(this, state->routine, condId);
 		ASSERT_MSG(getType(cond.type).sizeInComponents == 1, "Condition must be a Boolean type scalar");
 
-		// TODO: Optimize for case where all lanes take same path.
+		// Targets left without active lanes are skipped if they were marked
+		// skipWhenInactive by AnalyzeDivergence().
 
 		state->addOutputActiveLaneMaskEdge(trueBlockId, cond.Int(0));
 		state->addOutputActiveLaneMaskEdge(falseBlockId, ~cond.Int(0));
@@ -4614,7 +4960,8 @@ namespace sw
 
 		auto numCases = (block.branchInstruction.wordCount() - 3) / 2;
 
-		// TODO: Optimize for case where all lanes take same path.
+		// Targets left without active lanes are skipped if they were marked
+		// skipWhenInactive by AnalyzeDivergence().
 
 		SIMD::Int defaultLaneMask = state->activeLaneMask();
 
@@ -4925,10 +5272,8 @@ namespace sw
 			}
 		}
 
-		auto samplerFunc = Call(getImageSampler, instruction.parameters, imageDescriptor, sampler);
-
 		Array<SIMD::Float> out(4);
-		Call<ImageSampler>(samplerFunc, texture, sampler, &in[0], &out[0], state->routine->constants);
+		Call(sampleImage, instruction.parameters, imageDescriptor, sampler, texture, &in[0], &out[0], state->routine->constants);
 
 		for (auto i = 0u; i < resultType.sizeInComponents; i++) { result.move(i, out[i]); }
 
@@ -69,6 +69,30 @@ namespace sw
 		using Int = rr::Int4;
 		using UInt = rr::UInt4;
 
+		// The helpers below build every lane-dependent value needed by the
+		// shader emitter and its drivers, so that they are the only code tied
+		// to the width of the Reactor vector types.
+		static_assert(Width == 4, "The SIMD lane helpers expect 4-wide vectors");
+
+		// Returns the index of each lane: (0, 1, ..., Width - 1).
+		inline Int LaneIndices()
+		{
+			return Int(0, 1, 2, 3);
+		}
+
+		// Returns a vector holding the given value of each lane.
+		inline Int FromArray(const std::array<int32_t, Width> &lanes)
+		{
+			return Int(lanes[0], lanes[1], lanes[2], lanes[3]);
+		}
+
+		// Returns v with each lane holding the value of the next lane, and the
+		// last lane holding the value of the first.
+		inline Int RotateLanes(Int v)
+		{
+			return RValue<Int>(v.yzwx);
+		}
+
 		struct Pointer
 		{
 			Pointer(rr::Pointer<Byte> base, rr::Int limit)
@@ -115,24 +139,24 @@ namespace sw
 
 			inline SIMD::Int offsets() const
 			{
-				static_assert(SIMD::Width == 4, "Expects SIMD::Width to be 4");
-				return dynamicOffsets + SIMD::Int(staticOffsets[0], staticOffsets[1], staticOffsets[2], staticOffsets[3]);
+				return dynamicOffsets + SIMD::FromArray(staticOffsets);
 			}
 
-			// Returns true if all offsets are sequential (N+0, N+1, N+2, N+3)
-			inline rr::Bool hasSequentialOffsets() const
+			// Returns true if all offsets are sequential, with the given step in
+			// bytes between lanes (N+0*step, N+1*step, N+2*step, N+3*step)
+			inline rr::Bool hasSequentialOffsets(int step) const
 			{
 				if (hasDynamicOffsets)
 				{
-					auto o = offsets();
-					static_assert(SIMD::Width == 4, "Expects SIMD::Width to be 4");
-					return rr::SignMask(~CmpEQ(o.yzww, o + SIMD::Int(1, 2, 3, 0))) == 0;
+					// Sequential offsets are equal once each lane's step is subtracted.
+					SIMD::Int o = offsets() - SIMD::LaneIndices() * SIMD::Int(step);
+					return rr::SignMask(~CmpEQ(o, SIMD::RotateLanes(o))) == 0;
 				}
 				else
 				{
 					for (int i = 1; i < SIMD::Width; i++)
 					{
-						if (staticOffsets[i-1] + 1 != staticOffsets[i]) { return false; }
+						if (staticOffsets[i-1] + step != staticOffsets[i]) { return false; }
 					}
 					return true;
 				}
@@ -144,8 +168,7 @@ namespace sw
 				if (hasDynamicOffsets)
 				{
 					auto o = offsets();
-					static_assert(SIMD::Width == 4, "Expects SIMD::Width to be 4");
-					return rr::SignMask(~CmpEQ(o, o.yzwx)) == 0;
+					return rr::SignMask(~CmpEQ(o, SIMD::RotateLanes(o))) == 0;
 				}
 				else
 				{
@@ -261,7 +284,6 @@ namespace sw
 		InsnStore insns;
 
 		using ImageSampler = void(void* texture, void *sampler, void* uvsIn, void* texelOut, void* constants);
-		using GetImageSampler = ImageSampler*(const vk::ImageView *imageView, const vk::Sampler *sampler);
 
 		enum class YieldResult
 		{
@@ -404,6 +426,10 @@ namespace sw
 			};
 
 			Kind kind = Kind::Unknown;
+
+			// True if the value is provably the same in all the lanes which
+			// compute it. Set by AnalyzeDivergence().
+			bool isUniform = false;
 		};
 
 		// Block is an interval of SPIR-V instructions, starting with the
@@ -457,6 +483,15 @@ namespace sw
 			Set ins; // Blocks that branch into this block.
 			Set outs; // Blocks that this block branches to.
 			bool isLoopMerge = false;
+
+			// True if the block is emitted behind a test of its active lane
+			// mask, so that it is skipped when no lanes reach it.
+			bool skipWhenInactive = false;
+
+			// Intermediates and pointers defined by a skipWhenInactive block
+			// which are used by other blocks, and so have to be carried past
+			// the skip.
+			std::vector<Object::ID> escapingResults;
 		private:
 			InsnIterator begin_;
 			InsnIterator end_;
@@ -759,6 +794,13 @@ namespace sw
 		//   another loop block.
 		void AssignBlockFields();
 
+		// AnalyzeDivergence() marks the objects that are uniform across lanes,
+		// then sets Block::skipWhenInactive for the reachable blocks which are
+		// worth skipping when their active lane mask is all zeros: those with
+		// many instructions, and those targeted by a uniform branch, where all
+		// the active lanes take the same edge.
+		void AnalyzeDivergence();
+
 		// DeclareType creates a Type for the given OpTypeX instruction, storing
 		// it into the types map. It is called from the analysis pass (constructor).
 		void DeclareType(InsnIterator insn);
@@ -916,6 +958,11 @@ namespace sw
 		void EmitNonLoop(EmitState *state) const;
 		void EmitLoop(EmitState *state) const;
 
+		// Emits the current block's instructions behind a branch on its active
+		// lane mask being non-zero. Output edge masks and escaping
+		// intermediates are passed through variables to the code that follows.
+		void EmitSkippableBlock(EmitState *state) const;
+
 		void EmitInstructions(InsnIterator begin, InsnIterator end, EmitState *state) const;
 		EmitResult EmitInstruction(InsnIterator insn, EmitState *state) const;
 
@@ -1011,8 +1058,12 @@ namespace sw
 		// Returns the pair <significand, exponent>
 		std::pair<SIMD::Float, SIMD::Int> Frexp(RValue<SIMD::Float> val) const;
 
-		static ImageSampler *getImageSampler(uint32_t instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler);
-		static ImageSampler *emitSamplerFunction(ImageInstruction instruction, const Sampler &samplerState);
+		// Looks up the sampling routine for the instruction and sampler state,
+		// generating it if needed, and runs it.
+		static void sampleImage(uint32_t instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler,
+		                        void *texture, void *uvsIn, void *texelOut, void *constants);
+		static Sampler getSamplerState(ImageInstruction instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler);
+		static rr::Routine *emitSamplerFunction(ImageInstruction instruction, const Sampler &samplerState);
 
 		// TODO(b/129523279): Eliminate conversion and use vk::Sampler members directly.
 		static sw::TextureType convertTextureType(VkImageViewType imageViewType);
@@ -24,55 +24,169 @@
 #include "Vulkan/VkSampler.hpp"
 #include "Vulkan/VkDescriptorSetLayout.hpp"
 #include "Device/Config.hpp"
+#include "Device/LRUCache.hpp"
 
 #include <spirv/unified1/spirv.hpp>
 #include <spirv/unified1/GLSL.std.450.h>
 
 #include <climits>
-#include <mutex>
+#include <cstddef>
+#include <cstring>
 
 namespace
 {
 
+// Sampling routines are keyed on the instruction and the sampler state, so
+// all image views and samplers with the same state share their code.
 struct SamplingRoutineKey
 {
-	uint32_t instruction;
-	uint32_t sampler;
-	uint32_t imageView;
+	SamplingRoutineKey(uint32_t instruction, const sw::Sampler &samplerState)
+	{
+		memset(this, 0, sizeof(SamplingRoutineKey));   // Zero the padding, which is hashed and compared
+
+		this->instruction = instruction;
+		this->samplerState = samplerState;
+
+		const unsigned char *bytes = reinterpret_cast<const unsigned char*>(this);
+		hash = 2166136261u;
+
+		for(size_t i = 0; i < offsetof(SamplingRoutineKey, hash); i++)
+		{
+			hash = (hash ^ bytes[i]) * 16777619u;
+		}
+	}
 
 	bool operator==(const SamplingRoutineKey &rhs) const
 	{
-		return instruction == rhs.instruction && sampler == rhs.sampler && imageView == rhs.imageView;
+		return hash == rhs.hash && memcmp(this, &rhs, sizeof(SamplingRoutineKey)) == 0;
 	}
 
-	struct Hash
+	uint32_t instruction;
+	sw::Sampler samplerState;
+	uint32_t hash;
+};
+
+// The sampling routine cache is shared by all shaders and looked up by each
+// sampling instruction, so it is split into shards with their own lock to
+// keep concurrent lookups from contending. Evicted routines stay alive until
+// the samplings still using them return.
+class SamplingRoutineCache
+{
+public:
+	SamplingRoutineCache()
 	{
-		std::size_t operator()(const SamplingRoutineKey &key) const noexcept
+		for(auto &shard : shards)
 		{
-			return (key.instruction << 16) ^ (key.sampler << 8) ^ key.imageView;
+			shard = new sw::LRUCache<SamplingRoutineKey, rr::Routine>(shardSize);
 		}
+	}
+
+	~SamplingRoutineCache()
+	{
+		for(auto &shard : shards)
+		{
+			delete shard;
+		}
+	}
+
+	sw::LRUCache<SamplingRoutineKey, rr::Routine> &getShard(const SamplingRoutineKey &key)
+	{
+		return *shards[key.hash % shardCount];
+	}
+
+private:
+	static constexpr int shardCount = 16;
+	static constexpr int shardSize = 64;   // Bounds the cache to 1024 routines
+
+	sw::LRUCache<SamplingRoutineKey, rr::Routine> *shards[shardCount];
+};
+
+// Each thread holds on to the routines of its recent samplings, so that
+// sampling again with the same image view and sampler neither rebuilds the
+// sampler state nor takes a shard lock. Image view and sampler ids are never
+// reused, and the sampler state is derived from their objects only, so the
+// ids identify the state a routine was generated for.
+class RecentSamplingRoutines
+{
+public:
+	struct Entry
+	{
+		uint32_t instruction;
+		uint32_t imageViewId;
+		uint32_t samplerId;
+		rr::Routine *routine;   // Holds a reference while cached
 	};
+
+	~RecentSamplingRoutines()
+	{
+		for(auto &entry : entries)
+		{
+			if(entry.routine)
+			{
+				entry.routine->unbind();
+			}
+		}
+	}
+
+	Entry &get(uint32_t instruction, uint32_t imageViewId, uint32_t samplerId)
+	{
+		uint32_t hash = (instruction ^ (imageViewId << 8) ^ (samplerId << 20)) * 2654435761u;
+		return entries[hash >> (32 - entryBits)];
+	}
+
+private:
+	static constexpr int entryBits = 4;
+
+	Entry entries[1 << entryBits] = {};
 };
 
 }
 
 namespace sw {
 
-SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler)
+void SpirvShader::sampleImage(uint32_t inst, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler,
+                              void *texture, void *uvsIn, void *texelOut, void *constants)
 {
 	ImageInstruction instruction(inst);
 	ASSERT(imageDescriptor->imageViewId != 0 && (sampler->id != 0 || instruction.samplerMethod == Fetch));
 
 	// TODO(b/129523279): Move somewhere sensible.
-	static std::unordered_map<SamplingRoutineKey, ImageSampler*, SamplingRoutineKey::Hash> cache;
-	static std::mutex mutex;
+	static SamplingRoutineCache cache;
+	static thread_local RecentSamplingRoutines recent;
+
+	auto &entry = recent.get(inst, imageDescriptor->imageViewId, sampler->id);
 
-	SamplingRoutineKey key = {inst, imageDescriptor->imageViewId, sampler->id};
+	if(!entry.routine ||
+	   entry.instruction != inst ||
+	   entry.imageViewId != imageDescriptor->imageViewId ||
+	   entry.samplerId != sampler->id)
+	{
+		Sampler samplerState = getSamplerState(instruction, imageDescriptor, sampler);
+		SamplingRoutineKey key(inst, samplerState);
+		auto &shard = cache.getShard(key);
+
+		rr::Routine *routine = shard.query(key);
 
-	std::unique_lock<std::mutex> lock(mutex);
-	auto it = cache.find(key);
-	if (it != cache.end()) { return it->second; }
+		if(!routine)
+		{
+			// If another thread added the same state first, its routine is used.
+			routine = shard.add(key, emitSamplerFunction(instruction, samplerState));
+		}
+
+		if(entry.routine)
+		{
+			entry.routine->unbind();
+		}
 
+		entry = { inst, imageDescriptor->imageViewId, sampler->id, routine };
+	}
+
+	auto function = (ImageSampler*)entry.routine->getEntry();
+	function(texture, const_cast<vk::Sampler*>(sampler), uvsIn, texelOut, constants);
+}
+
+Sampler SpirvShader::getSamplerState(ImageInstruction instruction, vk::SampledImageDescriptor const *imageDescriptor, const vk::Sampler *sampler)
+{
 	auto type = imageDescriptor->type;
 
 	Sampler samplerState = {};
@@ -95,6 +209,7 @@ SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::Sampl
 	samplerState.largeTexture = (imageDescriptor->extent.width  > SHRT_MAX) ||
 	                            (imageDescriptor->extent.height > SHRT_MAX) ||
 	                            (imageDescriptor->extent.depth  > SHRT_MAX);
+	samplerState.tiled = imageDescriptor->tiled;
 
 	if(sampler->ycbcrConversion)
 	{
@@ -108,13 +223,10 @@ SpirvShader::ImageSampler *SpirvShader::getImageSampler(uint32_t inst, vk::Sampl
 		UNSUPPORTED("anisotropyEnable");
 	}
 
-	auto fptr = emitSamplerFunction(instruction, samplerState);
-
-	cache.emplace(key, fptr);
-	return fptr;
+	return samplerState;
 }
 
-SpirvShader::ImageSampler *SpirvShader::emitSamplerFunction(ImageInstruction instruction, const Sampler &samplerState)
+rr::Routine *SpirvShader::emitSamplerFunction(ImageInstruction instruction, const Sampler &samplerState)
 {
 	// TODO(b/129523279): Hold a separate mutex lock for the sampler being built.
 	Function<Void(Pointer<Byte>, Pointer<Byte>, Pointer<SIMD::Float>, Pointer<SIMD::Float>, Pointer<Byte>)> function;
@@ -193,7 +305,7 @@ SpirvShader::ImageSampler *SpirvShader::emitSamplerFunction(ImageInstruction ins
 		rgba[3] = sample.w;
 	}
 
-	return (ImageSampler*)function("sampler")->getEntry();
+	return function("sampler");
 }
 
 sw::TextureType SpirvShader::convertTextureType(VkImageViewType imageViewType)
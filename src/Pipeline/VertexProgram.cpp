@@ -32,21 +32,12 @@ namespace sw
 		: VertexRoutine(state, pipelineLayout, spirvShader),
 		  descriptorSets(descriptorSets)
 	{
-		auto it = spirvShader->inputBuiltins.find(spv::BuiltInInstanceIndex);
-		if (it != spirvShader->inputBuiltins.end())
-		{
-			// TODO: we could do better here; we know InstanceIndex is uniform across all lanes
-			assert(it->second.SizeInComponents == 1);
-			routine.getVariable(it->second.Id)[it->second.FirstComponent] =
-					As<Float4>(Int4((*Pointer<Int>(data + OFFSET(DrawData, instanceID)))));
-		}
-
 		routine.descriptorSets = data + OFFSET(DrawData, descriptorSets);
 		routine.descriptorDynamicOffsets = data + OFFSET(DrawData, descriptorDynamicOffsets);
 		routine.pushConstants = data + OFFSET(DrawData, pushConstants);
 		routine.constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, constants));
 
-		it = spirvShader->inputBuiltins.find(spv::BuiltInSubgroupSize);
+		auto it = spirvShader->inputBuiltins.find(spv::BuiltInSubgroupSize);
 		if (it != spirvShader->inputBuiltins.end())
 		{
 			ASSERT(it->second.SizeInComponents == 1);
@@ -57,7 +48,7 @@ namespace sw
 		if (it != spirvShader->inputBuiltins.end())
 		{
 			ASSERT(it->second.SizeInComponents == 1);
-			routine.getVariable(it->second.Id)[it->second.FirstComponent] = As<SIMD::Float>(SIMD::Int(0, 1, 2, 3));
+			routine.getVariable(it->second.Id)[it->second.FirstComponent] = As<SIMD::Float>(SIMD::LaneIndices());
 		}
 
 		it = spirvShader->inputBuiltins.find(spv::BuiltInDeviceIndex);
@@ -65,7 +56,7 @@ namespace sw
 		{
 			ASSERT(it->second.SizeInComponents == 1);
 			// Only a single physical device is supported.
-			routine.getVariable(it->second.Id)[it->second.FirstComponent] = As<SIMD::Float>(SIMD::Int(0, 0, 0, 0));
+			routine.getVariable(it->second.Id)[it->second.FirstComponent] = As<SIMD::Float>(SIMD::Int(0));
 		}
 	}
 
@@ -73,14 +64,23 @@ namespace sw
 	{
 	}
 
-	void VertexProgram::program(UInt &index)
+	void VertexProgram::program(UInt4 &index, UInt4 &instance)
 	{
 		auto it = spirvShader->inputBuiltins.find(spv::BuiltInVertexIndex);
 		if (it != spirvShader->inputBuiltins.end())
 		{
 			assert(it->second.SizeInComponents == 1);
 			routine.getVariable(it->second.Id)[it->second.FirstComponent] =
-					As<Float4>(Int4(As<Int>(index) + *Pointer<Int>(data + OFFSET(DrawData, baseVertex))) + Int4(0, 1, 2, 3));
+					As<Float4>(As<Int4>(index) + Int4(*Pointer<Int>(data + OFFSET(DrawData, baseVertex))));
+		}
+
+		// Lanes can belong to different instances of the draw.
+		it = spirvShader->inputBuiltins.find(spv::BuiltInInstanceIndex);
+		if (it != spirvShader->inputBuiltins.end())
+		{
+			assert(it->second.SizeInComponents == 1);
+			routine.getVariable(it->second.Id)[it->second.FirstComponent] =
+					As<Float4>(As<Int4>(instance) + Int4(*Pointer<Int>(data + OFFSET(DrawData, firstInstance))));
 		}
 
 		auto activeLaneMask = SIMD::Int(0xFFFFFFFF); // TODO: Control this.
@@ -34,7 +34,7 @@ namespace sw
 		virtual ~VertexProgram();
 
 	private:
-		void program(UInt &index) override;
+		void program(UInt4 &index, UInt4 &instance) override;
 
 		const vk::DescriptorSet::Bindings &descriptorSets;
 	};
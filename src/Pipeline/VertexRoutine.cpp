@@ -43,46 +43,63 @@ namespace sw
 	{
 		const bool textureSampling = state.textureSampling;
 
-		Pointer<Byte> cache = task + OFFSET(VertexTask,vertexCache);
-		Pointer<Byte> vertexCache = cache + OFFSET(VertexCache,vertex);
-		Pointer<Byte> tagCache = cache + OFFSET(VertexCache,tag);
+		Pointer<Byte> instances = task + OFFSET(VertexTask,instances);
+		Pointer<Byte> slots = task + OFFSET(VertexTask,slots);
+		Pointer<Byte> sources = task + OFFSET(VertexTask,sources);
 
+		UInt uniqueCount = *Pointer<UInt>(task + OFFSET(VertexTask,uniqueCount));
 		UInt vertexCount = *Pointer<UInt>(task + OFFSET(VertexTask,vertexCount));
 
 		constants = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData,constants));
 
+		// Shade the unique vertices four at a time, each into the first
+		// primitive vertex which references it.
+		UInt i = 0;
+
 		Do
 		{
-			UInt index = *Pointer<UInt>(batch);
-			UInt tagIndex = index & 0x0000003C;
-			UInt indexQ = !textureSampling ? UInt(index & 0xFFFFFFFC) : index;   // FIXME: TEXLDL hack to have independent LODs, hurts performance.
+			UInt4 index;
+			UInt4 instance;
+			UInt4 slot;
 
-			If(*Pointer<UInt>(tagCache + tagIndex) != indexQ)
+			if(!textureSampling)
 			{
-				*Pointer<UInt>(tagCache + tagIndex) = indexQ;
-
-				readInput(indexQ);
-				program(indexQ);
-				computeClipFlags();
-
-				Pointer<Byte> cacheLine0 = vertexCache + tagIndex * UInt((int)sizeof(Vertex));
-				writeCache(cacheLine0);
+				index = *Pointer<UInt4>(batch + i * 4, 4);
+				instance = *Pointer<UInt4>(instances + i * 4, 4);
+				slot = *Pointer<UInt4>(slots + i * 4, 4);
+				i += 4;
+			}
+			else   // FIXME: TEXLDL hack to have independent LODs, hurts performance.
+			{
+				index = UInt4(*Pointer<UInt>(batch + i * 4));
+				instance = UInt4(*Pointer<UInt>(instances + i * 4));
+				slot = UInt4(*Pointer<UInt>(slots + i * 4));
+				i += 1;
 			}
 
-			UInt cacheIndex = index & 0x0000003F;
-			Pointer<Byte> cacheLine = vertexCache + cacheIndex * UInt((int)sizeof(Vertex));
-			writeVertex(vertex, cacheLine);
+			readInput(index, instance);
+			program(index, instance);
+			computeClipFlags();
+			writeVertices(slot);
+		}
+		Until(i >= uniqueCount)
+
+		// Copy the shaded vertices to the other primitive vertices using them.
+		For(UInt j = 0, j < vertexCount, j++)
+		{
+			UInt source = *Pointer<UInt>(sources + j * 4);
 
-			vertex += sizeof(Vertex);
-			batch += sizeof(unsigned int);
-			vertexCount--;
+			If(source != j)
+			{
+				Pointer<Byte> cacheLine = vertex + source * UInt((int)sizeof(Vertex));
+				writeVertex(vertex + j * UInt((int)sizeof(Vertex)), cacheLine);
+			}
 		}
-		Until(vertexCount == 0)
 
 		Return();
 	}
 
-	void VertexRoutine::readInput(UInt &index)
+	void VertexRoutine::readInput(UInt4 &index, UInt4 &instance)
 	{
 		for(int i = 0; i < MAX_INTERFACE_COMPONENTS; i += 4)
 		{
@@ -94,8 +111,9 @@ namespace sw
 
 				Pointer<Byte> input = *Pointer<Pointer<Byte>>(data + OFFSET(DrawData, input) + sizeof(void *) * (i/4));
 				UInt stride = *Pointer<UInt>(data + OFFSET(DrawData, stride) + sizeof(unsigned int) * (i/4));
+				UInt instanceStride = *Pointer<UInt>(data + OFFSET(DrawData, instanceStride) + sizeof(unsigned int) * (i/4));
 
-				auto value = readStream(input, stride, state.input[i/4], index);
+				auto value = readStream(input, stride, instanceStride, state.input[i/4], index, instance);
 				routine.inputs[i] = value.x;
 				routine.inputs[i+1] = value.y;
 				routine.inputs[i+2] = value.z;
@@ -137,16 +155,16 @@ namespace sw
 		clipFlags |= *Pointer<Int>(constants + OFFSET(Constants,fini) + SignMask(finiteXYZ) * 4);
 	}
 
-	Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, const UInt &index)
+	Vector4f VertexRoutine::readStream(Pointer<Byte> &buffer, UInt &stride, UInt &instanceStride, const Stream &stream, const UInt4 &index, const UInt4 &instance)
 	{
-		const bool textureSampling = state.textureSampling;
-
 		Vector4f v;
 
-		Pointer<Byte> source0 = buffer + index * stride;
-		Pointer<Byte> source1 = source0 + (!textureSampling ? stride : 0);
-		Pointer<Byte> source2 = source1 + (!textureSampling ? stride : 0);
-		Pointer<Byte> source3 = source2 + (!textureSampling ? stride : 0);
+		UInt4 offset = index * UInt4(stride) + instance * UInt4(instanceStride);
+
+		Pointer<Byte> source0 = buffer + Extract(offset, 0);
+		Pointer<Byte> source1 = buffer + Extract(offset, 1);
+		Pointer<Byte> source2 = buffer + Extract(offset, 2);
+		Pointer<Byte> source3 = buffer + Extract(offset, 3);
 
 		bool isNativeFloatAttrib = (stream.attribType == SpirvShader::ATTRIBTYPE_FLOAT) || stream.normalized;
 
@@ -491,8 +509,15 @@ namespace sw
 		return v;
 	}
 
-	void VertexRoutine::writeCache(Pointer<Byte> &cacheLine)
+	void VertexRoutine::writeVertices(const UInt4 &slot)
 	{
+		Pointer<Byte> cacheLine[4];
+
+		for(int i = 0; i < 4; i++)
+		{
+			cacheLine[i] = vertex + Extract(slot, i) * UInt((int)sizeof(Vertex));
+		}
+
 		Vector4f v;
 
 		for (int i = 0; i < MAX_INTERFACE_COMPONENTS; i += 4)
@@ -509,17 +534,17 @@ namespace sw
 
 				transpose4x4(v.x, v.y, v.z, v.w);
 
-				*Pointer<Float4>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 0, 16) = v.x;
-				*Pointer<Float4>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 1, 16) = v.y;
-				*Pointer<Float4>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 2, 16) = v.z;
-				*Pointer<Float4>(cacheLine + OFFSET(Vertex,v[i]) + sizeof(Vertex) * 3, 16) = v.w;
+				*Pointer<Float4>(cacheLine[0] + OFFSET(Vertex,v[i]), 16) = v.x;
+				*Pointer<Float4>(cacheLine[1] + OFFSET(Vertex,v[i]), 16) = v.y;
+				*Pointer<Float4>(cacheLine[2] + OFFSET(Vertex,v[i]), 16) = v.z;
+				*Pointer<Float4>(cacheLine[3] + OFFSET(Vertex,v[i]), 16) = v.w;
 			}
 		}
 
-		*Pointer<Int>(cacheLine + OFFSET(Vertex,clipFlags) + sizeof(Vertex) * 0) = (clipFlags >> 0)  & 0x0000000FF;
-		*Pointer<Int>(cacheLine + OFFSET(Vertex,clipFlags) + sizeof(Vertex) * 1) = (clipFlags >> 8)  & 0x0000000FF;
-		*Pointer<Int>(cacheLine + OFFSET(Vertex,clipFlags) + sizeof(Vertex) * 2) = (clipFlags >> 16) & 0x0000000FF;
-		*Pointer<Int>(cacheLine + OFFSET(Vertex,clipFlags) + sizeof(Vertex) * 3) = (clipFlags >> 24) & 0x0000000FF;
+		*Pointer<Int>(cacheLine[0] + OFFSET(Vertex,clipFlags)) = (clipFlags >> 0)  & 0x0000000FF;
+		*Pointer<Int>(cacheLine[1] + OFFSET(Vertex,clipFlags)) = (clipFlags >> 8)  & 0x0000000FF;
+		*Pointer<Int>(cacheLine[2] + OFFSET(Vertex,clipFlags)) = (clipFlags >> 16) & 0x0000000FF;
+		*Pointer<Int>(cacheLine[3] + OFFSET(Vertex,clipFlags)) = (clipFlags >> 24) & 0x0000000FF;
 
 		// Viewport transform
 		auto it = spirvShader->outputBuiltins.find(spv::BuiltInPosition);
@@ -540,10 +565,10 @@ namespace sw
 		Vector4f v2 = v;
 		transpose4x4(v2.x, v2.y, v2.z, v2.w);
 
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,builtins.position) + sizeof(Vertex) * 0, 16) = v2.x;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,builtins.position) + sizeof(Vertex) * 1, 16) = v2.y;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,builtins.position) + sizeof(Vertex) * 2, 16) = v2.z;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,builtins.position) + sizeof(Vertex) * 3, 16) = v2.w;
+		*Pointer<Float4>(cacheLine[0] + OFFSET(Vertex,builtins.position), 16) = v2.x;
+		*Pointer<Float4>(cacheLine[1] + OFFSET(Vertex,builtins.position), 16) = v2.y;
+		*Pointer<Float4>(cacheLine[2] + OFFSET(Vertex,builtins.position), 16) = v2.z;
+		*Pointer<Float4>(cacheLine[3] + OFFSET(Vertex,builtins.position), 16) = v2.w;
 
 		Float4 w = As<Float4>(As<Int4>(v.w) | (As<Int4>(CmpEQ(v.w, Float4(0.0f))) & As<Int4>(Float4(1.0f))));
 		Float4 rhw = Float4(1.0f) / w;
@@ -555,20 +580,20 @@ namespace sw
 
 		transpose4x4(v.x, v.y, v.z, v.w);
 
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,projected) + sizeof(Vertex) * 0, 16) = v.x;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,projected) + sizeof(Vertex) * 1, 16) = v.y;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,projected) + sizeof(Vertex) * 2, 16) = v.z;
-		*Pointer<Float4>(cacheLine + OFFSET(Vertex,projected) + sizeof(Vertex) * 3, 16) = v.w;
+		*Pointer<Float4>(cacheLine[0] + OFFSET(Vertex,projected), 16) = v.x;
+		*Pointer<Float4>(cacheLine[1] + OFFSET(Vertex,projected), 16) = v.y;
+		*Pointer<Float4>(cacheLine[2] + OFFSET(Vertex,projected), 16) = v.z;
+		*Pointer<Float4>(cacheLine[3] + OFFSET(Vertex,projected), 16) = v.w;
 
 		it = spirvShader->outputBuiltins.find(spv::BuiltInPointSize);
 		if (it != spirvShader->outputBuiltins.end())
 		{
 			assert(it->second.SizeInComponents == 1);
 			auto psize = routine.getVariable(it->second.Id)[it->second.FirstComponent];
-			*Pointer<Float>(cacheLine + OFFSET(Vertex,builtins.pointSize) + sizeof(Vertex) * 0) = Extract(psize, 0);
-			*Pointer<Float>(cacheLine + OFFSET(Vertex,builtins.pointSize) + sizeof(Vertex) * 1) = Extract(psize, 1);
-			*Pointer<Float>(cacheLine + OFFSET(Vertex,builtins.pointSize) + sizeof(Vertex) * 2) = Extract(psize, 2);
-			*Pointer<Float>(cacheLine + OFFSET(Vertex,builtins.pointSize) + sizeof(Vertex) * 3) = Extract(psize, 3);
+			*Pointer<Float>(cacheLine[0] + OFFSET(Vertex,builtins.pointSize)) = Extract(psize, 0);
+			*Pointer<Float>(cacheLine[1] + OFFSET(Vertex,builtins.pointSize)) = Extract(psize, 1);
+			*Pointer<Float>(cacheLine[2] + OFFSET(Vertex,builtins.pointSize)) = Extract(psize, 2);
+			*Pointer<Float>(cacheLine[3] + OFFSET(Vertex,builtins.pointSize)) = Extract(psize, 3);
 		}
 	}
 
@@ -62,14 +62,14 @@ namespace sw
 		SpirvShader const * const spirvShader;
 
 	private:
-		virtual void program(UInt &index) = 0;
+		virtual void program(UInt4 &index, UInt4 &instance) = 0;
 
 		typedef VertexProcessor::State::Input Stream;
 
-		Vector4f readStream(Pointer<Byte> &buffer, UInt &stride, const Stream &stream, const UInt &index);
-		void readInput(UInt &index);
+		Vector4f readStream(Pointer<Byte> &buffer, UInt &stride, UInt &instanceStride, const Stream &stream, const UInt4 &index, const UInt4 &instance);
+		void readInput(UInt4 &index, UInt4 &instance);
 		void computeClipFlags();
-		void writeCache(Pointer<Byte> &cacheLine);
+		void writeVertices(const UInt4 &slot);
 		void writeVertex(const Pointer<Byte> &vertex, Pointer<Byte> &cacheLine);
 	};
 }
@@ -21,7 +21,6 @@
 #include "CPUID.hpp"
 #include "Thread.hpp"
 #include "ExecutableMemory.hpp"
-#include "MutexLock.hpp"
 
 #undef min
 #undef max
@@ -101,17 +100,23 @@ namespace rr
 
 namespace
 {
-	rr::LLVMReactorJIT *reactorJIT = nullptr;
-	llvm::IRBuilder<> *builder = nullptr;
-	llvm::LLVMContext *context = nullptr;
-	llvm::Module *module = nullptr;
-	llvm::Function *function = nullptr;
+	// The state of the routine being built is per thread, so that routines
+	// can be built concurrently. Each thread has its own LLVM context, and
+	// uses a JIT which no other thread is compiling with.
+	thread_local rr::LLVMReactorJIT *reactorJIT = nullptr;
+	thread_local llvm::IRBuilder<> *builder = nullptr;
+	thread_local llvm::LLVMContext *context = nullptr;
+	thread_local llvm::Module *module = nullptr;
+	thread_local llvm::Function *function = nullptr;
 
 #ifdef ENABLE_RR_DEBUG_INFO
-	std::unique_ptr<rr::DebugInfo> debugInfo;
+	thread_local std::unique_ptr<rr::DebugInfo> debugInfo;
 #endif
 
-	rr::MutexLock codegenMutex;
+	// JITs not currently in use by any thread. They are never destroyed,
+	// as they own the code of the routines they compiled.
+	std::mutex jitPoolMutex;
+	std::vector<rr::LLVMReactorJIT*> jitPool;   // guarded by jitPoolMutex
 
 #ifdef ENABLE_RR_PRINT
 	std::string replace(std::string str, const std::string& substr, const std::string& replacement)
@@ -885,19 +890,26 @@ namespace rr
 		}
 	}
 
-	Nucleus::Nucleus()
+	// ThreadContext owns the LLVM context of a thread building routines, and
+	// frees it when the thread exits.
+	struct ThreadContext
 	{
-		::codegenMutex.lock();   // Reactor and LLVM are currently not thread safe
-
-		llvm::InitializeNativeTarget();
-		llvm::InitializeNativeTargetAsmPrinter();
-		llvm::InitializeNativeTargetAsmParser();
+		ThreadContext() : context(new llvm::LLVMContext()), builder(new llvm::IRBuilder<>(*context))
+		{
+		}
 
-		if(!::context)
+		~ThreadContext()
 		{
-			::context = new llvm::LLVMContext();
+			delete builder;
+			delete context;
 		}
 
+		llvm::LLVMContext *context;
+		llvm::IRBuilder<> *builder;
+	};
+
+	static LLVMReactorJIT *createJIT()
+	{
 		#if defined(__x86_64__)
 			static const char arch[] = "x86-64";
 		#elif defined(__i386__)
@@ -950,17 +962,44 @@ namespace rr
 		// targetOpts.NoInfsFPMath = true;
 		// targetOpts.NoNaNsFPMath = true;
 
-		if(!::reactorJIT)
+		return new LLVMReactorJIT(arch, mattrs, targetOpts);
+	}
+
+	static bool initializeNativeTarget()
+	{
+		llvm::InitializeNativeTarget();
+		llvm::InitializeNativeTargetAsmPrinter();
+		llvm::InitializeNativeTargetAsmParser();
+
+		return true;
+	}
+
+	Nucleus::Nucleus()
+	{
+		// LLVM's target registry is global, so it's only initialized once.
+		static bool initialized = initializeNativeTarget();
+		(void)initialized;
+
+		thread_local ThreadContext threadContext;
+		::context = threadContext.context;
+		::builder = threadContext.builder;
+
 		{
-			::reactorJIT = new LLVMReactorJIT(arch, mattrs, targetOpts);
-		}
+			std::unique_lock<std::mutex> lock(::jitPoolMutex);
 
-		::reactorJIT->startSession();
+			if(!::jitPool.empty())
+			{
+				::reactorJIT = ::jitPool.back();
+				::jitPool.pop_back();
+			}
+		}
 
-		if(!::builder)
+		if(!::reactorJIT)
 		{
-			::builder = new llvm::IRBuilder<>(*::context);
+			::reactorJIT = createJIT();
 		}
+
+		::reactorJIT->startSession();
 	}
 
 	Nucleus::~Nucleus()
@@ -971,7 +1010,9 @@ namespace rr
 
 		::reactorJIT->endSession();
 
-		::codegenMutex.unlock();
+		std::unique_lock<std::mutex> lock(::jitPoolMutex);
+		::jitPool.push_back(::reactorJIT);
+		::reactorJIT = nullptr;
 	}
 
 	Routine *Nucleus::acquireRoutine(const char *name, bool runOptimizations)
@@ -4267,7 +4308,7 @@ namespace {
 		llvm::BasicBlock *endBlock = nullptr;
 		llvm::BasicBlock *destroyBlock = nullptr;
 	};
-	CoroutineState coroutine;
+	thread_local CoroutineState coroutine;
 
 	// Magic values retuned by llvm.coro.suspend.
 	// See: https://llvm.org/docs/Coroutines.html#llvm-coro-suspend-intrinsic
@@ -23,8 +23,9 @@
 
 namespace rr
 {
-	// Set of variables that do not have a stack location yet.
-	std::unordered_set<Variable*> Variable::unmaterializedVariables;
+	// Set of variables that do not have a stack location yet, for the
+	// routine being built by the current thread.
+	thread_local std::unordered_set<Variable*> Variable::unmaterializedVariables;
 
 	Variable::Variable(Type *type, int arraySize) : type(type), arraySize(arraySize)
 	{
@@ -136,7 +136,7 @@ namespace rr
 		static void materializeAll();
 		static void killUnmaterialized();
 
-		static std::unordered_set<Variable*> unmaterializedVariables;
+		static thread_local std::unordered_set<Variable*> unmaterializedVariables;
 
 		Type *const type;
 		const int arraySize;
@@ -3145,6 +3145,13 @@ namespace rr
 		return CallHelper<Return(Arguments...)>::Call(fptr, args...);
 	}
 
+	// Calls the function pointer fptr with the given arguments args.
+	template<typename ... Arguments>
+	inline void Call(void(fptr)(Arguments...), CToReactor<Arguments>... args)
+	{
+		CallHelper<void(Arguments...)>::Call(fptr, args...);
+	}
+
 	// Calls the function pointer fptr with the signature FUNCTION_SIGNATURE and
 	// arguments.
 	template<typename FUNCTION_SIGNATURE, typename ... Arguments>
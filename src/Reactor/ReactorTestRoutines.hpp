@@ -0,0 +1,52 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Routines shared by the Reactor unit tests and benchmarks.
+
+#ifndef rr_ReactorTestRoutines_hpp
+#define rr_ReactorTestRoutines_hpp
+
+#include "Reactor.hpp"
+
+namespace rr
+{
+	// Builds a routine computing the polynomial sum(i * x^i) for i in
+	// [0, degree], of each component of the Float4 its first argument points
+	// to, and storing it where its second argument points. Larger degrees
+	// generate more code, which makes compilation time dominate.
+	inline Routine *generatePolynomial(int degree)
+	{
+		Function<Void(Pointer<Float4>, Pointer<Float4>)> function;
+		{
+			Pointer<Float4> in = function.Arg<0>();
+			Pointer<Float4> out = function.Arg<1>();
+
+			Float4 x = *in;
+			Float4 sum = Float4(0.0f);
+			Float4 power = Float4(1.0f);
+
+			for(int i = 0; i <= degree; i++)
+			{
+				sum += power * Float4(float(i));
+				power *= x;
+			}
+
+			*out = sum;
+		}
+
+		return function("polynomial");
+	}
+}
+
+#endif   // rr_ReactorTestRoutines_hpp
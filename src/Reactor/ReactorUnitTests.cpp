@@ -14,10 +14,14 @@
 
 #include "Reactor.hpp"
 #include "Coroutine.hpp"
+#include "ReactorTestRoutines.hpp"
 
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <thread>
 #include <tuple>
+#include <vector>
 
 using namespace rr;
 
@@ -1446,6 +1450,51 @@ TEST(ReactorUnitTests, Coroutines_Parameters)
 	EXPECT_EQ(out, 99);
 }
 
+// Routines are compiled concurrently on several threads, and each must
+// produce its own, correct code.
+TEST(ReactorUnitTests, MultithreadedCompile)
+{
+	const int threadCount = 4;
+	const int routinesPerThread = 4;
+
+	std::vector<std::thread> threads;
+	std::atomic<int> failures(0);
+
+	for(int t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([&failures, t]
+		{
+			for(int i = 0; i < routinesPerThread; i++)
+			{
+				int degree = 4 * t + i;
+				Routine *routine = generatePolynomial(degree);
+				auto callable = (void(*)(float*, float*))routine->getEntry();
+
+				alignas(16) float x[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+				alignas(16) float result[4] = {};
+				callable(x, result);
+
+				// Sum of i * 1^i for i in [0, degree]
+				float expected = float(degree * (degree + 1) / 2);
+
+				if(result[0] != expected || result[3] != expected)
+				{
+					failures++;
+				}
+
+				delete routine;
+			}
+		});
+	}
+
+	for(auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	EXPECT_EQ(failures, 0);
+}
+
 int main(int argc, char **argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
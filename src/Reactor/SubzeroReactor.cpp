@@ -55,16 +55,20 @@
 
 namespace
 {
-	Ice::GlobalContext *context = nullptr;
-	Ice::Cfg *function = nullptr;
-	Ice::CfgNode *basicBlock = nullptr;
-	Ice::CfgLocalAllocatorScope *allocator = nullptr;
-	rr::Routine *routine = nullptr;
-
-	std::mutex codegenMutex;
-
-	Ice::ELFFileStreamer *elfFile = nullptr;
-	Ice::Fdstream *out = nullptr;
+	// The state of the routine being built is per thread, so that routines
+	// can be built concurrently. Each one gets its own Subzero context.
+	thread_local Ice::GlobalContext *context = nullptr;
+	thread_local Ice::Cfg *function = nullptr;
+	thread_local Ice::CfgNode *basicBlock = nullptr;
+	thread_local Ice::CfgLocalAllocatorScope *allocator = nullptr;
+	thread_local rr::Routine *routine = nullptr;
+
+	// Constructing the first Subzero context initializes the target's static
+	// register tables, which must not happen concurrently with code generation.
+	std::mutex contextMutex;
+
+	thread_local Ice::ELFFileStreamer *elfFile = nullptr;
+	thread_local Ice::Fdstream *out = nullptr;
 }
 
 namespace
@@ -530,10 +534,8 @@ namespace rr
 		#endif
 	};
 
-	Nucleus::Nucleus()
+	static bool initializeFlags()
 	{
-		::codegenMutex.lock();   // Reactor is currently not thread safe
-
 		Ice::ClFlags &Flags = Ice::ClFlags::Flags;
 		Ice::ClFlags::getParsedClFlags(Flags);
 
@@ -553,9 +555,20 @@ namespace rr
 		Flags.setVerbose(false ? Ice::IceV_Most : Ice::IceV_None);
 		Flags.setDisableHybridAssembly(true);
 
+		return true;
+	}
+
+	Nucleus::Nucleus()
+	{
+		// The flags are global, so they're only set once.
+		static bool initialized = initializeFlags();
+		(void)initialized;
+
 		static llvm::raw_os_ostream cout(std::cout);
 		static llvm::raw_os_ostream cerr(std::cerr);
 
+		std::unique_lock<std::mutex> lock(::contextMutex);
+
 		if(false)   // Write out to a file
 		{
 			std::error_code errorCode;
@@ -582,7 +595,12 @@ namespace rr
 		delete ::elfFile;
 		delete ::out;
 
-		::codegenMutex.unlock();
+		::routine = nullptr;
+		::allocator = nullptr;
+		::function = nullptr;
+		::context = nullptr;
+		::elfFile = nullptr;
+		::out = nullptr;
 	}
 
 	Routine *Nucleus::acquireRoutine(const char *name, bool runOptimizations)
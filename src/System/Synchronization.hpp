@@ -25,6 +25,8 @@
 #include <assert.h>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <queue>
 
@@ -286,6 +288,131 @@ size_t Chan<T>::count()
 	return queue.size();
 }
 
+
+// Ticket is used to execute work in a fixed order, even when the work becomes
+// ready out of order.
+// Tickets are taken from a Ticket::Queue in the desired order. A ticket is
+// 'called' once all the tickets taken from the queue before it are done.
+// done() must be called on every ticket taken from a queue, whether or not it
+// has been called, otherwise the following tickets will never be called.
+class Ticket
+{
+	struct Record;
+
+	struct Shared
+	{
+		std::mutex mutex;
+		Record *tail = nullptr;   // guarded by mutex
+	};
+
+	struct Record
+	{
+		std::shared_ptr<Shared> shared;
+		std::shared_ptr<Record> next;   // guarded by shared->mutex
+		std::function<void()> onCall;   // guarded by shared->mutex
+		bool isCalled = false;          // guarded by shared->mutex
+		bool isDone = false;            // guarded by shared->mutex
+	};
+
+public:
+	class Queue
+	{
+	public:
+		Queue() : shared(std::make_shared<Shared>()) {}
+
+		// take() returns a ticket which is called once all the tickets
+		// previously taken from this queue are done.
+		Ticket take();
+
+	private:
+		std::shared_ptr<Shared> shared;
+	};
+
+	Ticket() = default;
+
+	// onCall() registers f to be invoked when the ticket is called. If the
+	// ticket has already been called, f is invoked immediately.
+	// f is invoked by the thread calling done() on the previous ticket, so it
+	// should be brief.
+	void onCall(std::function<void()> &&f);
+
+	// done() completes the ticket, calling the next ticket of the queue.
+	void done();
+
+private:
+	Ticket(const std::shared_ptr<Record> &record) : record(record) {}
+
+	std::shared_ptr<Record> record;
+};
+
+inline Ticket Ticket::Queue::take()
+{
+	auto record = std::make_shared<Record>();
+	record->shared = shared;
+
+	std::unique_lock<std::mutex> lock(shared->mutex);
+	if(shared->tail)
+	{
+		shared->tail->next = record;
+	}
+	else
+	{
+		record->isCalled = true;
+	}
+	shared->tail = record.get();
+
+	return Ticket(record);
+}
+
+inline void Ticket::onCall(std::function<void()> &&f)
+{
+	{
+		std::unique_lock<std::mutex> lock(record->shared->mutex);
+		if(!record->isCalled)
+		{
+			record->onCall = std::move(f);
+			return;
+		}
+	}
+
+	f();
+}
+
+inline void Ticket::done()
+{
+	std::function<void()> f;
+
+	{
+		Shared &shared = *record->shared;
+		std::unique_lock<std::mutex> lock(shared.mutex);
+		assert(!record->isDone);
+		record->isDone = true;
+
+		// Tickets which were completed before being called are skipped over.
+		auto current = record;
+		while(current->isCalled && current->isDone)
+		{
+			if(shared.tail == current.get())
+			{
+				shared.tail = nullptr;
+				break;
+			}
+
+			auto next = std::move(current->next);
+			next->isCalled = true;
+			f = std::move(next->onCall);
+			current = std::move(next);
+		}
+	}
+
+	record.reset();
+
+	if(f)
+	{
+		f();
+	}
+}
+
 } // namespace sw
 
 #endif // sw_Synchronization_hpp
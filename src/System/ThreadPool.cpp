@@ -0,0 +1,214 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ThreadPool.hpp"
+
+#include "CPUID.hpp"
+#include "Debug.hpp"
+#include "Synchronization.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	// The pool and worker index of the calling thread, if it is a worker.
+	thread_local sw::ThreadPool *currentPool = nullptr;
+	thread_local int currentWorker = -1;
+
+	// Number of times an idle worker looks for work before parking.
+	const int spinCount = 64;
+}
+
+namespace sw
+{
+	ThreadPool::ThreadPool(int threadCount) : pending(0), idle(0), exit(false)
+	{
+		ASSERT(threadCount > 0);
+
+		for(int i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back(new Worker());
+		}
+
+		for(int i = 0; i < threadCount; i++)
+		{
+			workers[i]->thread = std::thread(&ThreadPool::threadLoop, this, i);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(parkMutex);
+			exit = true;
+			wake.notify_all();
+		}
+
+		for(auto &worker : workers)
+		{
+			worker->thread.join();
+		}
+	}
+
+	void ThreadPool::schedule(Task &&task)
+	{
+		// Parking workers increment idle before checking pending, so either
+		// they observe this task, or we observe them as idle.
+		pending++;
+
+		if(currentPool == this)
+		{
+			Worker &worker = *workers[currentWorker];
+			std::unique_lock<std::mutex> lock(worker.mutex);
+			worker.tasks.push_back(std::move(task));
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lock(injectedMutex);
+			injected.push_back(std::move(task));
+		}
+
+		if(idle > 0)
+		{
+			std::unique_lock<std::mutex> lock(parkMutex);
+			wake.notify_one();
+		}
+	}
+
+	bool ThreadPool::takeLocal(Worker &worker, Task &task)
+	{
+		std::unique_lock<std::mutex> lock(worker.mutex);
+
+		if(worker.tasks.empty())
+		{
+			return false;
+		}
+
+		task = std::move(worker.tasks.back());
+		worker.tasks.pop_back();
+		return true;
+	}
+
+	bool ThreadPool::takeInjected(Task &task)
+	{
+		std::unique_lock<std::mutex> lock(injectedMutex);
+
+		if(injected.empty())
+		{
+			return false;
+		}
+
+		task = std::move(injected.front());
+		injected.pop_front();
+		return true;
+	}
+
+	bool ThreadPool::steal(int thief, Task &task)
+	{
+		int count = getThreadCount();
+
+		for(int i = 1; i < count; i++)
+		{
+			Worker &victim = *workers[(thief + i) % count];
+			std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+
+			if(lock.owns_lock() && !victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::threadLoop(int index)
+	{
+		currentPool = this;
+		currentWorker = index;
+
+		Worker &worker = *workers[index];
+
+		while(true)
+		{
+			Task task;
+
+			for(int spin = 0; spin < spinCount && pending > 0; spin++)
+			{
+				if(takeLocal(worker, task) || takeInjected(task) || steal(index, task))
+				{
+					break;
+				}
+
+				std::this_thread::yield();
+			}
+
+			if(task)
+			{
+				pending--;
+				task();
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(parkMutex);
+			idle++;
+			wake.wait(lock, [this] { return pending > 0 || exit; });
+			idle--;
+
+			if(exit && pending == 0)
+			{
+				return;
+			}
+		}
+	}
+
+	void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &function)
+	{
+		std::atomic<size_t> next(0);
+
+		auto run = [&]()
+		{
+			for(size_t i = next++; i < count; i = next++)
+			{
+				function(i);
+			}
+		};
+
+		size_t batchCount = std::min(count, workers.size());
+
+		WaitGroup wg;
+		for(size_t batch = 1; batch < batchCount; batch++)
+		{
+			wg.add();
+			schedule([&]()
+			{
+				run();
+				wg.done();
+			});
+		}
+
+		// The calling thread only waits for the workers once it has run out
+		// of indices itself.
+		run();
+
+		wg.wait();
+	}
+
+	ThreadPool &ThreadPool::get()
+	{
+		static ThreadPool pool(CPUID::processAffinity());
+		return pool;
+	}
+}
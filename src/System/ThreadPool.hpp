@@ -0,0 +1,96 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef sw_ThreadPool_hpp
+#define sw_ThreadPool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sw
+{
+	// ThreadPool is a fixed set of worker threads which execute the tasks
+	// passed to schedule().
+	//
+	// Each worker owns a deque of tasks. Tasks scheduled by a worker are
+	// pushed onto its own deque and executed most-recent-first, so that
+	// continuations run while their inputs are still in cache. Tasks
+	// scheduled from outside the pool are executed in the order they were
+	// scheduled. Workers which run out of tasks steal the oldest task of the
+	// other workers, and are parked when there is no work left anywhere.
+	//
+	// Tasks must not block waiting on other tasks of the same pool, as there
+	// is no guarantee that those will be started.
+	class ThreadPool
+	{
+	public:
+		using Task = std::function<void()>;
+
+		ThreadPool(int threadCount);
+
+		// The destructor completes all the scheduled tasks before joining
+		// the worker threads.
+		~ThreadPool();
+
+		// schedule() queues the task for execution on a worker thread.
+		void schedule(Task &&task);
+
+		// parallelFor() calls function(i) for each i in [0, count), and returns
+		// once all the calls have completed. The calling thread runs calls
+		// itself, alongside up to getThreadCount() - 1 workers. Indices are
+		// claimed one at a time, so that threads finishing early pick up the
+		// remaining work.
+		void parallelFor(size_t count, const std::function<void(size_t)> &function);
+
+		int getThreadCount() const { return static_cast<int>(workers.size()); }
+
+		// get() returns the process-wide pool, which has a worker for each
+		// core the process may run on.
+		static ThreadPool &get();
+
+	private:
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<Task> tasks;   // guarded by mutex
+			std::thread thread;
+		};
+
+		void threadLoop(int index);
+
+		bool takeLocal(Worker &worker, Task &task);
+		bool takeInjected(Task &task);
+		bool steal(int thief, Task &task);
+
+		std::vector<std::unique_ptr<Worker>> workers;
+
+		std::mutex injectedMutex;
+		std::deque<Task> injected;   // guarded by injectedMutex
+
+		std::atomic<int> pending;   // Number of scheduled tasks not yet started
+		std::atomic<int> idle;      // Number of parked workers
+		std::atomic<bool> exit;
+
+		std::mutex parkMutex;
+		std::condition_variable wake;
+	};
+}
+
+#endif   // sw_ThreadPool_hpp
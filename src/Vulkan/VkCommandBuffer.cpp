@@ -155,6 +155,11 @@ protected:
 	void play(CommandBuffer::ExecutionState& executionState) override
 	{
 		executionState.pipelineState[pipelineBindPoint].pipeline = Cast(pipeline);
+
+		if(pipelineBindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS)
+		{
+			static_cast<GraphicsPipeline*>(Cast(pipeline))->bindRoutines(executionState.renderer);
+		}
 	}
 
 private:
@@ -182,6 +187,9 @@ protected:
 			pipelineState.descriptorSets,
 			pipelineState.descriptorDynamicOffsets,
 			executionState.pushConstants);
+
+		executionState.renderer->addComputeInvocations(
+			int64_t(groupCountX) * groupCountY * groupCountZ * pipeline->getWorkgroupInvocations());
 	}
 
 private:
@@ -213,6 +221,9 @@ protected:
 			pipelineState.descriptorSets,
 			pipelineState.descriptorDynamicOffsets,
 			executionState.pushConstants);
+
+		executionState.renderer->addComputeInvocations(
+			int64_t(cmd->x) * cmd->y * cmd->z * pipeline->getWorkgroupInvocations());
 	}
 
 private:
@@ -563,6 +574,7 @@ struct DrawBase : public CommandBuffer::Command
 
 		context.multiSampleMask = context.sampleMask & ((unsigned)0xFFFFFFFF >> (32 - context.sampleCount));
 		context.occlusionEnabled = executionState.renderer->hasQueryOfType(VK_QUERY_TYPE_OCCLUSION);
+		context.statisticsEnabled = executionState.renderer->hasQueryOfType(VK_QUERY_TYPE_PIPELINE_STATISTICS);
 
 		std::vector<std::pair<uint32_t, void*>> indexBuffers;
 		if(indexed)
@@ -593,6 +605,26 @@ struct DrawBase : public CommandBuffer::Command
 			indexBuffers.push_back({ pipeline->computePrimitiveCount(count), nullptr });
 		}
 
+		// The vertex routine was generated at pipeline creation, for the state
+		// of the pipeline's context. Draw state must not change it.
+		ASSERT(sw::VertexProcessor::update(&context) == pipeline->getVertexState());
+
+		context.instanceID = firstInstance;
+
+		// A single index buffer segment is drawn for all instances at once.
+		// Several segments from primitive restart are drawn one instance at a
+		// time, to keep the primitives of each instance in order.
+		if(indexBuffers.size() == 1 && uint64_t(indexBuffers[0].first) * instanceCount <= INT32_MAX)
+		{
+			context.indexBuffer = indexBuffers[0].second;
+			executionState.renderer->draw(&context, executionState.indexType, indexBuffers[0].first, instanceCount, vertexOffset, executionState.events);
+			return;
+		}
+
+		// The state is the same for every segment and instance, so it only
+		// needs to be processed by the first draw.
+		bool update = true;
+
 		for(uint32_t instance = firstInstance; instance != firstInstance + instanceCount; instance++)
 		{
 			context.instanceID = instance;
@@ -601,7 +633,8 @@ struct DrawBase : public CommandBuffer::Command
 			{
 				const uint32_t primitiveCount = indexBuffer.first;
 				context.indexBuffer = indexBuffer.second;
-				executionState.renderer->draw(&context, executionState.indexType, primitiveCount, vertexOffset, executionState.events);
+				executionState.renderer->draw(&context, executionState.indexType, primitiveCount, 1, vertexOffset, executionState.events, update);
+				update = false;
 			}
 
 			executionState.renderer->advanceInstanceAttributes(context.input);
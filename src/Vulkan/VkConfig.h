@@ -72,6 +72,31 @@ enum
 			MAX_DESCRIPTOR_SET_STORAGE_BUFFERS_DYNAMIC,
 };
 
+enum
+{
+	// Device memory allocations of at least this many bytes are mapped
+	// directly, so that their pages are only committed when first touched.
+	DEVICE_MEMORY_MAPPING_THRESHOLD = 0x40000,
+};
+
+enum
+{
+	// Sampled images get a copy of their texels in 4x4 tiles only when their
+	// rows are at least this long, and their first level at most this large.
+	// The copy is as large as the linear image, so each tiled image needs up
+	// to 16 MB more memory for its first level, and a third of that again for
+	// a full mipmap chain. A maximum size of 0 disables the tiled copies.
+	TILED_IMAGE_MIN_ROW_BYTES = 1024,
+	TILED_IMAGE_MAX_SIZE = 0x1000000,
+};
+
+enum
+{
+	// Each queue executes its submissions on its own thread, while the
+	// renderers of all queues share one worker pool.
+	QUEUE_COUNT = 4,
+};
+
 enum
 {
 	MAX_POINT_SIZE = 1,		// Large points are not supported. If/when we turn this on, must be >= 64.
@@ -316,6 +316,7 @@ void DescriptorSetLayout::WriteDescriptorSet(DescriptorSet *dstSet, VkDescriptor
 			imageSampler[i].arrayLayers = 1;
 			imageSampler[i].mipLevels = 1;
 			imageSampler[i].sampleCount = 1;
+			imageSampler[i].tiled = false;
 			imageSampler[i].texture.widthWidthHeightHeight = sw::vector(numElements, numElements, 1, 1);
 			imageSampler[i].texture.width = sw::replicate(numElements);
 			imageSampler[i].texture.height = sw::replicate(1);
@@ -344,8 +345,6 @@ void DescriptorSetLayout::WriteDescriptorSet(DescriptorSet *dstSet, VkDescriptor
 			vk::ImageView *imageView = vk::Cast(update->imageView);
 			Format format = imageView->getFormat(ImageView::SAMPLING);
 
-			sw::Texture *texture = &imageSampler[i].texture;
-
 			// "All consecutive bindings updated via a single VkWriteDescriptorSet structure, except those with a
 			//  descriptorCount of zero, must all either use immutable samplers or must all not use immutable samplers."
 			if(!binding.pImmutableSamplers)
@@ -361,75 +360,9 @@ void DescriptorSetLayout::WriteDescriptorSet(DescriptorSet *dstSet, VkDescriptor
 			imageSampler[i].type = imageView->getType();
 			imageSampler[i].swizzle = imageView->getComponentMapping();
 			imageSampler[i].format = format;
+			imageSampler[i].tiled = imageView->isSampledImageTiled();
 
-			auto &subresourceRange = imageView->getSubresourceRange();
-
-			if(format.isYcbcrFormat())
-			{
-				ASSERT(subresourceRange.levelCount == 1);
-
-				// YCbCr images can only have one level, so we can store parameters for the
-				// different planes in the descriptor's mipmap levels instead.
-
-				const int level = 0;
-				VkOffset3D offset = {0, 0, 0};
-				texture->mipmap[0].buffer = imageView->getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_0_BIT, level, 0, ImageView::SAMPLING);
-				texture->mipmap[1].buffer = imageView->getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_1_BIT, level, 0, ImageView::SAMPLING);
-				if(format.getAspects() & VK_IMAGE_ASPECT_PLANE_2_BIT)
-				{
-					texture->mipmap[2].buffer = imageView->getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_2_BIT, level, 0, ImageView::SAMPLING);
-				}
-
-				VkExtent3D extent = imageView->getMipLevelExtent(0);
-
-				int width = extent.width;
-				int height = extent.height;
-				int pitchP0 = imageView->rowPitchBytes(VK_IMAGE_ASPECT_PLANE_0_BIT, level, ImageView::SAMPLING) /
-				              imageView->getFormat(VK_IMAGE_ASPECT_PLANE_0_BIT).bytes();
-
-				// Write plane 0 parameters to mipmap level 0.
-				WriteTextureLevelInfo(texture, 0, width, height, 1, pitchP0, 0);
-
-				// Plane 2, if present, has equal parameters to plane 1, so we use mipmap level 1 for both.
-				int pitchP1 = imageView->rowPitchBytes(VK_IMAGE_ASPECT_PLANE_1_BIT, level, ImageView::SAMPLING) /
-				              imageView->getFormat(VK_IMAGE_ASPECT_PLANE_1_BIT).bytes();
-
-				WriteTextureLevelInfo(texture, 1, width / 2, height / 2, 1, pitchP1, 0);
-			}
-			else
-			{
-				for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
-				{
-					int level = sw::clamp(mipmapLevel, 0, (int)subresourceRange.levelCount - 1);  // Level within the image view
-
-					VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(imageView->getSubresourceRange().aspectMask);
-					sw::Mipmap &mipmap = texture->mipmap[mipmapLevel];
-
-					if(imageView->getType() == VK_IMAGE_VIEW_TYPE_CUBE)
-					{
-						// Obtain the pointer to the corner of the level including the border, for seamless sampling.
-						// This is taken into account in the sampling routine, which can't handle negative texel coordinates.
-						VkOffset3D offset = {-1, -1, 0};
-						mipmap.buffer = imageView->getOffsetPointer(offset, aspect, level, 0, ImageView::SAMPLING);
-					}
-					else
-					{
-						VkOffset3D offset = {0, 0, 0};
-						mipmap.buffer = imageView->getOffsetPointer(offset, aspect, level, 0, ImageView::SAMPLING);
-					}
-
-					VkExtent3D extent = imageView->getMipLevelExtent(level);
-
-					int width = extent.width;
-					int height = extent.height;
-					int layers = imageView->getSubresourceRange().layerCount;  // TODO(b/129523279): Untangle depth vs layers throughout the sampler
-					int depth = layers > 1 ? layers : extent.depth;
-					int pitchP = imageView->rowPitchBytes(aspect, level, ImageView::SAMPLING) / format.bytes();
-					int sliceP = (layers > 1 ? imageView->layerPitchBytes(aspect, ImageView::SAMPLING) : imageView->slicePitchBytes(aspect, level, ImageView::SAMPLING)) / format.bytes();
-
-					WriteTextureLevelInfo(texture, mipmapLevel, width, height, depth, pitchP, sliceP);
-				}
-			}
+			imageSampler[i].texture = imageView->getSampledTexture();
 		}
 	}
 	else if (entry.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
@@ -496,83 +429,6 @@ void DescriptorSetLayout::WriteDescriptorSet(DescriptorSet *dstSet, VkDescriptor
 	}
 }
 
-void DescriptorSetLayout::WriteTextureLevelInfo(sw::Texture *texture, int level, int width, int height, int depth, int pitchP, int sliceP)
-{
-	if(level == 0)
-	{
-		texture->widthWidthHeightHeight[0] = width;
-		texture->widthWidthHeightHeight[1] = width;
-		texture->widthWidthHeightHeight[2] = height;
-		texture->widthWidthHeightHeight[3] = height;
-
-		texture->width[0] = width;
-		texture->width[1] = width;
-		texture->width[2] = width;
-		texture->width[3] = width;
-
-		texture->height[0] = height;
-		texture->height[1] = height;
-		texture->height[2] = height;
-		texture->height[3] = height;
-
-		texture->depth[0] = depth;
-		texture->depth[1] = depth;
-		texture->depth[2] = depth;
-		texture->depth[3] = depth;
-	}
-
-	sw::Mipmap &mipmap = texture->mipmap[level];
-
-	short halfTexelU = 0x8000 / width;
-	short halfTexelV = 0x8000 / height;
-	short halfTexelW = 0x8000 / depth;
-
-	mipmap.uHalf[0] = halfTexelU;
-	mipmap.uHalf[1] = halfTexelU;
-	mipmap.uHalf[2] = halfTexelU;
-	mipmap.uHalf[3] = halfTexelU;
-
-	mipmap.vHalf[0] = halfTexelV;
-	mipmap.vHalf[1] = halfTexelV;
-	mipmap.vHalf[2] = halfTexelV;
-	mipmap.vHalf[3] = halfTexelV;
-
-	mipmap.wHalf[0] = halfTexelW;
-	mipmap.wHalf[1] = halfTexelW;
-	mipmap.wHalf[2] = halfTexelW;
-	mipmap.wHalf[3] = halfTexelW;
-
-	mipmap.width[0] = width;
-	mipmap.width[1] = width;
-	mipmap.width[2] = width;
-	mipmap.width[3] = width;
-
-	mipmap.height[0] = height;
-	mipmap.height[1] = height;
-	mipmap.height[2] = height;
-	mipmap.height[3] = height;
-
-	mipmap.depth[0] = depth;
-	mipmap.depth[1] = depth;
-	mipmap.depth[2] = depth;
-	mipmap.depth[3] = depth;
-
-	mipmap.onePitchP[0] = 1;
-	mipmap.onePitchP[1] = pitchP;
-	mipmap.onePitchP[2] = 1;
-	mipmap.onePitchP[3] = pitchP;
-
-	mipmap.pitchP[0] = pitchP;
-	mipmap.pitchP[1] = pitchP;
-	mipmap.pitchP[2] = pitchP;
-	mipmap.pitchP[3] = pitchP;
-
-	mipmap.sliceP[0] = sliceP;
-	mipmap.sliceP[1] = sliceP;
-	mipmap.sliceP[2] = sliceP;
-	mipmap.sliceP[3] = sliceP;
-}
-
 void DescriptorSetLayout::WriteDescriptorSet(const VkWriteDescriptorSet& writeDescriptorSet)
 {
 	DescriptorSet* dstSet = vk::Cast(writeDescriptorSet.dstSet);
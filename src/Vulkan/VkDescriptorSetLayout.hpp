@@ -43,6 +43,7 @@ struct alignas(16) SampledImageDescriptor
 	int arrayLayers;
 	int mipLevels;
 	int sampleCount;
+	bool tiled;
 };
 
 struct alignas(16) StorageImageDescriptor
@@ -82,7 +83,6 @@ public:
 	static void CopyDescriptorSet(const VkCopyDescriptorSet& descriptorCopies);
 
 	static void WriteDescriptorSet(DescriptorSet *dstSet, VkDescriptorUpdateTemplateEntry const &entry, char const *src);
-	static void WriteTextureLevelInfo(sw::Texture *texture, int level, int width, int height, int depth, int pitchP, int sliceP);
 
 	void initialize(VkDescriptorSet descriptorSet);
 
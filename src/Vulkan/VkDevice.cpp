@@ -198,6 +198,70 @@ VkResult Device::waitIdle()
 	return VK_SUCCESS;
 }
 
+int64_t Device::getCoarseDepthTestCount() const
+{
+	int64_t count = 0;
+	for(uint32_t i = 0; i < queueCount; i++)
+	{
+		count += queues[i].getRenderer().getCoarseDepthTestCount();
+	}
+
+	return count;
+}
+
+int64_t Device::getCoarseDepthCullCount() const
+{
+	int64_t count = 0;
+	for(uint32_t i = 0; i < queueCount; i++)
+	{
+		count += queues[i].getRenderer().getCoarseDepthCullCount();
+	}
+
+	return count;
+}
+
+double Device::getCoarseDepthCullRate() const
+{
+	int64_t tested = getCoarseDepthTestCount();
+	return tested ? static_cast<double>(getCoarseDepthCullCount()) / tested : 0.0;
+}
+
+int64_t Device::getShadedVertexCount() const
+{
+	int64_t count = 0;
+	for(uint32_t i = 0; i < queueCount; i++)
+	{
+		count += queues[i].getRenderer().getShadedVertexCount();
+	}
+
+	return count;
+}
+
+int64_t Device::getShadedPrimitiveCount() const
+{
+	int64_t count = 0;
+	for(uint32_t i = 0; i < queueCount; i++)
+	{
+		count += queues[i].getRenderer().getShadedPrimitiveCount();
+	}
+
+	return count;
+}
+
+double Device::getShadedVerticesPerPrimitive() const
+{
+	int64_t primitives = getShadedPrimitiveCount();
+	return primitives ? static_cast<double>(getShadedVertexCount()) / primitives : 0.0;
+}
+
+void Device::resetShadingCounts()
+{
+	for(uint32_t i = 0; i < queueCount; i++)
+	{
+		queues[i].getRenderer().resetShadingCounts();
+	}
+}
+
 void Device::getDescriptorSetLayoutSupport(const VkDescriptorSetLayoutCreateInfo* pCreateInfo,
                                            VkDescriptorSetLayoutSupport* pSupport) const
 {
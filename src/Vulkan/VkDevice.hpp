@@ -49,6 +49,17 @@ public:
 	                          uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies);
 	sw::Blitter* getBlitter() const { return blitter; }
 
+	// Coarse depth culling totals over the draw calls of all of the queues.
+	int64_t getCoarseDepthTestCount() const;
+	int64_t getCoarseDepthCullCount() const;
+	double getCoarseDepthCullRate() const;
+
+	// Vertex shading totals over the draw calls of all of the queues.
+	int64_t getShadedVertexCount() const;
+	int64_t getShadedPrimitiveCount() const;
+	double getShadedVerticesPerPrimitive() const;
+	void resetShadingCounts();
+
 private:
 	PhysicalDevice *physicalDevice = nullptr;
 	Queue* queues = nullptr;
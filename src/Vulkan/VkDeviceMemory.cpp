@@ -16,6 +16,36 @@
 
 #include "VkConfig.h"
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#endif
+
+namespace
+{
+
+#if defined(__linux__)
+// Creates an anonymous shared memory file. Returns -1 on failure.
+// The system call is used directly, since not all C libraries wrap it.
+int createMemoryFile(const char* name)
+{
+	#ifdef __NR_memfd_create
+		return static_cast<int>(syscall(__NR_memfd_create, name, MFD_CLOEXEC));
+	#else
+		return -1;
+	#endif
+}
+#endif
+
+}  // anonymous namespace
+
 namespace vk
 {
 
@@ -23,10 +53,65 @@ DeviceMemory::DeviceMemory(const VkMemoryAllocateInfo* pCreateInfo, void* mem) :
 	size(pCreateInfo->allocationSize), memoryTypeIndex(pCreateInfo->memoryTypeIndex)
 {
 	ASSERT(size);
+
+	const VkBaseInStructure* allocationInfo = reinterpret_cast<const VkBaseInStructure*>(pCreateInfo->pNext);
+	while(allocationInfo)
+	{
+		switch(allocationInfo->sType)
+		{
+#if defined(__linux__)
+		case VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO:
+		{
+			const VkExportMemoryAllocateInfo* exportInfo = reinterpret_cast<const VkExportMemoryAllocateInfo*>(allocationInfo);
+			exportable = (exportInfo->handleTypes & VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT) != 0;
+		}
+		break;
+		case VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR:
+		{
+			const VkImportMemoryFdInfoKHR* importInfo = reinterpret_cast<const VkImportMemoryFdInfoKHR*>(allocationInfo);
+			if(importInfo->handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT)
+			{
+				importFd = importInfo->fd;
+			}
+		}
+		break;
+#endif
+		case VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT:
+		{
+			const VkImportMemoryHostPointerInfoEXT* importInfo = reinterpret_cast<const VkImportMemoryHostPointerInfoEXT*>(allocationInfo);
+			hostPointer = importInfo->pHostPointer;
+		}
+		break;
+		default:
+			// Validated by vkAllocateMemory()
+			break;
+		}
+
+		allocationInfo = allocationInfo->pNext;
+	}
 }
 
 void DeviceMemory::destroy(const VkAllocationCallbacks* pAllocator)
 {
+	if(hostPointer)
+	{
+		return;   // Freed by its owner
+	}
+
+#if defined(__linux__)
+	if(mapped)
+	{
+		munmap(buffer, size);
+
+		if(fd >= 0)
+		{
+			close(fd);
+		}
+
+		return;
+	}
+#endif
+
 	vk::deallocate(buffer, DEVICE_MEMORY);
 }
 
@@ -38,8 +123,22 @@ size_t DeviceMemory::ComputeRequiredAllocationSize(const VkMemoryAllocateInfo* p
 
 VkResult DeviceMemory::allocate()
 {
+	if(hostPointer)
+	{
+		buffer = hostPointer;
+	}
+
 	if(!buffer)
 	{
+#if defined(__linux__)
+		// Mapped memory is zero-filled by the kernel on first touch, instead
+		// of being committed and cleared up front.
+		if(exportable || (importFd >= 0) || (size >= DEVICE_MEMORY_MAPPING_THRESHOLD))
+		{
+			return allocateMapping();
+		}
+#endif
+
 		buffer = vk::allocate(size, REQUIRED_MEMORY_ALIGNMENT, DEVICE_MEMORY);
 	}
 
@@ -51,6 +150,76 @@ VkResult DeviceMemory::allocate()
 	return VK_SUCCESS;
 }
 
+#if defined(__linux__)
+VkResult DeviceMemory::allocateMapping()
+{
+	int file = -1;
+
+	if(importFd >= 0)
+	{
+		struct stat status;
+		if((fstat(importFd, &status) != 0) || (static_cast<VkDeviceSize>(status.st_size) < size))
+		{
+			return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+		}
+
+		file = importFd;
+	}
+	else if(exportable)
+	{
+		file = createMemoryFile("SwiftShader DeviceMemory");
+		if(file < 0)
+		{
+			return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		}
+
+		if(ftruncate(file, size) != 0)
+		{
+			close(file);
+			return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+		}
+	}
+
+	void* mapping = (file >= 0) ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0)
+	                            : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if(mapping == MAP_FAILED)
+	{
+		if(importFd >= 0)
+		{
+			return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+		}
+
+		if(file >= 0)
+		{
+			close(file);
+		}
+
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
+
+	// The file descriptor of a successful import is owned by the implementation.
+	buffer = mapping;
+	mapped = true;
+	fd = file;
+
+	return VK_SUCCESS;
+}
+
+VkResult DeviceMemory::exportFd(int* pFd) const
+{
+	if(fd < 0)
+	{
+		return VK_ERROR_INVALID_EXTERNAL_HANDLE;
+	}
+
+	// Each export returns a new reference to the memory, owned by the application.
+	*pFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+
+	return (*pFd >= 0) ? VK_SUCCESS : VK_ERROR_TOO_MANY_OBJECTS;
+}
+#endif
+
 VkResult DeviceMemory::map(VkDeviceSize pOffset, VkDeviceSize pSize, void** ppData)
 {
 	*ppData = getOffsetPointer(pOffset);
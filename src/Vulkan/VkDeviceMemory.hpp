@@ -34,10 +34,23 @@ public:
 	void* getOffsetPointer(VkDeviceSize pOffset);
 	uint32_t getMemoryTypeIndex() const { return memoryTypeIndex; }
 
+#if defined(__linux__)
+	VkResult exportFd(int* pFd) const;
+#endif
+
 private:
+#if defined(__linux__)
+	VkResult allocateMapping();
+#endif
+
 	void*        buffer = nullptr;
 	VkDeviceSize size = 0;
 	uint32_t     memoryTypeIndex = 0;
+	bool         mapped = false;    // buffer is a memory mapping, rather than a heap allocation
+	bool         exportable = false;
+	int          importFd = -1;     // Owned once the import succeeds
+	int          fd = -1;           // Shared memory file backing the mapping, if any
+	void*        hostPointer = nullptr;   // Imported memory, freed by its owner
 };
 
 static inline DeviceMemory* Cast(VkDeviceMemory object)
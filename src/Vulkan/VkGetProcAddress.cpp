@@ -87,6 +87,8 @@ static const std::unordered_map<std::string, PFN_vkVoidFunction> instanceFunctio
 	MAKE_VULKAN_INSTANCE_ENTRY(vkGetPhysicalDeviceSurfaceCapabilitiesKHR),
 	MAKE_VULKAN_INSTANCE_ENTRY(vkGetPhysicalDeviceSurfaceFormatsKHR),
 	MAKE_VULKAN_INSTANCE_ENTRY(vkGetPhysicalDeviceSurfacePresentModesKHR),
+	// VK_EXT_headless_surface
+	MAKE_VULKAN_INSTANCE_ENTRY(vkCreateHeadlessSurfaceEXT),
 #endif
 #ifdef VK_USE_PLATFORM_XLIB_KHR
 	// VK_KHR_xlib_surface
@@ -303,6 +305,16 @@ static const std::vector<std::pair<const char*, std::unordered_map<std::string,
 			MAKE_VULKAN_DEVICE_ENTRY(vkGetDescriptorSetLayoutSupportKHR),
 		}
 	},
+#if defined(__linux__)
+	// VK_KHR_external_memory_fd
+	{
+		VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
+		{
+			MAKE_VULKAN_DEVICE_ENTRY(vkGetMemoryFdKHR),
+			MAKE_VULKAN_DEVICE_ENTRY(vkGetMemoryFdPropertiesKHR),
+		}
+	},
+#endif
 #ifndef __ANDROID__
 	// VK_KHR_swapchain
 	{
@@ -17,11 +17,22 @@
 #include "VkDevice.hpp"
 #include "VkImage.hpp"
 #include "Device/Blitter.hpp"
+#include "Device/CoarseDepth.hpp"
+#include "Device/Config.hpp"
 #include "Device/ETC_Decoder.hpp"
+#include "System/Math.hpp"
+#include "System/ThreadPool.hpp"
+#include <algorithm>
 #include <cstring>
+#include <vector>
 
 namespace
 {
+	// Texels written at once above which ETC2/EAC decoding is split across the
+	// thread pool, in bands of this many texel rows.
+	const int64_t ETC_PARALLEL_TEXELS = 0x10000;
+	const int ETC_BAND_HEIGHT = 16;
+
 	ETC_Decoder::InputType GetInputType(const vk::Format& format)
 	{
 		switch(format)
@@ -48,6 +59,53 @@ namespace
 			return ETC_Decoder::ETC_RGBA;
 		}
 	}
+
+	// Images which are only written by transfer commands get a second copy of
+	// their texels stored in 4x4 tiles, which is updated after each transfer and
+	// read by the sampler instead. This keeps the texels of a bilinear footprint,
+	// and the rows walked by minification, in the same cache lines. Narrow
+	// images already have nearby rows, and the copy of large ones would cost
+	// too much memory, so only the sizes in between are tiled.
+	bool UseTiledSampledImage(const VkImageCreateInfo* pCreateInfo)
+	{
+		const VkImageUsageFlags sampledTransferUsage = VK_IMAGE_USAGE_SAMPLED_BIT |
+		                                               VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+		                                               VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		const VkImageCreateFlags layoutDependentFlags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT |
+		                                                VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT |
+		                                                VK_IMAGE_CREATE_ALIAS_BIT;
+		vk::Format format(pCreateInfo->format);
+		uint64_t rowBytes = static_cast<uint64_t>(pCreateInfo->extent.width) * format.bytes();
+		uint64_t size = rowBytes * pCreateInfo->extent.height * pCreateInfo->arrayLayers;
+
+		return (pCreateInfo->imageType == VK_IMAGE_TYPE_2D) &&
+		       (pCreateInfo->tiling == VK_IMAGE_TILING_OPTIMAL) &&
+		       (pCreateInfo->samples == VK_SAMPLE_COUNT_1_BIT) &&
+		       (rowBytes >= vk::TILED_IMAGE_MIN_ROW_BYTES) &&
+		       (size <= vk::TILED_IMAGE_MAX_SIZE) &&
+		       ((pCreateInfo->flags & layoutDependentFlags) == 0) &&
+		       (pCreateInfo->usage & VK_IMAGE_USAGE_SAMPLED_BIT) &&
+		       (pCreateInfo->usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) &&
+		       ((pCreateInfo->usage & ~sampledTransferUsage) == 0) &&
+		       !format.isCompressed() && !format.isYcbcrFormat() &&
+		       !format.isDepth() && !format.isStencil();
+	}
+
+	// Single subresource depth attachments keep coarse depth bounds for culling
+	// occluded primitives.
+	bool UseCoarseDepth(const VkImageCreateInfo* pCreateInfo)
+	{
+		vk::Format format(pCreateInfo->format);
+
+		return (pCreateInfo->imageType == VK_IMAGE_TYPE_2D) &&
+		       (pCreateInfo->tiling == VK_IMAGE_TILING_OPTIMAL) &&
+		       (pCreateInfo->mipLevels == 1) &&
+		       (pCreateInfo->arrayLayers == 1) &&
+		       ((pCreateInfo->flags & VK_IMAGE_CREATE_ALIAS_BIT) == 0) &&
+		       (pCreateInfo->usage & VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) &&
+		       format.isDepth() &&
+		       sw::CoarseDepth::isSupported(format.getAspectFormat(VK_IMAGE_ASPECT_DEPTH_BIT));
+	}
 }
 
 namespace vk
@@ -70,6 +128,21 @@ Image::Image(const VkImageCreateInfo* pCreateInfo, void* mem, Device *device) :
 		VkImageCreateInfo compressedImageCreateInfo = *pCreateInfo;
 		compressedImageCreateInfo.format = format.getDecompressedFormat();
 		decompressedImage = new (mem) Image(&compressedImageCreateInfo, nullptr, device);
+		dirtyRegions = new VkRect2D[mipLevels * arrayLayers]();
+	}
+	else if(UseTiledSampledImage(pCreateInfo))
+	{
+		// The tiled copy is only ever sampled, so it doesn't get a copy of its own.
+		VkImageCreateInfo tiledImageCreateInfo = *pCreateInfo;
+		tiledImageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+		tiledImage = new (mem) Image(&tiledImageCreateInfo, nullptr, device);
+		tiledImage->tiled = true;
+		dirtyRegions = new VkRect2D[mipLevels * arrayLayers]();
+	}
+
+	if(UseCoarseDepth(pCreateInfo))
+	{
+		coarseDepth = new sw::CoarseDepth(extent.width, extent.height, getFormat(VK_IMAGE_ASPECT_DEPTH_BIT));
 	}
 }
 
@@ -79,11 +152,19 @@ void Image::destroy(const VkAllocationCallbacks* pAllocator)
 	{
 		vk::deallocate(decompressedImage, pAllocator);
 	}
+
+	if(tiledImage)
+	{
+		vk::deallocate(tiledImage, pAllocator);
+	}
+
+	delete coarseDepth;
+	delete[] dirtyRegions;
 }
 
 size_t Image::ComputeRequiredAllocationSize(const VkImageCreateInfo* pCreateInfo)
 {
-	return Format(pCreateInfo->format).isCompressed() ? sizeof(Image) : 0;
+	return (Format(pCreateInfo->format).isCompressed() || UseTiledSampledImage(pCreateInfo)) ? sizeof(Image) : 0;
 }
 
 const VkMemoryRequirements Image::getMemoryRequirements() const
@@ -92,7 +173,8 @@ const VkMemoryRequirements Image::getMemoryRequirements() const
 	memoryRequirements.alignment = vk::REQUIRED_MEMORY_ALIGNMENT;
 	memoryRequirements.memoryTypeBits = vk::MEMORY_TYPE_GENERIC_BIT;
 	memoryRequirements.size = getStorageSize(format.getAspects()) +
-	                          (decompressedImage ? decompressedImage->getStorageSize(decompressedImage->format.getAspects()) : 0);
+	                          (decompressedImage ? decompressedImage->getStorageSize(decompressedImage->format.getAspects()) : 0) +
+	                          (tiledImage ? tiledImage->getStorageSize(tiledImage->format.getAspects()) : 0);
 	return memoryRequirements;
 }
 
@@ -105,6 +187,15 @@ void Image::bind(VkDeviceMemory pDeviceMemory, VkDeviceSize pMemoryOffset)
 		decompressedImage->deviceMemory = deviceMemory;
 		decompressedImage->memoryOffset = memoryOffset + getStorageSize(format.getAspects());
 	}
+	if(tiledImage)
+	{
+		tiledImage->deviceMemory = deviceMemory;
+		tiledImage->memoryOffset = memoryOffset + getStorageSize(format.getAspects());
+	}
+	if(coarseDepth)
+	{
+		coarseDepth->invalidate();
+	}
 }
 
 void Image::getSubresourceLayout(const VkImageSubresource* pSubresource, VkSubresourceLayout* pLayout) const
@@ -160,6 +251,13 @@ void Image::copyTo(VkImage dstImage, const VkImageCopy& pRegion)
 	Format srcFormat = getFormat(srcAspect);
 	Format dstFormat = dst->getFormat(dstAspect);
 
+	// The extent is in source texels. Size-compatible copies between
+	// compressed and uncompressed formats cover the same number of blocks,
+	// so the destination region is measured in destination blocks.
+	VkExtent3D dstRegionExtent = imageExtentInBlocks(pRegion.extent, srcAspect);
+	dstRegionExtent.width *= dstFormat.blockWidth();
+	dstRegionExtent.height *= dstFormat.blockHeight();
+
 	if(((samples > VK_SAMPLE_COUNT_1_BIT) && (imageType == VK_IMAGE_TYPE_2D) && !format.isNonNormalizedInteger()) ||
 		srcFormat.hasQuadLayout() || dstFormat.hasQuadLayout())
 	{
@@ -177,7 +275,9 @@ void Image::copyTo(VkImage dstImage, const VkImageCopy& pRegion)
 		region.dstOffsets[1].y = region.dstOffsets[0].y + pRegion.extent.height;
 		region.dstOffsets[1].z = region.dstOffsets[0].z + pRegion.extent.depth;
 
-		return device->getBlitter()->blit(this, dst, region, VK_FILTER_NEAREST);
+		device->getBlitter()->blit(this, dst, region, VK_FILTER_NEAREST);
+		dst->prepareForSampling(pRegion.dstSubresource, pRegion.dstOffset, dstRegionExtent);
+		return;
 	}
 
 	int srcBytesPerBlock = srcFormat.bytesPerBlock();
@@ -265,6 +365,8 @@ void Image::copyTo(VkImage dstImage, const VkImageCopy& pRegion)
 			}
 		}
 	}
+
+	dst->prepareForSampling(pRegion.dstSubresource, pRegion.dstOffset, dstRegionExtent);
 }
 
 void Image::copy(VkBuffer buf, const VkBufferImageCopy& region, bool bufferIsSource)
@@ -410,8 +512,7 @@ void Image::copy(VkBuffer buf, const VkBufferImageCopy& region, bool bufferIsSou
 
 	if(bufferIsSource)
 	{
-		prepareForSampling({ region.imageSubresource.aspectMask, region.imageSubresource.mipLevel, 1,
-		                     region.imageSubresource.baseArrayLayer, region.imageSubresource.layerCount });
+		prepareForSampling(region.imageSubresource, region.imageOffset, region.imageExtent);
 	}
 }
 
@@ -560,6 +661,13 @@ int Image::rowPitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) const
 	ASSERT((aspect & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) !=
 	                 (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT));
 
+	if(tiled)
+	{
+		// Tiled images are padded to whole tiles. Each row of tiles holds
+		// four rows of texels, so this is a quarter of its size.
+		return getFormat(aspect).pitchB(sw::align<4>(getMipLevelExtent(aspect, mipLevel).width), 0, true);
+	}
+
 	return getFormat(aspect).pitchB(getMipLevelExtent(aspect, mipLevel).width, borderSize(), true);
 }
 
@@ -577,6 +685,12 @@ int Image::slicePitchBytes(VkImageAspectFlagBits aspect, uint32_t mipLevel) cons
 		sw::align(mipLevelExtent.height, usedFormat.blockHeight());
 	}
 
+	if(tiled)
+	{
+		mipLevelExtent.width = sw::align<4>(mipLevelExtent.width);
+		mipLevelExtent.height = sw::align<4>(mipLevelExtent.height);
+	}
+
 	return usedFormat.sliceB(mipLevelExtent.width, mipLevelExtent.height, borderSize(), true);
 }
 
@@ -727,12 +841,19 @@ const Image* Image::getSampledImage(const vk::Format& imageViewFormat) const
 	// it may be sampled properly by texture sampling functions, which don't support compressed
 	// textures. If the ImageView's format is NOT compressed, then we reinterpret cast the
 	// compressed image into the ImageView's format, so we must return the compressed image as is.
-	return (decompressedImage && isImageViewCompressed) ? decompressedImage : this;
+	if(decompressedImage && isImageViewCompressed)
+	{
+		return decompressedImage;
+	}
+
+	return tiledImage ? tiledImage : this;
 }
 
 void Image::blit(VkImage dstImage, const VkImageBlit& region, VkFilter filter)
 {
-	device->getBlitter()->blit(this, Cast(dstImage), region, filter);
+	Image* dst = Cast(dstImage);
+	device->getBlitter()->blit(this, dst, region, filter);
+	dst->prepareForSampling(region.dstSubresource);
 }
 
 void Image::resolve(VkImage dstImage, const VkImageResolve& region)
@@ -752,7 +873,9 @@ void Image::resolve(VkImage dstImage, const VkImageResolve& region)
 	blitRegion.srcSubresource = region.srcSubresource;
 	blitRegion.dstSubresource = region.dstSubresource;
 
-	device->getBlitter()->blit(this, Cast(dstImage), blitRegion, VK_FILTER_NEAREST);
+	Image* dst = Cast(dstImage);
+	device->getBlitter()->blit(this, dst, blitRegion, VK_FILTER_NEAREST);
+	dst->prepareForSampling(region.dstSubresource);
 }
 
 VkFormat Image::getClearFormat() const
@@ -796,6 +919,7 @@ void Image::clear(const VkClearColorValue& color, const VkImageSubresourceRange&
 	}
 
 	device->getBlitter()->clear((void*)color.float32, getClearFormat(), this, format, subresourceRange);
+	prepareForSampling(subresourceRange);
 }
 
 void Image::clear(const VkClearDepthStencilValue& color, const VkImageSubresourceRange& subresourceRange)
@@ -811,6 +935,11 @@ void Image::clear(const VkClearDepthStencilValue& color, const VkImageSubresourc
 		VkImageSubresourceRange depthSubresourceRange = subresourceRange;
 		depthSubresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
 		device->getBlitter()->clear((void*)(&color.depth), VK_FORMAT_D32_SFLOAT, this, format, depthSubresourceRange);
+
+		if(coarseDepth)
+		{
+			coarseDepth->clear(color.depth, { { 0, 0 }, { extent.width, extent.height } });
+		}
 	}
 
 	if(subresourceRange.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
@@ -841,6 +970,11 @@ void Image::clear(const VkClearValue& clearValue, const vk::Format& viewFormat,
 			VkImageSubresourceRange depthSubresourceRange = subresourceRange;
 			depthSubresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
 			clear((void*)(&clearValue.depthStencil.depth), VK_FORMAT_D32_SFLOAT, viewFormat, depthSubresourceRange, renderArea);
+
+			if(coarseDepth)
+			{
+				coarseDepth->clear(clearValue.depthStencil.depth, renderArea);
+			}
 		}
 
 		if(subresourceRange.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT)
@@ -854,6 +988,32 @@ void Image::clear(const VkClearValue& clearValue, const vk::Format& viewFormat,
 
 void Image::prepareForSampling(const VkImageSubresourceRange& subresourceRange)
 {
+	if(dirtyRegions)
+	{
+		uint32_t lastLayer = getLastLayerIndex(subresourceRange);
+		uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
+
+		for(uint32_t layer = subresourceRange.baseArrayLayer; layer <= lastLayer; layer++)
+		{
+			for(uint32_t mipLevel = subresourceRange.baseMipLevel; mipLevel <= lastMipLevel; mipLevel++)
+			{
+				VkExtent3D mipLevelExtent = getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask), mipLevel);
+				dirtyRegions[layer * mipLevels + mipLevel] = { { 0, 0 }, { mipLevelExtent.width, mipLevelExtent.height } };
+			}
+		}
+	}
+
+	updateSampledImages(subresourceRange);
+}
+
+void Image::updateSampledImages(const VkImageSubresourceRange& subresourceRange)
+{
+	// Transfers may raise the depth, which the coarse bounds don't track.
+	if(coarseDepth && (subresourceRange.aspectMask & VK_IMAGE_ASPECT_DEPTH_BIT))
+	{
+		coarseDepth->invalidate();
+	}
+
 	if(decompressedImage)
 	{
 		switch(format)
@@ -875,6 +1035,11 @@ void Image::prepareForSampling(const VkImageSubresourceRange& subresourceRange)
 		}
 	}
 
+	if(tiledImage)
+	{
+		tile(subresourceRange);
+	}
+
 	if(isCube() && (arrayLayers >= 6))
 	{
 		VkImageSubresourceLayers subresourceLayers =
@@ -897,9 +1062,54 @@ void Image::prepareForSampling(const VkImageSubresourceRange& subresourceRange)
 	}
 }
 
+void Image::prepareForSampling(const VkImageSubresourceLayers& subresourceLayers)
+{
+	prepareForSampling({ subresourceLayers.aspectMask, subresourceLayers.mipLevel, 1,
+	                     subresourceLayers.baseArrayLayer, subresourceLayers.layerCount });
+}
+
+void Image::prepareForSampling(const VkImageSubresourceLayers& subresourceLayers, const VkOffset3D& offset, const VkExtent3D& extent)
+{
+	if(dirtyRegions)
+	{
+		VkExtent3D mipLevelExtent = getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresourceLayers.aspectMask), subresourceLayers.mipLevel);
+
+		int32_t x0 = std::max(offset.x, 0);
+		int32_t y0 = std::max(offset.y, 0);
+		int32_t x1 = std::min(offset.x + static_cast<int32_t>(extent.width), static_cast<int32_t>(mipLevelExtent.width));
+		int32_t y1 = std::min(offset.y + static_cast<int32_t>(extent.height), static_cast<int32_t>(mipLevelExtent.height));
+
+		uint32_t lastLayer = getLastLayerIndex({ subresourceLayers.aspectMask, subresourceLayers.mipLevel, 1,
+		                                         subresourceLayers.baseArrayLayer, subresourceLayers.layerCount });
+
+		for(uint32_t layer = subresourceLayers.baseArrayLayer; (layer <= lastLayer) && (x0 < x1) && (y0 < y1); layer++)
+		{
+			VkRect2D &region = dirtyRegions[layer * mipLevels + subresourceLayers.mipLevel];
+
+			if((region.extent.width != 0) && (region.extent.height != 0))
+			{
+				int32_t regionX1 = region.offset.x + static_cast<int32_t>(region.extent.width);
+				int32_t regionY1 = region.offset.y + static_cast<int32_t>(region.extent.height);
+
+				region.offset.x = std::min(region.offset.x, x0);
+				region.offset.y = std::min(region.offset.y, y0);
+				region.extent.width = std::max(regionX1, x1) - region.offset.x;
+				region.extent.height = std::max(regionY1, y1) - region.offset.y;
+			}
+			else
+			{
+				region = { { x0, y0 }, { static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0) } };
+			}
+		}
+	}
+
+	updateSampledImages({ subresourceLayers.aspectMask, subresourceLayers.mipLevel, 1,
+	                      subresourceLayers.baseArrayLayer, subresourceLayers.layerCount });
+}
+
 void Image::decodeETC2(const VkImageSubresourceRange& subresourceRange) const
 {
-	ASSERT(decompressedImage);
+	ASSERT(decompressedImage && dirtyRegions);
 
 	ETC_Decoder::InputType inputType = GetInputType(format);
 
@@ -908,38 +1118,146 @@ void Image::decodeETC2(const VkImageSubresourceRange& subresourceRange) const
 
 	int bytes = decompressedImage->format.bytes();
 	bool fakeAlpha = (format == VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK) || (format == VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK);
-	size_t sizeToWrite = 0;
+
+	// Rows of blocks of the written regions, decoded independently of each other.
+	struct Band
+	{
+		const uint8_t* source;
+		uint8_t* dest;
+		int width;
+		int height;
+		int dstWidth;   // Texels left in the destination rows, clipping partial blocks
+		int dstHeight;
+		int srcPitchB;
+		int dstPitchB;
+	};
+
+	std::vector<Band> bands;
+	int64_t texels = 0;
 
 	VkImageSubresourceLayers subresourceLayers = { subresourceRange.aspectMask, subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer, 1 };
 	for(; subresourceLayers.baseArrayLayer <= lastLayer; subresourceLayers.baseArrayLayer++)
 	{
-		for(; subresourceLayers.mipLevel <= lastMipLevel; subresourceLayers.mipLevel++)
+		for(subresourceLayers.mipLevel = subresourceRange.baseMipLevel; subresourceLayers.mipLevel <= lastMipLevel; subresourceLayers.mipLevel++)
 		{
+			VkRect2D &region = dirtyRegions[subresourceLayers.baseArrayLayer * mipLevels + subresourceLayers.mipLevel];
+
+			if((region.extent.width == 0) || (region.extent.height == 0))
+			{
+				continue;
+			}
+
 			VkExtent3D mipLevelExtent = getMipLevelExtent(static_cast<VkImageAspectFlagBits>(subresourceLayers.aspectMask), subresourceLayers.mipLevel);
 
-			int pitchB = decompressedImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresourceLayers.mipLevel);
+			// Blocks are decoded whole, so the region is extended to block boundaries.
+			int32_t x0 = region.offset.x & ~3;
+			int32_t y0 = region.offset.y & ~3;
+			int32_t x1 = region.offset.x + static_cast<int32_t>(region.extent.width);
+			int32_t y1 = region.offset.y + static_cast<int32_t>(region.extent.height);
+			region = { { 0, 0 }, { 0, 0 } };
+
+			int srcPitchB = rowPitchBytes(static_cast<VkImageAspectFlagBits>(subresourceLayers.aspectMask), subresourceLayers.mipLevel);
+			int dstPitchB = decompressedImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresourceLayers.mipLevel);
 
-			if(fakeAlpha)
+			for(int32_t depth = 0; depth < static_cast<int32_t>(mipLevelExtent.depth); depth++)
 			{
-				// To avoid overflow in case of cube textures, which are offset in memory to account for the border,
-				// compute the size from the first pixel to the last pixel, excluding any padding or border before
-				// the first pixel or after the last pixel.
-				sizeToWrite = ((mipLevelExtent.height - 1) * pitchB) + (mipLevelExtent.width * bytes);
+				for(int32_t y = y0; y < y1; y += ETC_BAND_HEIGHT)
+				{
+					Band band;
+					band.source = static_cast<const uint8_t*>(getTexelPointer({ x0, y, depth }, subresourceLayers));
+					band.dest = static_cast<uint8_t*>(decompressedImage->getTexelPointer({ x0, y, depth }, subresourceLayers));
+					band.width = x1 - x0;
+					band.height = std::min(ETC_BAND_HEIGHT, y1 - y);
+					band.dstWidth = static_cast<int>(mipLevelExtent.width) - x0;
+					band.dstHeight = static_cast<int>(mipLevelExtent.height) - y;
+					band.srcPitchB = srcPitchB;
+					band.dstPitchB = dstPitchB;
+					bands.push_back(band);
+				}
+
+				texels += static_cast<int64_t>(x1 - x0) * (y1 - y0);
 			}
+		}
+	}
 
-			for(int32_t depth = 0; depth < static_cast<int32_t>(mipLevelExtent.depth); depth++)
+	auto decode = [&](const Band &band)
+	{
+		if(fakeAlpha)
+		{
+			int rowBytes = std::min(band.width, band.dstWidth) * bytes;
+			int rows = std::min(band.height, band.dstHeight);
+
+			for(int row = 0; row < rows; row++)
 			{
-				uint8_t* source = static_cast<uint8_t*>(getTexelPointer({ 0, 0, depth }, subresourceLayers));
-				uint8_t* dest = static_cast<uint8_t*>(decompressedImage->getTexelPointer({ 0, 0, depth }, subresourceLayers));
+				memset(band.dest + row * band.dstPitchB, 0xFF, rowBytes);
+			}
+		}
+
+		ETC_Decoder::Decode(band.source, band.dest, band.width, band.height, band.dstWidth, band.dstHeight,
+		                    band.srcPitchB, band.dstPitchB, bytes, inputType);
+	};
+
+	if(texels < ETC_PARALLEL_TEXELS)
+	{
+		for(const Band &band : bands)
+		{
+			decode(band);
+		}
+
+		return;
+	}
+
+	sw::ThreadPool::get().parallelFor(bands.size(), [&](size_t i)
+	{
+		decode(bands[i]);
+	});
+}
 
-				if(fakeAlpha)
+void Image::tile(const VkImageSubresourceRange& subresourceRange) const
+{
+	ASSERT(tiledImage && dirtyRegions && (subresourceRange.aspectMask == VK_IMAGE_ASPECT_COLOR_BIT));
+
+	uint32_t lastLayer = getLastLayerIndex(subresourceRange);
+	uint32_t lastMipLevel = getLastMipLevel(subresourceRange);
+
+	int bytes = format.bytes();
+
+	VkImageSubresourceLayers subresourceLayers = { VK_IMAGE_ASPECT_COLOR_BIT, subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer, 1 };
+	for(; subresourceLayers.baseArrayLayer <= lastLayer; subresourceLayers.baseArrayLayer++)
+	{
+		for(subresourceLayers.mipLevel = subresourceRange.baseMipLevel; subresourceLayers.mipLevel <= lastMipLevel; subresourceLayers.mipLevel++)
+		{
+			VkRect2D &region = dirtyRegions[subresourceLayers.baseArrayLayer * mipLevels + subresourceLayers.mipLevel];
+
+			if((region.extent.width == 0) || (region.extent.height == 0))
+			{
+				continue;
+			}
+
+			// Rows of a tile are copied whole, so the region is extended to tile columns.
+			uint32_t x0 = region.offset.x & ~3;
+			uint32_t y0 = region.offset.y;
+			uint32_t x1 = region.offset.x + region.extent.width;
+			uint32_t y1 = region.offset.y + region.extent.height;
+			region = { { 0, 0 }, { 0, 0 } };
+
+			int pitchB = rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresourceLayers.mipLevel);
+			int tiledPitchB = tiledImage->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, subresourceLayers.mipLevel);
+
+			const uint8_t* source = static_cast<const uint8_t*>(getTexelPointer({ 0, 0, 0 }, subresourceLayers));
+			uint8_t* dest = static_cast<uint8_t*>(tiledImage->getTexelPointer({ 0, 0, 0 }, subresourceLayers));
+
+			// Texel (x, y) is stored at (y & ~3) * pitch + (x & ~3) * 4 + (y & 3) * 4 + (x & 3),
+			// so the four texels of a row within a tile are consecutive.
+			for(uint32_t y = y0; y < y1; y++)
+			{
+				const uint8_t* sourceRow = source + y * pitchB;
+				uint8_t* destRow = dest + (y & ~3u) * tiledPitchB + (y & 3u) * 4 * bytes;
+
+				for(uint32_t x = x0; x < x1; x += 4)
 				{
-					ASSERT((dest + sizeToWrite) < decompressedImage->end());
-					memset(dest, 0xFF, sizeToWrite);
+					memcpy(destRow + x * 4 * bytes, sourceRow + x * bytes, std::min(4u, x1 - x) * bytes);
 				}
-
-				ETC_Decoder::Decode(source, dest, mipLevelExtent.width, mipLevelExtent.height,
-									mipLevelExtent.width, mipLevelExtent.height, pitchB, bytes, inputType);
 			}
 		}
 	}
@@ -18,6 +18,11 @@
 #include "VkObject.hpp"
 #include "VkFormat.h"
 
+namespace sw
+{
+	class CoarseDepth;
+}
+
 namespace vk
 {
 
@@ -63,8 +68,14 @@ public:
 	uint8_t*                 end() const;
 	VkDeviceSize             getLayerSize(VkImageAspectFlagBits aspect) const;
 
+	// Compressed and tiled images only update the texels written since they
+	// were last prepared, which the overload taking a region keeps track of.
 	void                     prepareForSampling(const VkImageSubresourceRange& subresourceRange);
+	void                     prepareForSampling(const VkImageSubresourceLayers& subresourceLayers);
+	void                     prepareForSampling(const VkImageSubresourceLayers& subresourceLayers, const VkOffset3D& offset, const VkExtent3D& extent);
 	const Image*             getSampledImage(const vk::Format& imageViewFormat) const;
+	bool                     isTiled() const { return tiled; }
+	sw::CoarseDepth*         getCoarseDepth() const { return coarseDepth; }
 
 private:
 	void copy(VkBuffer buffer, const VkBufferImageCopy& region, bool bufferIsSource);
@@ -83,6 +94,8 @@ private:
 	void clear(void* pixelData, VkFormat pixelFormat, const vk::Format& viewFormat, const VkImageSubresourceRange& subresourceRange, const VkRect2D& renderArea);
 	int borderSize() const;
 	void decodeETC2(const VkImageSubresourceRange& subresourceRange) const;
+	void tile(const VkImageSubresourceRange& subresourceRange) const;
+	void updateSampledImages(const VkImageSubresourceRange& subresourceRange);
 
 	const Device *const      device = nullptr;
 	DeviceMemory*            deviceMemory = nullptr;
@@ -97,6 +110,10 @@ private:
 	VkImageTiling            tiling = VK_IMAGE_TILING_OPTIMAL;
 	VkImageUsageFlags        usage = (VkImageUsageFlags)0;
 	Image*                   decompressedImage = nullptr;
+	Image*                   tiledImage = nullptr;
+	bool                     tiled = false;   // Texels are stored in 4x4 tiles
+	sw::CoarseDepth*         coarseDepth = nullptr;
+	VkRect2D*                dirtyRegions = nullptr;   // Per layer and mip level, texels written since the last decode or tiling
 };
 
 static inline Image* Cast(VkImage object)
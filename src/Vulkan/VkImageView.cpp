@@ -48,6 +48,83 @@ namespace
 			(range.layerCount == VK_REMAINING_ARRAY_LAYERS) ? (image->getArrayLayers() - range.baseArrayLayer) : range.layerCount,
 		};
 	}
+
+	void WriteTextureLevelInfo(sw::Texture *texture, int level, int width, int height, int depth, int pitchP, int sliceP)
+	{
+		if(level == 0)
+		{
+			texture->widthWidthHeightHeight[0] = width;
+			texture->widthWidthHeightHeight[1] = width;
+			texture->widthWidthHeightHeight[2] = height;
+			texture->widthWidthHeightHeight[3] = height;
+
+			texture->width[0] = width;
+			texture->width[1] = width;
+			texture->width[2] = width;
+			texture->width[3] = width;
+
+			texture->height[0] = height;
+			texture->height[1] = height;
+			texture->height[2] = height;
+			texture->height[3] = height;
+
+			texture->depth[0] = depth;
+			texture->depth[1] = depth;
+			texture->depth[2] = depth;
+			texture->depth[3] = depth;
+		}
+
+		sw::Mipmap &mipmap = texture->mipmap[level];
+
+		short halfTexelU = 0x8000 / width;
+		short halfTexelV = 0x8000 / height;
+		short halfTexelW = 0x8000 / depth;
+
+		mipmap.uHalf[0] = halfTexelU;
+		mipmap.uHalf[1] = halfTexelU;
+		mipmap.uHalf[2] = halfTexelU;
+		mipmap.uHalf[3] = halfTexelU;
+
+		mipmap.vHalf[0] = halfTexelV;
+		mipmap.vHalf[1] = halfTexelV;
+		mipmap.vHalf[2] = halfTexelV;
+		mipmap.vHalf[3] = halfTexelV;
+
+		mipmap.wHalf[0] = halfTexelW;
+		mipmap.wHalf[1] = halfTexelW;
+		mipmap.wHalf[2] = halfTexelW;
+		mipmap.wHalf[3] = halfTexelW;
+
+		mipmap.width[0] = width;
+		mipmap.width[1] = width;
+		mipmap.width[2] = width;
+		mipmap.width[3] = width;
+
+		mipmap.height[0] = height;
+		mipmap.height[1] = height;
+		mipmap.height[2] = height;
+		mipmap.height[3] = height;
+
+		mipmap.depth[0] = depth;
+		mipmap.depth[1] = depth;
+		mipmap.depth[2] = depth;
+		mipmap.depth[3] = depth;
+
+		mipmap.onePitchP[0] = 1;
+		mipmap.onePitchP[1] = pitchP;
+		mipmap.onePitchP[2] = 1;
+		mipmap.onePitchP[3] = pitchP;
+
+		mipmap.pitchP[0] = pitchP;
+		mipmap.pitchP[1] = pitchP;
+		mipmap.pitchP[2] = pitchP;
+		mipmap.pitchP[3] = pitchP;
+
+		mipmap.sliceP[0] = sliceP;
+		mipmap.sliceP[1] = sliceP;
+		mipmap.sliceP[2] = sliceP;
+		mipmap.sliceP[3] = sliceP;
+	}
 }
 
 namespace vk
@@ -61,6 +138,13 @@ ImageView::ImageView(const VkImageViewCreateInfo* pCreateInfo, void* mem, const
 	subresourceRange(ResolveRemainingLevelsLayers(pCreateInfo->subresourceRange, image)),
 	ycbcrConversion(ycbcrConversion)
 {
+	// Only views which can be bound as sampled images need the texture layout.
+	// These have a single aspect, unlike e.g. combined depth/stencil attachments.
+	if((image->getUsage() & VK_IMAGE_USAGE_SAMPLED_BIT) &&
+	   (subresourceRange.aspectMask != (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)))
+	{
+		writeSampledTexture();
+	}
 }
 
 size_t ImageView::ComputeRequiredAllocationSize(const VkImageViewCreateInfo* pCreateInfo)
@@ -198,6 +282,82 @@ const Image* ImageView::getImage(Usage usage) const
 	}
 }
 
+void ImageView::writeSampledTexture()
+{
+	Format format = getFormat(SAMPLING);
+	sw::Texture *texture = &sampledTexture;
+
+	if(format.isYcbcrFormat())
+	{
+		ASSERT(subresourceRange.levelCount == 1);
+
+		// YCbCr images can only have one level, so we can store parameters for the
+		// different planes in the descriptor's mipmap levels instead.
+
+		const int level = 0;
+		VkOffset3D offset = {0, 0, 0};
+		texture->mipmap[0].buffer = getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_0_BIT, level, 0, SAMPLING);
+		texture->mipmap[1].buffer = getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_1_BIT, level, 0, SAMPLING);
+		if(format.getAspects() & VK_IMAGE_ASPECT_PLANE_2_BIT)
+		{
+			texture->mipmap[2].buffer = getOffsetPointer(offset, VK_IMAGE_ASPECT_PLANE_2_BIT, level, 0, SAMPLING);
+		}
+
+		VkExtent3D extent = getMipLevelExtent(0);
+
+		int width = extent.width;
+		int height = extent.height;
+		int pitchP0 = rowPitchBytes(VK_IMAGE_ASPECT_PLANE_0_BIT, level, SAMPLING) /
+		              getFormat(VK_IMAGE_ASPECT_PLANE_0_BIT).bytes();
+
+		// Write plane 0 parameters to mipmap level 0.
+		WriteTextureLevelInfo(texture, 0, width, height, 1, pitchP0, 0);
+
+		// Plane 2, if present, has equal parameters to plane 1, so we use mipmap level 1 for both.
+		int pitchP1 = rowPitchBytes(VK_IMAGE_ASPECT_PLANE_1_BIT, level, SAMPLING) /
+		              getFormat(VK_IMAGE_ASPECT_PLANE_1_BIT).bytes();
+
+		WriteTextureLevelInfo(texture, 1, width / 2, height / 2, 1, pitchP1, 0);
+	}
+	else
+	{
+		VkImageAspectFlagBits aspect = static_cast<VkImageAspectFlagBits>(subresourceRange.aspectMask);
+
+		for(int mipmapLevel = 0; mipmapLevel < sw::MIPMAP_LEVELS; mipmapLevel++)
+		{
+			int level = sw::clamp(mipmapLevel, 0, (int)subresourceRange.levelCount - 1);  // Level within the image view
+
+			sw::Mipmap &mipmap = texture->mipmap[mipmapLevel];
+
+			if(viewType == VK_IMAGE_VIEW_TYPE_CUBE)
+			{
+				// Obtain the pointer to the corner of the level including the border, for seamless sampling.
+				// This is taken into account in the sampling routine, which can't handle negative texel coordinates.
+				VkOffset3D offset = {-1, -1, 0};
+				mipmap.buffer = getOffsetPointer(offset, aspect, level, 0, SAMPLING);
+			}
+			else
+			{
+				VkOffset3D offset = {0, 0, 0};
+				mipmap.buffer = getOffsetPointer(offset, aspect, level, 0, SAMPLING);
+			}
+
+			VkExtent3D extent = getMipLevelExtent(level);
+
+			int width = extent.width;
+			int height = extent.height;
+			int layers = subresourceRange.layerCount;  // TODO(b/129523279): Untangle depth vs layers throughout the sampler
+			int depth = layers > 1 ? layers : extent.depth;
+			int pitchP = rowPitchBytes(aspect, level, SAMPLING) / format.bytes();
+			int sliceP = (layers > 1 ? layerPitchBytes(aspect, SAMPLING) : slicePitchBytes(aspect, level, SAMPLING)) / format.bytes();
+
+			WriteTextureLevelInfo(texture, mipmapLevel, width, height, depth, pitchP, sliceP);
+		}
+	}
+
+	hasSampledTexture = true;
+}
+
 Format ImageView::getFormat(Usage usage) const
 {
 	return ((usage == RAW) || (getImage(usage) == image)) ? format : getImage(usage)->getFormat();
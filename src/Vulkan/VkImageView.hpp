@@ -20,6 +20,8 @@
 #include "VkObject.hpp"
 #include "VkImage.hpp"
 
+#include "Device/Sampler.hpp"
+
 #include <atomic>
 
 namespace vk
@@ -51,6 +53,8 @@ public:
 	int layerPitchBytes(VkImageAspectFlagBits aspect, Usage usage = RAW) const;
 	VkExtent3D getMipLevelExtent(uint32_t mipLevel) const;
 
+	bool isSampledImageTiled() const { return getImage(SAMPLING)->isTiled(); }
+
 	int getSampleCount() const
 	{
 		switch (image->getSampleCountFlagBits())
@@ -68,11 +72,20 @@ public:
 	bool hasStencilAspect() const { return (subresourceRange.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT) != 0; }
 
 	void prepareForSampling() const { image->prepareForSampling(subresourceRange); }
+	sw::CoarseDepth *getCoarseDepth() const { return image->getCoarseDepth(); }
 
 	const VkComponentMapping &getComponentMapping() const { return components; }
 	const VkImageSubresourceRange &getSubresourceRange() const { return subresourceRange; }
 	size_t getImageSizeInBytes() const { return image->getMemoryRequirements().size; }
 
+	// Texture layout of the view's mip chain for sampling, computed once at view
+	// creation so that sampled image descriptor updates only need to copy it.
+	const sw::Texture &getSampledTexture() const
+	{
+		ASSERT(hasSampledTexture);
+		return sampledTexture;
+	}
+
 	const uint32_t id = nextID++;
 
 private:
@@ -81,6 +94,7 @@ private:
 
 	bool                          imageTypesMatch(VkImageType imageType) const;
 	const Image*                  getImage(Usage usage) const;
+	void                          writeSampledTexture();
 
 	Image *const                  image = nullptr;
 	const VkImageViewType         viewType = VK_IMAGE_VIEW_TYPE_2D;
@@ -89,6 +103,9 @@ private:
 	const VkImageSubresourceRange subresourceRange = {};
 
 	const vk::SamplerYcbcrConversion *ycbcrConversion = nullptr;
+
+	bool                          hasSampledTexture = false;
+	sw::Texture                   sampledTexture = {};
 };
 
 // TODO(b/132437008): Also used by SamplerYcbcrConversion. Move somewhere centrally?
@@ -55,7 +55,7 @@ const VkPhysicalDeviceFeatures& PhysicalDevice::getFeatures() const
 		false, // textureCompressionASTC_LDR
 		false, // textureCompressionBC
 		false, // occlusionQueryPrecise
-		false, // pipelineStatisticsQuery
+		true,  // pipelineStatisticsQuery
 		false, // vertexPipelineStoresAndAtomics
 		false, // fragmentStoresAndAtomics
 		false, // shaderTessellationAndGeometryPointSize
@@ -319,9 +319,7 @@ void PhysicalDevice::getProperties(VkPhysicalDeviceSubgroupProperties* propertie
 
 void PhysicalDevice::getProperties(const VkExternalMemoryHandleTypeFlagBits* handleType, VkExternalImageFormatProperties* properties) const
 {
-	properties->externalMemoryProperties.compatibleHandleTypes = 0;
-	properties->externalMemoryProperties.exportFromImportedHandleTypes = 0;
-	properties->externalMemoryProperties.externalMemoryFeatures = 0;
+	getExternalMemoryProperties(handleType ? *handleType : 0, &properties->externalMemoryProperties);
 }
 
 void PhysicalDevice::getProperties(VkSamplerYcbcrConversionImageFormatProperties* properties) const
@@ -338,9 +336,25 @@ void PhysicalDevice::getProperties(VkPhysicalDevicePresentationPropertiesANDROID
 
 void PhysicalDevice::getProperties(const VkPhysicalDeviceExternalBufferInfo* pExternalBufferInfo, VkExternalBufferProperties* pExternalBufferProperties) const
 {
-	pExternalBufferProperties->externalMemoryProperties.compatibleHandleTypes = 0;
-	pExternalBufferProperties->externalMemoryProperties.exportFromImportedHandleTypes = 0;
-	pExternalBufferProperties->externalMemoryProperties.externalMemoryFeatures = 0;
+	getExternalMemoryProperties(pExternalBufferInfo->handleType, &pExternalBufferProperties->externalMemoryProperties);
+}
+
+void PhysicalDevice::getExternalMemoryProperties(VkExternalMemoryHandleTypeFlags handleType, VkExternalMemoryProperties* properties) const
+{
+#if defined(__linux__)
+	// Device memory can be backed by a shared memory file.
+	if(handleType == VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT)
+	{
+		properties->compatibleHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+		properties->exportFromImportedHandleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+		properties->externalMemoryFeatures = VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT | VK_EXTERNAL_MEMORY_FEATURE_IMPORTABLE_BIT;
+		return;
+	}
+#endif
+
+	properties->compatibleHandleTypes = 0;
+	properties->exportFromImportedHandleTypes = 0;
+	properties->externalMemoryFeatures = 0;
 }
 
 void PhysicalDevice::getProperties(const VkPhysicalDeviceExternalFenceInfo* pExternalFenceInfo, VkExternalFenceProperties* pExternalFenceProperties) const
@@ -752,7 +766,7 @@ void PhysicalDevice::getQueueFamilyProperties(uint32_t pQueueFamilyPropertyCount
 		pQueueFamilyProperties[i].minImageTransferGranularity.width = 1;
 		pQueueFamilyProperties[i].minImageTransferGranularity.height = 1;
 		pQueueFamilyProperties[i].minImageTransferGranularity.depth = 1;
-		pQueueFamilyProperties[i].queueCount = 1;
+		pQueueFamilyProperties[i].queueCount = vk::QUEUE_COUNT;
 		pQueueFamilyProperties[i].queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
 		pQueueFamilyProperties[i].timestampValidBits = 0; // No support for time stamps
 	}
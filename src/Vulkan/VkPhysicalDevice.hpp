@@ -73,6 +73,7 @@ public:
 private:
 	const VkPhysicalDeviceLimits& getLimits() const;
 	VkSampleCountFlags getSampleCounts() const;
+	void getExternalMemoryProperties(VkExternalMemoryHandleTypeFlags handleType, VkExternalMemoryProperties* properties) const;
 };
 
 using DispatchablePhysicalDevice = DispatchableObject<PhysicalDevice, VkPhysicalDevice>;
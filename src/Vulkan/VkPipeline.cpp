@@ -13,11 +13,15 @@
 // limitations under the License.
 
 #include "VkPipeline.hpp"
+#include "VkPipelineCache.hpp"
 #include "VkPipelineLayout.hpp"
 #include "VkShaderModule.hpp"
 #include "VkRenderPass.hpp"
 #include "Pipeline/ComputeProgram.hpp"
 #include "Pipeline/SpirvShader.hpp"
+#include "System/CPUID.hpp"
+#include "System/ThreadPool.hpp"
+#include "System/Timer.hpp"
 
 #include "spirv-tools/optimizer.hpp"
 
@@ -220,6 +224,38 @@ std::vector<uint32_t> preprocessSpirv(
 	return optimized;
 }
 
+// optimizeSpirv returns the preprocessed code of a shader stage, from the
+// pipeline cache if it already holds it.
+std::vector<uint32_t> optimizeSpirv(
+		vk::PipelineCache *pipelineCache,
+		std::vector<uint32_t> const &code,
+		VkSpecializationInfo const *specializationInfo)
+{
+	if(!pipelineCache)
+	{
+		return preprocessSpirv(code, specializationInfo);
+	}
+
+	auto key = vk::PipelineCache::CreateSpirvShaderKey(code, specializationInfo);
+
+	std::vector<uint32_t> optimized;
+	if(!pipelineCache->findSpirv(key, optimized))
+	{
+		optimized = preprocessSpirv(code, specializationInfo);
+		pipelineCache->insertSpirv(key, optimized);
+	}
+
+	return optimized;
+}
+
+// Routine generation has its own workers, so that compiling pipelines does
+// not hold up the rendering tasks of the process-wide pool.
+sw::ThreadPool &compilePool()
+{
+	static sw::ThreadPool pool(sw::CPUID::processAffinity());
+	return pool;
+}
+
 } // anonymous namespace
 
 namespace vk
@@ -227,6 +263,35 @@ namespace vk
 
 Pipeline::Pipeline(PipelineLayout const *layout) : layout(layout) {}
 
+Pipeline::CompileStalls Pipeline::getCompileStalls() const
+{
+	return { stallCount, stallTime };
+}
+
+void Pipeline::compileInBackground(std::function<void()> &&task)
+{
+	compiling.add();
+
+	compilePool().schedule([this, task]
+	{
+		task();
+		compiling.done();
+	});
+}
+
+void Pipeline::waitForCompilation() const
+{
+	if(compiling.count() == 0)
+	{
+		return;
+	}
+
+	int64_t start = sw::Timer::counter();
+	compiling.wait();
+	stallTime += (sw::Timer::counter() - start) * 1000000 / sw::Timer::frequency();
+	stallCount++;
+}
+
 GraphicsPipeline::GraphicsPipeline(const VkGraphicsPipelineCreateInfo* pCreateInfo, void* mem)
 	: Pipeline(Cast(pCreateInfo->layout))
 {
@@ -433,6 +498,13 @@ GraphicsPipeline::GraphicsPipeline(const VkGraphicsPipelineCreateInfo* pCreateIn
 
 void GraphicsPipeline::destroyPipeline(const VkAllocationCallbacks* pAllocator)
 {
+	compiling.wait();
+
+	if(vertexRoutine)
+	{
+		vertexRoutine->unbind();
+	}
+
 	delete vertexShader;
 	delete fragmentShader;
 }
@@ -442,7 +514,7 @@ size_t GraphicsPipeline::ComputeRequiredAllocationSize(const VkGraphicsPipelineC
 	return 0;
 }
 
-void GraphicsPipeline::compileShaders(const VkAllocationCallbacks* pAllocator, const VkGraphicsPipelineCreateInfo* pCreateInfo)
+void GraphicsPipeline::compileShaders(const VkAllocationCallbacks* pAllocator, const VkGraphicsPipelineCreateInfo* pCreateInfo, PipelineCache* pipelineCache)
 {
 	for (auto pStage = pCreateInfo->pStages; pStage != pCreateInfo->pStages + pCreateInfo->stageCount; pStage++)
 	{
@@ -452,7 +524,7 @@ void GraphicsPipeline::compileShaders(const VkAllocationCallbacks* pAllocator, c
 		}
 
 		auto module = Cast(pStage->module);
-		auto code = preprocessSpirv(module->getCode(), pStage->pSpecializationInfo);
+		auto code = optimizeSpirv(pipelineCache, module->getCode(), pStage->pSpecializationInfo);
 
 		// FIXME (b/119409619): use an allocator here so we can control all memory allocations
 		// TODO: also pass in any pipeline state which will affect shader compilation
@@ -474,6 +546,31 @@ void GraphicsPipeline::compileShaders(const VkAllocationCallbacks* pAllocator, c
 			UNIMPLEMENTED("Unsupported stage");
 		}
 	}
+
+	// The vertex routine only depends on pipeline state, so it can be built
+	// before the first draw. Pixel routines also depend on the attachments
+	// and queries of the draw call, and are generated by the renderer.
+	if(vertexShader)
+	{
+		vertexState = sw::VertexProcessor::update(&context);
+
+		compileInBackground([this]
+		{
+			vk::DescriptorSet::Bindings descriptorSets = {};  // Not used by code generation.
+			vertexRoutine = sw::VertexProcessor::generate(vertexState, layout, vertexShader, descriptorSets);
+			vertexRoutine->bind();
+		});
+	}
+}
+
+void GraphicsPipeline::bindRoutines(sw::Renderer *renderer) const
+{
+	waitForCompilation();
+
+	if(vertexRoutine)
+	{
+		renderer->addRoutine(vertexState, vertexRoutine);
+	}
 }
 
 uint32_t GraphicsPipeline::computePrimitiveCount(uint32_t vertexCount) const
@@ -531,6 +628,8 @@ ComputePipeline::ComputePipeline(const VkComputePipelineCreateInfo* pCreateInfo,
 
 void ComputePipeline::destroyPipeline(const VkAllocationCallbacks* pAllocator)
 {
+	compiling.wait();
+
 	delete shader;
 	delete program;
 }
@@ -540,11 +639,11 @@ size_t ComputePipeline::ComputeRequiredAllocationSize(const VkComputePipelineCre
 	return 0;
 }
 
-void ComputePipeline::compileShaders(const VkAllocationCallbacks* pAllocator, const VkComputePipelineCreateInfo* pCreateInfo)
+void ComputePipeline::compileShaders(const VkAllocationCallbacks* pAllocator, const VkComputePipelineCreateInfo* pCreateInfo, PipelineCache* pipelineCache)
 {
 	auto module = Cast(pCreateInfo->stage.module);
 
-	auto code = preprocessSpirv(module->getCode(), pCreateInfo->stage.pSpecializationInfo);
+	auto code = optimizeSpirv(pipelineCache, module->getCode(), pCreateInfo->stage.pSpecializationInfo);
 
 	ASSERT_OR_RETURN(code.size() > 0);
 
@@ -552,10 +651,14 @@ void ComputePipeline::compileShaders(const VkAllocationCallbacks* pAllocator, co
 
 	// FIXME(b/119409619): use allocator.
 	shader = new sw::SpirvShader(&pCreateInfo->stage, code, nullptr, 0);
-	vk::DescriptorSet::Bindings descriptorSets;  // FIXME(b/129523279): Delay code generation until invoke time.
-	program = new sw::ComputeProgram(shader, layout, descriptorSets);
-	program->generate();
-	program->finalize();
+
+	compileInBackground([this]
+	{
+		vk::DescriptorSet::Bindings descriptorSets;  // FIXME(b/129523279): Delay code generation until invoke time.
+		program = new sw::ComputeProgram(shader, layout, descriptorSets);
+		program->generate();
+		program->finalize();
+	});
 }
 
 void ComputePipeline::run(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
@@ -564,6 +667,8 @@ void ComputePipeline::run(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t bas
 	vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
 	sw::PushConstantStorage const &pushConstants)
 {
+	waitForCompilation();
+
 	ASSERT_OR_RETURN(program != nullptr);
 	program->run(
 		descriptorSets, descriptorDynamicOffsets, pushConstants,
@@ -571,4 +676,10 @@ void ComputePipeline::run(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t bas
 		groupCountX, groupCountY, groupCountZ);
 }
 
+uint32_t ComputePipeline::getWorkgroupInvocations() const
+{
+	auto &modes = shader->getModes();
+	return modes.WorkgroupSizeX * modes.WorkgroupSizeY * modes.WorkgroupSizeZ;
+}
+
 } // namespace vk
@@ -18,6 +18,10 @@
 #include "VkObject.hpp"
 #include "Vulkan/VkDescriptorSet.hpp"
 #include "Device/Renderer.hpp"
+#include "System/Synchronization.hpp"
+
+#include <atomic>
+#include <functional>
 
 namespace sw
 {
@@ -28,6 +32,7 @@ namespace sw
 namespace vk
 {
 
+class PipelineCache;
 class PipelineLayout;
 
 class Pipeline
@@ -53,8 +58,28 @@ public:
 
 	PipelineLayout const * getLayout() const { return layout; }
 
+	// Draws and dispatches which had to wait for the routines generated in
+	// the background, and the total time they waited, in microseconds.
+	struct CompileStalls
+	{
+		uint32_t count;
+		int64_t time;
+	};
+
+	CompileStalls getCompileStalls() const;
+
 protected:
+	// Schedules routine generation on the background compile pool.
+	void compileInBackground(std::function<void()> &&task);
+
+	// Blocks until the routines generated in the background are complete,
+	// recording the stall if they were not.
+	void waitForCompilation() const;
+
 	PipelineLayout const *layout = nullptr;
+	mutable sw::WaitGroup compiling;
+	mutable std::atomic<uint32_t> stallCount = {0};
+	mutable std::atomic<int64_t> stallTime = {0};
 };
 
 class GraphicsPipeline : public Pipeline, public ObjectBase<GraphicsPipeline, VkPipeline>
@@ -72,7 +97,7 @@ public:
 
 	static size_t ComputeRequiredAllocationSize(const VkGraphicsPipelineCreateInfo* pCreateInfo);
 
-	void compileShaders(const VkAllocationCallbacks* pAllocator, const VkGraphicsPipelineCreateInfo* pCreateInfo);
+	void compileShaders(const VkAllocationCallbacks* pAllocator, const VkGraphicsPipelineCreateInfo* pCreateInfo, PipelineCache* pipelineCache);
 
 	uint32_t computePrimitiveCount(uint32_t vertexCount) const;
 	const sw::Context& getContext() const;
@@ -81,11 +106,19 @@ public:
 	const sw::Color<float>& getBlendConstants() const;
 	bool hasDynamicState(VkDynamicState dynamicState) const;
 	bool hasPrimitiveRestartEnable() const { return primitiveRestartEnable; }
+	const sw::VertexProcessor::State& getVertexState() const { return vertexState; }
+
+	// Makes the routines generated at pipeline creation available to the
+	// renderer, waiting for them if necessary.
+	void bindRoutines(sw::Renderer *renderer) const;
 
 private:
 	sw::SpirvShader *vertexShader = nullptr;
 	sw::SpirvShader *fragmentShader = nullptr;
 
+	sw::VertexProcessor::State vertexState;
+	rr::Routine *vertexRoutine = nullptr;
+
 	uint32_t dynamicStateFlags = 0;
 	bool primitiveRestartEnable = false;
 	sw::Context context;
@@ -109,7 +142,7 @@ public:
 
 	static size_t ComputeRequiredAllocationSize(const VkComputePipelineCreateInfo* pCreateInfo);
 
-	void compileShaders(const VkAllocationCallbacks* pAllocator, const VkComputePipelineCreateInfo* pCreateInfo);
+	void compileShaders(const VkAllocationCallbacks* pAllocator, const VkComputePipelineCreateInfo* pCreateInfo, PipelineCache* pipelineCache);
 
 	void run(uint32_t baseGroupX, uint32_t baseGroupY, uint32_t baseGroupZ,
 			uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ,
@@ -117,6 +150,9 @@ public:
 		vk::DescriptorSet::DynamicOffsets const &descriptorDynamicOffsets,
 		sw::PushConstantStorage const &pushConstants);
 
+	// Returns the number of compute shader invocations of each workgroup.
+	uint32_t getWorkgroupInvocations() const;
+
 protected:
 	sw::SpirvShader *shader = nullptr;
 	sw::ComputeProgram *program = nullptr;
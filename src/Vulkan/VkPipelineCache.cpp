@@ -13,67 +13,356 @@
 // limitations under the License.
 
 #include "VkPipelineCache.hpp"
+
+#include <algorithm>
 #include <cstring>
 
-namespace vk
+namespace
 {
 
-PipelineCache::PipelineCache(const VkPipelineCacheCreateInfo* pCreateInfo, void* mem) :
-	dataSize(ComputeRequiredAllocationSize(pCreateInfo)), data(reinterpret_cast<uint8_t*>(mem))
+uint64_t rotl64(uint64_t x, int r)
 {
-	CacheHeader* header = reinterpret_cast<CacheHeader*>(mem);
-	header->headerLength = sizeof(CacheHeader);
-	header->headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
-	header->vendorID = VENDOR_ID;
-	header->deviceID = DEVICE_ID;
-	memcpy(header->pipelineCacheUUID, SWIFTSHADER_UUID, VK_UUID_SIZE);
+	return (x << r) | (x >> (64 - r));
+}
+
+uint64_t fmix64(uint64_t k)
+{
+	k ^= k >> 33;
+	k *= 0xFF51AFD7ED558CCDull;
+	k ^= k >> 33;
+	k *= 0xC4CEB9FE1A85EC53ull;
+	k ^= k >> 33;
+
+	return k;
+}
+
+// MurmurHash3_x64_128, by Austin Appleby, which is in the public domain.
+void hash128(const uint8_t* data, size_t size, uint64_t hash[2])
+{
+	const uint64_t c1 = 0x87C37B91114253D5ull;
+	const uint64_t c2 = 0x4CF5AD432745937Full;
+
+	uint64_t h1 = 0;
+	uint64_t h2 = 0;
+
+	size_t blockCount = size / 16;
 
+	for(size_t i = 0; i < blockCount; i++)
+	{
+		uint64_t k1, k2;
+		memcpy(&k1, data + i * 16, sizeof(k1));
+		memcpy(&k2, data + i * 16 + 8, sizeof(k2));
+
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+		h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52DCE729;
+
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+		h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495AB5;
+	}
+
+	const uint8_t* tail = data + blockCount * 16;
+	uint64_t k1 = 0;
+	uint64_t k2 = 0;
+
+	for(size_t i = size & 15; i > 8; i--)
+	{
+		k2 ^= uint64_t(tail[i - 1]) << ((i - 9) * 8);
+	}
+
+	if((size & 15) > 8)
+	{
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+	}
+
+	for(size_t i = std::min<size_t>(size & 15, 8); i > 0; i--)
+	{
+		k1 ^= uint64_t(tail[i - 1]) << ((i - 1) * 8);
+	}
+
+	if((size & 15) > 0)
+	{
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+	}
+
+	h1 ^= size;
+	h2 ^= size;
+
+	h1 += h2;
+	h2 += h1;
+
+	h1 = fmix64(h1);
+	h2 = fmix64(h2);
+
+	h1 += h2;
+	h2 += h1;
+
+	hash[0] = h1;
+	hash[1] = h2;
+}
+
+}
+
+namespace vk
+{
+
+// The serialized cache is the header followed by a count of entries. Each
+// entry is the hash of the code as four words, the size in words of the
+// specialization and the specialization, then the size in words of the
+// optimized SPIR-V and the optimized SPIR-V.
+
+PipelineCache::PipelineCache(const VkPipelineCacheCreateInfo* pCreateInfo, void* mem)
+{
 	if(pCreateInfo->pInitialData && (pCreateInfo->initialDataSize > 0))
 	{
-		memcpy(data + sizeof(CacheHeader), pCreateInfo->pInitialData, pCreateInfo->initialDataSize);
+		initialize(reinterpret_cast<const uint8_t*>(pCreateInfo->pInitialData), pCreateInfo->initialDataSize);
 	}
 }
 
 void PipelineCache::destroy(const VkAllocationCallbacks* pAllocator)
 {
-	vk::deallocate(data, pAllocator);
 }
 
 size_t PipelineCache::ComputeRequiredAllocationSize(const VkPipelineCacheCreateInfo* pCreateInfo)
 {
-	return pCreateInfo->initialDataSize + sizeof(CacheHeader);
+	return 0;
+}
+
+void PipelineCache::initialize(const uint8_t* data, size_t size)
+{
+	// Data from a different implementation, or a different version of this
+	// one, is ignored, as allowed by the spec.
+	const CacheHeader* header = reinterpret_cast<const CacheHeader*>(data);
+
+	if((size < sizeof(CacheHeader) + sizeof(uint32_t)) ||
+	   (header->headerLength != sizeof(CacheHeader)) ||
+	   (header->headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) ||
+	   (header->vendorID != VENDOR_ID) ||
+	   (header->deviceID != DEVICE_ID) ||
+	   (memcmp(header->pipelineCacheUUID, SWIFTSHADER_UUID, VK_UUID_SIZE) != 0))
+	{
+		return;
+	}
+
+	const uint8_t* end = data + size;
+	const uint8_t* ptr = data + sizeof(CacheHeader);
+
+	// Reads a word count followed by that many words, returning false if
+	// the data is truncated.
+	auto read = [&](std::vector<uint32_t>& words)
+	{
+		uint32_t count = 0;
+
+		if(static_cast<size_t>(end - ptr) < sizeof(uint32_t))
+		{
+			return false;
+		}
+
+		memcpy(&count, ptr, sizeof(uint32_t));
+		ptr += sizeof(uint32_t);
+
+		if(static_cast<size_t>(end - ptr) / sizeof(uint32_t) < count)
+		{
+			return false;
+		}
+
+		words.resize(count);
+		memcpy(words.data(), ptr, count * sizeof(uint32_t));
+		ptr += count * sizeof(uint32_t);
+
+		return true;
+	};
+
+	uint32_t entryCount = 0;
+	memcpy(&entryCount, ptr, sizeof(uint32_t));
+	ptr += sizeof(uint32_t);
+
+	for(uint32_t i = 0; i < entryCount; i++)
+	{
+		SpirvShaderKey key;
+		std::vector<uint32_t> optimized;
+
+		if(static_cast<size_t>(end - ptr) < sizeof(key.codeHash))
+		{
+			break;
+		}
+
+		memcpy(key.codeHash, ptr, sizeof(key.codeHash));
+		ptr += sizeof(key.codeHash);
+
+		if(!read(key.specialization) || !read(optimized))
+		{
+			break;
+		}
+
+		spirvShaders[key] = std::move(optimized);
+	}
 }
 
 VkResult PipelineCache::getData(size_t* pDataSize, void* pData)
 {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	size_t dataSize = sizeof(CacheHeader) + sizeof(uint32_t);
+
+	for(auto& entry : spirvShaders)
+	{
+		dataSize += entrySize(entry.first, entry.second);
+	}
+
 	if(!pData)
 	{
 		*pDataSize = dataSize;
 		return VK_SUCCESS;
 	}
 
-	if(*pDataSize != dataSize)
+	if(*pDataSize < sizeof(CacheHeader) + sizeof(uint32_t))
 	{
 		*pDataSize = 0;
 		return VK_INCOMPLETE;
 	}
 
-	if(*pDataSize > 0)
+	uint8_t* data = reinterpret_cast<uint8_t*>(pData);
+
+	CacheHeader* header = reinterpret_cast<CacheHeader*>(data);
+	header->headerLength = sizeof(CacheHeader);
+	header->headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+	header->vendorID = VENDOR_ID;
+	header->deviceID = DEVICE_ID;
+	memcpy(header->pipelineCacheUUID, SWIFTSHADER_UUID, VK_UUID_SIZE);
+
+	uint8_t* countPtr = data + sizeof(CacheHeader);
+	uint8_t* ptr = countPtr + sizeof(uint32_t);
+	uint32_t entryCount = 0;
+
+	auto write = [&](const std::vector<uint32_t>& words)
+	{
+		uint32_t count = static_cast<uint32_t>(words.size());
+		memcpy(ptr, &count, sizeof(uint32_t));
+		ptr += sizeof(uint32_t);
+		memcpy(ptr, words.data(), count * sizeof(uint32_t));
+		ptr += count * sizeof(uint32_t);
+	};
+
+	// Only whole entries are written, so that partial data remains valid.
+	for(auto& entry : spirvShaders)
 	{
-		memcpy(pData, data, *pDataSize);
+		if(static_cast<size_t>(ptr - data) + entrySize(entry.first, entry.second) > *pDataSize)
+		{
+			break;
+		}
+
+		memcpy(ptr, entry.first.codeHash, sizeof(entry.first.codeHash));
+		ptr += sizeof(entry.first.codeHash);
+		write(entry.first.specialization);
+		write(entry.second);
+		entryCount++;
 	}
 
-	return VK_SUCCESS;
+	memcpy(countPtr, &entryCount, sizeof(uint32_t));
+
+	bool complete = (static_cast<size_t>(ptr - data) == dataSize);
+	*pDataSize = ptr - data;
+
+	return complete ? VK_SUCCESS : VK_INCOMPLETE;
+}
+
+size_t PipelineCache::entrySize(const SpirvShaderKey& key, const std::vector<uint32_t>& optimized)
+{
+	return sizeof(key.codeHash) + (2 + key.specialization.size() + optimized.size()) * sizeof(uint32_t);
 }
 
 VkResult PipelineCache::merge(uint32_t srcCacheCount, const VkPipelineCache* pSrcCaches)
 {
 	for(uint32_t i = 0; i < srcCacheCount; i++)
 	{
-		// TODO (b/123588002): merge pSrcCaches[i];
+		PipelineCache* srcCache = Cast(pSrcCaches[i]);
+
+		// The source entries are copied before locking this cache, so that
+		// merges of two caches into each other can't deadlock.
+		std::unordered_map<SpirvShaderKey, std::vector<uint32_t>, KeyHash> srcShaders;
+		{
+			std::unique_lock<std::mutex> srcLock(srcCache->mutex);
+			srcShaders = srcCache->spirvShaders;
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		spirvShaders.insert(srcShaders.begin(), srcShaders.end());
 	}
 
 	return VK_SUCCESS;
 }
 
+PipelineCache::SpirvShaderKey PipelineCache::CreateSpirvShaderKey(const std::vector<uint32_t>& code, const VkSpecializationInfo* specializationInfo)
+{
+	SpirvShaderKey key;
+	hash128(reinterpret_cast<const uint8_t*>(code.data()), code.size() * sizeof(uint32_t), key.codeHash);
+
+	if(specializationInfo)
+	{
+		std::vector<uint32_t>& spec = key.specialization;
+		spec.push_back(specializationInfo->mapEntryCount);
+
+		for(uint32_t i = 0; i < specializationInfo->mapEntryCount; i++)
+		{
+			const VkSpecializationMapEntry& entry = specializationInfo->pMapEntries[i];
+			spec.push_back(entry.constantID);
+			spec.push_back(entry.offset);
+			spec.push_back(static_cast<uint32_t>(entry.size));
+		}
+
+		spec.push_back(static_cast<uint32_t>(specializationInfo->dataSize));
+
+		if(specializationInfo->dataSize > 0)
+		{
+			size_t start = spec.size();
+			spec.resize(start + (specializationInfo->dataSize + sizeof(uint32_t) - 1) / sizeof(uint32_t), 0);
+			memcpy(&spec[start], specializationInfo->pData, specializationInfo->dataSize);
+		}
+	}
+
+	return key;
+}
+
+bool PipelineCache::findSpirv(const SpirvShaderKey& key, std::vector<uint32_t>& optimized)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	auto it = spirvShaders.find(key);
+
+	if(it == spirvShaders.end())
+	{
+		return false;
+	}
+
+	optimized = it->second;
+	return true;
+}
+
+void PipelineCache::insertSpirv(const SpirvShaderKey& key, const std::vector<uint32_t>& optimized)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	spirvShaders[key] = optimized;
+}
+
+bool PipelineCache::SpirvShaderKey::operator==(const SpirvShaderKey& rhs) const
+{
+	return codeHash[0] == rhs.codeHash[0] &&
+	       codeHash[1] == rhs.codeHash[1] &&
+	       specialization == rhs.specialization;
+}
+
+size_t PipelineCache::KeyHash::operator()(const SpirvShaderKey& key) const
+{
+	// FNV-1a of the specialization, combined with the code's hash
+	size_t hash = 2166136261u;
+
+	for(uint32_t word : key.specialization)
+	{
+		hash = (hash ^ word) * 16777619u;
+	}
+
+	return hash ^ static_cast<size_t>(key.codeHash[0]);
+}
+
 } // namespace vk
@@ -17,9 +17,17 @@
 
 #include "VkObject.hpp"
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 namespace vk
 {
 
+// PipelineCache holds the optimized SPIR-V of the shader stages of the
+// pipelines created with it, so that pipelines using the same shaders skip
+// the SPIR-V optimizer. Its contents can be serialized with getData(), and
+// the result passed as the initial data of a cache in a later run.
 class PipelineCache : public Object<PipelineCache, VkPipelineCache>
 {
 public:
@@ -31,6 +39,23 @@ public:
 	VkResult getData(size_t* pDataSize, void* pData);
 	VkResult merge(uint32_t srcCacheCount, const VkPipelineCache* pSrcCaches);
 
+	// SpirvShaderKey identifies the result of optimizing a shader module's
+	// code with a set of specialization constants applied. The code is
+	// identified by its 128-bit hash, so that it isn't stored or compared.
+	struct SpirvShaderKey
+	{
+		uint64_t codeHash[2];
+		std::vector<uint32_t> specialization;   // Map entries, followed by the data
+
+		bool operator==(const SpirvShaderKey& rhs) const;
+	};
+
+	static SpirvShaderKey CreateSpirvShaderKey(const std::vector<uint32_t>& code, const VkSpecializationInfo* specializationInfo);
+
+	// Returns false and leaves optimized untouched on a cache miss.
+	bool findSpirv(const SpirvShaderKey& key, std::vector<uint32_t>& optimized);
+	void insertSpirv(const SpirvShaderKey& key, const std::vector<uint32_t>& optimized);
+
 private:
 	struct CacheHeader
 	{
@@ -41,8 +66,16 @@ private:
 		uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
 	};
 
-	size_t dataSize = 0;
-	uint8_t* data   = nullptr;
+	struct KeyHash
+	{
+		size_t operator()(const SpirvShaderKey& key) const;
+	};
+
+	void initialize(const uint8_t* data, size_t size);
+	static size_t entrySize(const SpirvShaderKey& key, const std::vector<uint32_t>& optimized);
+
+	std::mutex mutex;
+	std::unordered_map<SpirvShaderKey, std::vector<uint32_t>, KeyHash> spirvShaders;   // guarded by mutex
 };
 
 static inline PipelineCache* Cast(VkPipelineCache object)
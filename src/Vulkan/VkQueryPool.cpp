@@ -20,7 +20,13 @@
 
 namespace vk
 {
-	Query::Query() : finished(sw::Event::ClearMode::Manual), state(UNAVAILABLE), type(INVALID_TYPE), value(0) {}
+	Query::Query() : finished(sw::Event::ClearMode::Manual), state(UNAVAILABLE), type(INVALID_TYPE), value(0)
+	{
+		for(auto &statistic : statistics)
+		{
+			statistic = 0;
+		}
+	}
 
 	void Query::reset()
 	{
@@ -30,6 +36,11 @@ namespace vk
 		ASSERT(prevState != ACTIVE);
 		type = INVALID_TYPE;
 		value = 0;
+
+		for(auto &statistic : statistics)
+		{
+			statistic = 0;
+		}
 	}
 
 	void Query::prepare(VkQueryType ty)
@@ -83,21 +94,30 @@ namespace vk
 		value += v;
 	}
 
-	QueryPool::QueryPool(const VkQueryPoolCreateInfo* pCreateInfo, void* mem) :
-		pool(reinterpret_cast<Query*>(mem)), type(pCreateInfo->queryType),
-		count(pCreateInfo->queryCount)
-	{
-		// According to the Vulkan spec, section 34.1. Features:
-		// "pipelineStatisticsQuery specifies whether the pipeline statistics
-		//  queries are supported. If this feature is not enabled, queries of
-		//  type VK_QUERY_TYPE_PIPELINE_STATISTICS cannot be created, and
-		//  none of the VkQueryPipelineStatisticFlagBits bits can be set in the
-		//  pipelineStatistics member of the VkQueryPoolCreateInfo structure."
-		if(type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+	void Query::addStatistic(VkQueryPipelineStatisticFlagBits statistic, int64_t v)
+	{
+		int index = 0;
+		while((1 << index) != statistic)
 		{
-			UNIMPLEMENTED("pCreateInfo->queryType");
+			index++;
 		}
 
+		ASSERT(index < PIPELINE_STATISTICS_COUNT);
+		statistics[index] += v;
+	}
+
+	int64_t Query::getStatistic(int index) const
+	{
+		return statistics[index];
+	}
+
+	QueryPool::QueryPool(const VkQueryPoolCreateInfo* pCreateInfo, void* mem) :
+		pool(reinterpret_cast<Query*>(mem)), type(pCreateInfo->queryType),
+		count(pCreateInfo->queryCount),
+		pipelineStatistics((type == VK_QUERY_TYPE_PIPELINE_STATISTICS) ? pCreateInfo->pipelineStatistics : 0)
+	{
+		ASSERT(pipelineStatistics < (1u << Query::PIPELINE_STATISTICS_COUNT));
+
 		// Construct all queries
 		for(uint32_t i = 0; i < count; i++)
 		{
@@ -149,16 +169,39 @@ namespace vk
 				writeResult = (flags & VK_QUERY_RESULT_PARTIAL_BIT); // Allow writing partial results
 			}
 
+			// Pipeline statistics queries write one value per statistic enabled
+			// in the pool, in order of their bit position.
+			int64_t values[Query::PIPELINE_STATISTICS_COUNT];
+			int valueCount = 0;
+
+			if(type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+			{
+				for(int statistic = 0; statistic < Query::PIPELINE_STATISTICS_COUNT; statistic++)
+				{
+					if(pipelineStatistics & (1 << statistic))
+					{
+						values[valueCount++] = query.getStatistic(statistic);
+					}
+				}
+			}
+			else
+			{
+				values[valueCount++] = current.value;
+			}
+
 			if(flags & VK_QUERY_RESULT_64_BIT)
 			{
 				uint64_t* result64 = reinterpret_cast<uint64_t*>(data);
 				if(writeResult)
 				{
-					result64[0] = current.value;
+					for(int j = 0; j < valueCount; j++)
+					{
+						result64[j] = values[j];
+					}
 				}
 				if(flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) // Output query availablity
 				{
-					result64[1] = current.state;
+					result64[valueCount] = current.state;
 				}
 			}
 			else
@@ -166,11 +209,14 @@ namespace vk
 				uint32_t* result32 = reinterpret_cast<uint32_t*>(data);
 				if(writeResult)
 				{
-					result32[0] = static_cast<uint32_t>(current.value);
+					for(int j = 0; j < valueCount; j++)
+					{
+						result32[j] = static_cast<uint32_t>(values[j]);
+					}
 				}
 				if(flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) // Output query availablity
 				{
-					result32[1] = current.state;
+					result32[valueCount] = current.state;
 				}
 			}
 		}
@@ -30,6 +30,10 @@ class Query
 public:
 	static auto constexpr INVALID_TYPE = VK_QUERY_TYPE_MAX_ENUM;
 
+	// Number of VkQueryPipelineStatisticFlagBits, which index the pipeline
+	// statistics by bit position.
+	static constexpr int PIPELINE_STATISTICS_COUNT = 11;
+
 	Query();
 
 	enum State
@@ -46,7 +50,7 @@ public:
 	};
 
 	// reset() sets the state of the Query to UNAVAILABLE, sets the type to
-	// INVALID_TYPE and clears the query value.
+	// INVALID_TYPE and clears the query value and statistics.
 	// reset() must not be called while the query is in the ACTIVE state.
 	void reset();
 
@@ -80,12 +84,19 @@ public:
 	// add() adds val to the current query value.
 	void add(int64_t val);
 
+	// addStatistic() adds val to the pipeline statistic counter.
+	void addStatistic(VkQueryPipelineStatisticFlagBits statistic, int64_t val);
+
+	// getStatistic() returns the pipeline statistic counter at bit position index.
+	int64_t getStatistic(int index) const;
+
 private:
 	sw::WaitGroup wg;
 	sw::Event finished;
 	std::atomic<State> state;
 	std::atomic<VkQueryType> type;
 	std::atomic<int64_t> value;
+	std::atomic<int64_t> statistics[PIPELINE_STATISTICS_COUNT];
 };
 
 class QueryPool : public Object<QueryPool, VkQueryPool>
@@ -110,6 +121,7 @@ private:
 	Query* pool;
 	VkQueryType type;
 	uint32_t count;
+	VkQueryPipelineStatisticFlags pipelineStatistics;
 };
 
 static inline QueryPool* Cast(VkQueryPool object)
@@ -20,6 +20,7 @@
 #include "Device/Renderer.hpp"
 
 #include <cstring>
+#include <vector>
 
 namespace
 {
@@ -77,6 +78,9 @@ namespace vk
 Queue::Queue() : renderer(sw::OpenGL, true)
 {
 	queueThread = std::thread(TaskLoop, this);
+#ifndef __ANDROID__
+	presentThread = std::thread(PresentLoop, this);
+#endif
 }
 
 Queue::~Queue()
@@ -88,6 +92,11 @@ Queue::~Queue()
 	queueThread.join();
 	ASSERT_MSG(pending.count() == 0, "queue has work after worker thread shutdown");
 
+#ifndef __ANDROID__
+	presents.put(task);
+	presentThread.join();
+#endif
+
 	garbageCollect();
 }
 
@@ -135,6 +144,13 @@ void Queue::submitQueue(const Task& task)
 			}
 		}
 
+		if(submitInfo.signalSemaphoreCount > 0)
+		{
+			// Draws may still be in flight, and the semaphores can be waited
+			// on by other queues.
+			renderer.synchronize();
+		}
+
 		for(uint32_t j = 0; j < submitInfo.signalSemaphoreCount; j++)
 		{
 			vk::Cast(submitInfo.pSignalSemaphores[j])->signal();
@@ -169,6 +185,11 @@ void Queue::taskLoop()
 		case Task::SUBMIT_QUEUE:
 			submitQueue(task);
 			break;
+#ifndef __ANDROID__
+		case Task::PRESENT:
+			presentQueue(task);
+			break;
+#endif
 		default:
 			UNIMPLEMENTED("task.type %d", static_cast<int>(task.type));
 			break;
@@ -188,6 +209,17 @@ VkResult Queue::waitIdle()
 
 	wg.wait();
 
+#ifndef __ANDROID__
+	// Presentations queued before the wait are part of the queue's work.
+	wg.add();
+	Task presentTask;
+	presentTask.type = Task::PRESENT;
+	presentTask.events = &wg;
+	presents.put(presentTask);
+
+	wg.wait();
+#endif
+
 	garbageCollect();
 
 	return VK_SUCCESS;
@@ -206,19 +238,78 @@ void Queue::garbageCollect()
 #ifndef __ANDROID__
 void Queue::present(const VkPresentInfoKHR* presentInfo)
 {
-	// This is a hack to deal with screen tearing for now.
-	// Need to correctly implement threading using VkSemaphore
-	// to get rid of it. b/132458423
-	waitIdle();
+	// Images are presented after the work submitted before them, so the
+	// application can record and submit the next frames meanwhile.
+	garbageCollect();
 
-	for(uint32_t i = 0; i < presentInfo->waitSemaphoreCount; i++)
+	for(uint32_t i = 0; i < presentInfo->swapchainCount; i++)
 	{
-		vk::Cast(presentInfo->pWaitSemaphores[i])->wait();
+		vk::Cast(presentInfo->pSwapchains[i])->queuePresent(presentInfo->pImageIndices[i]);
+
+		Task task;
+		task.type = Task::PRESENT;
+		task.swapchain = presentInfo->pSwapchains[i];
+		task.imageIndex = presentInfo->pImageIndices[i];
+
+		// The first presentation waits for the semaphores.
+		if((i == 0) && (presentInfo->waitSemaphoreCount > 0))
+		{
+			std::vector<VkPipelineStageFlags> waitStages(presentInfo->waitSemaphoreCount, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+			VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+			submitInfo.waitSemaphoreCount = presentInfo->waitSemaphoreCount;
+			submitInfo.pWaitSemaphores = presentInfo->pWaitSemaphores;
+			submitInfo.pWaitDstStageMask = waitStages.data();
+
+			task.submitCount = 1;
+			task.pSubmits = DeepCopySubmitInfo(1, &submitInfo);
+		}
+
+		pending.put(task);
 	}
+}
 
-	for(uint32_t i = 0; i < presentInfo->swapchainCount; i++)
+void Queue::presentQueue(const Task& task)
+{
+	submitQueue(task);
+
+	// The image is written by draws still in flight on the renderer.
+	renderer.synchronize();
+
+	// Handing the image to the surface may wait for the display, so it is
+	// done by the present thread, and later submissions can proceed.
+	Task presentTask;
+	presentTask.type = Task::PRESENT;
+	presentTask.swapchain = task.swapchain;
+	presentTask.imageIndex = task.imageIndex;
+	presents.put(presentTask);
+}
+
+void Queue::PresentLoop(vk::Queue* queue)
+{
+	queue->presentLoop();
+}
+
+void Queue::presentLoop()
+{
+	while(true)
 	{
-		vk::Cast(presentInfo->pSwapchains[i])->present(presentInfo->pImageIndices[i]);
+		Task task = presents.take();
+
+		if(task.type == Task::KILL_THREAD)
+		{
+			return;
+		}
+
+		if(task.swapchain != VK_NULL_HANDLE)
+		{
+			vk::Cast(task.swapchain)->present(task.imageIndex);
+		}
+
+		if(task.events)
+		{
+			task.events->finish();
+		}
 	}
 }
 #endif
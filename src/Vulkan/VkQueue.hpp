@@ -46,6 +46,8 @@ public:
 
 	VkResult submit(uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence);
 	VkResult waitIdle();
+	sw::Renderer &getRenderer() { return renderer; }
+	const sw::Renderer &getRenderer() const { return renderer; }
 #ifndef __ANDROID__
 	void present(const VkPresentInfoKHR* presentInfo);
 #endif
@@ -56,8 +58,10 @@ private:
 		uint32_t submitCount = 0;
 		VkSubmitInfo* pSubmits = nullptr;
 		sw::TaskEvents* events = nullptr;
+		VkSwapchainKHR swapchain = VK_NULL_HANDLE;   // PRESENT only
+		uint32_t imageIndex = 0;
 
-		enum Type { KILL_THREAD, SUBMIT_QUEUE };
+		enum Type { KILL_THREAD, SUBMIT_QUEUE, PRESENT };
 		Type type = SUBMIT_QUEUE;
 	};
 
@@ -65,11 +69,20 @@ private:
 	void taskLoop();
 	void garbageCollect();
 	void submitQueue(const Task& task);
+#ifndef __ANDROID__
+	void presentQueue(const Task& task);
+	static void PresentLoop(vk::Queue* queue);
+	void presentLoop();
+#endif
 
 	sw::Renderer renderer;
 	sw::Chan<Task> pending;
 	sw::Chan<VkSubmitInfo*> toDelete;
 	std::thread queueThread;
+#ifndef __ANDROID__
+	sw::Chan<Task> presents;   // Images whose rendering is done, in presentation order
+	std::thread presentThread;
+#endif
 };
 
 static inline Queue* Cast(VkQueue object)
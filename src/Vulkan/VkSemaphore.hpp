@@ -16,14 +16,17 @@
 #define VK_SEMAPHORE_HPP_
 
 #include "VkObject.hpp"
+#include "System/Synchronization.hpp"
 
 namespace vk
 {
 
+// Binary semaphore. Each wait consumes a signal, blocking until one occurs.
 class Semaphore : public Object<Semaphore, VkSemaphore>
 {
 public:
-	Semaphore(const VkSemaphoreCreateInfo* pCreateInfo, void* mem) {}
+	Semaphore(const VkSemaphoreCreateInfo* pCreateInfo, void* mem) :
+		signaled(sw::Event::ClearMode::Auto, false) {}
 
 	static size_t ComputeRequiredAllocationSize(const VkSemaphoreCreateInfo* pCreateInfo)
 	{
@@ -32,22 +35,23 @@ public:
 
 	void wait()
 	{
-		// Semaphores are noop for now
+		signaled.wait();
 	}
 
 	void wait(const VkPipelineStageFlags& flag)
 	{
-		// VkPipelineStageFlags is the pipeline stage at which the semaphore wait will occur
-
-		// Semaphores are noop for now
+		// VkPipelineStageFlags is the pipeline stage at which the semaphore wait will occur.
+		// Queues execute their commands in order, so all of them wait.
+		signaled.wait();
 	}
 
 	void signal()
 	{
-		// Semaphores are noop for now
+		signaled.signal();
 	}
 
 private:
+	sw::Event signaled;
 };
 
 static inline Semaphore* Cast(VkSemaphore object)
@@ -112,4 +112,33 @@ public:
 #undef None
 #endif
 
+// VK_EXT_headless_surface is newer than the Vulkan headers in include/, which
+// are kept identical to a Vulkan-Headers release. These declarations match
+// the registry's, and give way to the headers' once they are updated.
+#ifndef VK_EXT_headless_surface
+#define VK_EXT_headless_surface 1
+#define VK_EXT_HEADLESS_SURFACE_SPEC_VERSION 1
+#define VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME "VK_EXT_headless_surface"
+
+constexpr VkStructureType VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT = static_cast<VkStructureType>(1000256000);
+
+typedef VkFlags VkHeadlessSurfaceCreateFlagsEXT;
+
+typedef struct VkHeadlessSurfaceCreateInfoEXT {
+	VkStructureType                    sType;
+	const void*                        pNext;
+	VkHeadlessSurfaceCreateFlagsEXT    flags;
+} VkHeadlessSurfaceCreateInfoEXT;
+
+typedef VkResult (VKAPI_PTR *PFN_vkCreateHeadlessSurfaceEXT)(VkInstance instance, const VkHeadlessSurfaceCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSurfaceKHR* pSurface);
+
+#ifndef VK_NO_PROTOTYPES
+extern "C" VKAPI_ATTR VkResult VKAPI_CALL vkCreateHeadlessSurfaceEXT(
+	VkInstance                                  instance,
+	const VkHeadlessSurfaceCreateInfoEXT*       pCreateInfo,
+	const VkAllocationCallbacks*                pAllocator,
+	VkSurfaceKHR*                               pSurface);
+#endif
+#endif
+
 #endif // VULKAN_PLATFORM
@@ -0,0 +1,61 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "HeadlessSurfaceKHR.hpp"
+
+#include "Vulkan/VkConfig.h"
+
+namespace vk {
+
+HeadlessSurfaceKHR::HeadlessSurfaceKHR(const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo, void *mem)
+{
+	// Frames are never shown, so the latest one can always replace a pending one.
+	addPresentMode(VK_PRESENT_MODE_MAILBOX_KHR);
+}
+
+void HeadlessSurfaceKHR::destroySurface(const VkAllocationCallbacks *pAllocator)
+{
+
+}
+
+size_t HeadlessSurfaceKHR::ComputeRequiredAllocationSize(const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo)
+{
+	return 0;
+}
+
+void HeadlessSurfaceKHR::getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCapabilities) const
+{
+	SurfaceKHR::getSurfaceCapabilities(pSurfaceCapabilities);
+
+	// The extent of headless surfaces is determined by their swapchain.
+	const uint32_t maxDimension = 1 << (vk::MAX_IMAGE_LEVELS_2D - 1);
+
+	pSurfaceCapabilities->currentExtent = { 0xFFFFFFFF, 0xFFFFFFFF };
+	pSurfaceCapabilities->minImageExtent = { 1, 1 };
+	pSurfaceCapabilities->maxImageExtent = { maxDimension, maxDimension };
+}
+
+void HeadlessSurfaceKHR::attachImage(PresentImage* image)
+{
+}
+
+void HeadlessSurfaceKHR::detachImage(PresentImage* image)
+{
+}
+
+void HeadlessSurfaceKHR::present(PresentImage* image)
+{
+}
+
+}
@@ -83,6 +83,11 @@ VkResult SurfaceKHR::getPresentModes(uint32_t *pPresentModeCount, VkPresentModeK
 	return VK_SUCCESS;
 }
 
+void SurfaceKHR::addPresentMode(VkPresentModeKHR presentMode)
+{
+	presentModes.push_back(presentMode);
+}
+
 void SurfaceKHR::associateSwapchain(VkSwapchainKHR swapchain)
 {
 	associatedSwapchain = swapchain;
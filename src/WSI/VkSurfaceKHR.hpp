@@ -62,14 +62,23 @@ public:
 	uint32_t getPresentModeCount() const;
 	VkResult getPresentModes(uint32_t* pPresentModeCount, VkPresentModeKHR* pPresentModes) const;
 
+	// Returns host memory shared with the presentation engine, to back the
+	// image with, or nullptr to have it backed by device memory.
+	virtual void* allocateImageMemory(PresentImage* image, VkDeviceSize size) { return nullptr; }
+
 	virtual void attachImage(PresentImage* image) = 0;
 	virtual void detachImage(PresentImage* image) = 0;
 	virtual void present(PresentImage* image) = 0;
 
+	// Blocks until the presentation engine no longer reads the image.
+	virtual void waitForImage(PresentImage* image) {}
+
 	void associateSwapchain(VkSwapchainKHR swapchain);
 	void disassociateSwapchain();
 	VkSwapchainKHR getAssociatedSwapchain();
 
+protected:
+	void addPresentMode(VkPresentModeKHR presentMode);
 
 private:
 	VkSwapchainKHR associatedSwapchain;
@@ -79,7 +88,7 @@ private:
 		{VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
 	};
 
-	const std::vector<VkPresentModeKHR> presentModes =
+	std::vector<VkPresentModeKHR> presentModes =
 	{
 		VK_PRESENT_MODE_FIFO_KHR,
 	};
@@ -19,6 +19,8 @@
 #include "Vulkan/VkDestroy.h"
 
 #include <algorithm>
+#include <chrono>
+#include <climits>
 
 namespace vk
 {
@@ -33,6 +35,10 @@ SwapchainKHR::SwapchainKHR(const VkSwapchainCreateInfoKHR *pCreateInfo, void *me
 
 void SwapchainKHR::destroy(const VkAllocationCallbacks *pAllocator)
 {
+	// Images still queued for presentation are in use by the queue thread.
+	std::unique_lock<std::mutex> lock(imageMutex);
+	imagePresented.wait(lock, [this] { return !isPresenting(); });
+
 	for(auto& currentImage : images)
 	{
 		if (currentImage.imageStatus != NONEXISTENT)
@@ -58,6 +64,8 @@ size_t SwapchainKHR::ComputeRequiredAllocationSize(const VkSwapchainCreateInfoKH
 
 void SwapchainKHR::retire()
 {
+	std::unique_lock<std::mutex> lock(imageMutex);
+
 	if(!retired)
 	{
 		retired = true;
@@ -135,6 +143,19 @@ VkResult SwapchainKHR::createImages(VkDevice device)
 		allocInfo.allocationSize = memRequirements.size;
 		allocInfo.memoryTypeIndex = 0;
 
+		// Images are rendered directly into memory shared with the presentation
+		// engine, when it provides some, so presenting them copies nothing.
+		VkImportMemoryHostPointerInfoEXT importInfo = {};
+		void* sharedMemory = vk::Cast(createInfo.surface)->allocateImageMemory(&currentImage, memRequirements.size);
+
+		if(sharedMemory)
+		{
+			importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+			importInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+			importInfo.pHostPointer = sharedMemory;
+			allocInfo.pNext = &importInfo;
+		}
+
 		status = vkAllocateMemory(device, &allocInfo, nullptr, &currentImage.imageMemory);
 		if(status != VK_SUCCESS)
 		{
@@ -176,38 +197,105 @@ VkResult SwapchainKHR::getImages(uint32_t *pSwapchainImageCount, VkImage *pSwapc
 	return VK_SUCCESS;
 }
 
-VkResult SwapchainKHR::getNextImage(uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t *pImageIndex)
+int SwapchainKHR::findAvailableImage() const
 {
-	for(uint32_t i = 0; i < getImageCount(); i++)
+	// The queue presents images in the order they were queued, so acquiring
+	// them in a round robin returns them in presentation order, as both the
+	// FIFO and mailbox modes require.
+	uint32_t count = getImageCount();
+
+	for(uint32_t n = 0; n < count; n++)
 	{
-		PresentImage& currentImage = images[i];
-		if(currentImage.imageStatus == AVAILABLE)
+		uint32_t i = (nextImage + n) % count;
+		if(images[i].imageStatus == AVAILABLE)
 		{
-			currentImage.imageStatus = DRAWING;
-			*pImageIndex = i;
+			return static_cast<int>(i);
+		}
+	}
 
-			if(semaphore)
-			{
-				vk::Cast(semaphore)->signal();
-			}
+	return -1;
+}
 
-			if(fence)
-			{
-				vk::Cast(fence)->complete();
-			}
+bool SwapchainKHR::isPresenting() const
+{
+	for(auto& currentImage : images)
+	{
+		if(currentImage.imageStatus == PRESENTING)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
 
-			return VK_SUCCESS;
+VkResult SwapchainKHR::getNextImage(uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t *pImageIndex)
+{
+	using time_point = std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds>;
+	const time_point start = std::chrono::system_clock::now();
+	const uint64_t max_timeout = (LLONG_MAX - start.time_since_epoch().count());
+	bool infiniteTimeout = (timeout > max_timeout);
+	const time_point end_ns = start + std::chrono::nanoseconds(std::min(max_timeout, timeout));
+
+	std::unique_lock<std::mutex> lock(imageMutex);
+
+	int index = findAvailableImage();
+
+	// Only images queued for presentation can become available. The others
+	// are held by the application.
+	while((index < 0) && (timeout != 0) && isPresenting())
+	{
+		if(infiniteTimeout)
+		{
+			imagePresented.wait(lock);
+		}
+		else if(imagePresented.wait_until(lock, end_ns) == std::cv_status::timeout)
+		{
+			index = findAvailableImage();
+			break;
 		}
+
+		index = findAvailableImage();
+	}
+
+	if(index < 0)
+	{
+		return (timeout == 0) ? VK_NOT_READY : VK_TIMEOUT;
 	}
 
-	return VK_NOT_READY;
+	images[index].imageStatus = DRAWING;
+	*pImageIndex = static_cast<uint32_t>(index);
+	nextImage = (index + 1) % getImageCount();
+	lock.unlock();
+
+	// The presentation engine may still be reading the image's last frame.
+	vk::Cast(createInfo.surface)->waitForImage(&images[index]);
+
+	if(semaphore)
+	{
+		vk::Cast(semaphore)->signal();
+	}
+
+	if(fence)
+	{
+		vk::Cast(fence)->complete();
+	}
+
+	return VK_SUCCESS;
+}
+
+void SwapchainKHR::queuePresent(uint32_t index)
+{
+	std::unique_lock<std::mutex> lock(imageMutex);
+	images[index].imageStatus = PRESENTING;
 }
 
 void SwapchainKHR::present(uint32_t index)
 {
 	auto & image = images[index];
-	image.imageStatus = PRESENTING;
 	vk::Cast(createInfo.surface)->present(&image);
+
+	std::unique_lock<std::mutex> lock(imageMutex);
 	image.imageStatus = AVAILABLE;
 
 	if(retired)
@@ -218,6 +306,8 @@ void SwapchainKHR::present(uint32_t index)
 
 		image.imageStatus = NONEXISTENT;
 	}
+
+	imagePresented.notify_all();
 }
 
 }
\ No newline at end of file
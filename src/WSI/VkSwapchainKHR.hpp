@@ -20,6 +20,8 @@
 #include "Vulkan/VkImage.hpp"
 #include "VkSurfaceKHR.hpp"
 
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 
 namespace vk
@@ -43,14 +45,24 @@ public:
 
 	VkResult getNextImage(uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t* pImageIndex);
 
+	// Images are queued for presentation by the application, and presented by
+	// the queue once the work submitted before has completed. They can't be
+	// acquired again in between.
+	void queuePresent(uint32_t index);
 	void present(uint32_t index);
 
 private:
 	VkSwapchainCreateInfoKHR createInfo;
 	std::vector<PresentImage> images;
+	uint32_t nextImage = 0;   // Least recently acquired image
 	bool retired;
 
+	std::mutex imageMutex;   // Guards the image status, changed by the queue thread on present
+	std::condition_variable imagePresented;
+
 	void resetImages();
+	int findAvailableImage() const;
+	bool isPresenting() const;
 };
 
 static inline SwapchainKHR* Cast(VkSwapchainKHR object)
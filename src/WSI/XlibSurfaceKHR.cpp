@@ -13,14 +13,61 @@
 
 #include "Vulkan/VkDeviceMemory.hpp"
 
-#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+namespace {
+
+int (*PreviousXErrorHandler)(Display *display, XErrorEvent *event) = nullptr;
+bool shmBadAccess = false;
+
+// Catches BadAccess errors so we can fall back to not using MIT-SHM
+int XShmErrorHandler(Display *display, XErrorEvent *event)
+{
+	if(event->error_code == BadAccess)
+	{
+		shmBadAccess = true;
+		return 0;
+	}
+	else
+	{
+		return PreviousXErrorHandler(display, event);
+	}
+}
+
+void destroySharedImage(XImage* xImage, XShmSegmentInfo &shmInfo)
+{
+	xImage->data = nullptr;
+	XDestroyImage(xImage);
+
+	if(shmInfo.shmaddr != reinterpret_cast<char*>(-1))
+	{
+		shmdt(shmInfo.shmaddr);
+	}
+
+	if(shmInfo.shmid != -1)
+	{
+		shmctl(shmInfo.shmid, IPC_RMID, 0);
+	}
+}
+
+}
 
 namespace vk {
 
 XlibSurfaceKHR::XlibSurfaceKHR(const VkXlibSurfaceCreateInfoKHR *pCreateInfo, void *mem) :
-		pDisplay(pCreateInfo->dpy),
+		pDisplay(libX11->XOpenDisplay(DisplayString(pCreateInfo->dpy))),
 		window(pCreateInfo->window)
 {
+	privateDisplay = (pDisplay != nullptr);
+
+	if(!privateDisplay)
+	{
+		// Without a connection of its own, the surface can only use the
+		// application's concurrently if it called XInitThreads().
+		pDisplay = pCreateInfo->dpy;
+	}
+
 	int screen = DefaultScreen(pDisplay);
 	gc = libX11->XDefaultGC(pDisplay, screen);
 
@@ -28,11 +75,42 @@ XlibSurfaceKHR::XlibSurfaceKHR(const VkXlibSurfaceCreateInfoKHR *pCreateInfo, vo
 	Status status = libX11->XMatchVisualInfo(pDisplay, screen, 32, TrueColor, &xVisual);
 	bool match = (status != 0 && xVisual.blue_mask ==0xFF);
 	visual = match ? xVisual.visual : libX11->XDefaultVisual(pDisplay, screen);
+
+	// Shared images are released through completion events, which only a
+	// private connection can wait for.
+	mitShm = privateDisplay && (libX11->XShmQueryExtension && libX11->XShmQueryExtension(pDisplay) == True);
+
+	if(mitShm)
+	{
+		shmCompletionEvent = libX11->XShmGetEventBase(pDisplay) + ShmCompletion;
+	}
 }
 
-void XlibSurfaceKHR::destroySurface(const VkAllocationCallbacks *pAllocator)
+XlibSurfaceKHR::DisplayLock::DisplayLock(const XlibSurfaceKHR *surface) :
+		guard(surface->surfaceMutex),
+		pDisplay(surface->pDisplay),
+		shared(!surface->privateDisplay)
+{
+	if(shared)
+	{
+		libX11->XLockDisplay(pDisplay);
+	}
+}
+
+XlibSurfaceKHR::DisplayLock::~DisplayLock()
 {
+	if(shared)
+	{
+		libX11->XUnlockDisplay(pDisplay);
+	}
+}
 
+void XlibSurfaceKHR::destroySurface(const VkAllocationCallbacks *pAllocator)
+{
+	if(privateDisplay)
+	{
+		libX11->XCloseDisplay(pDisplay);
+	}
 }
 
 size_t XlibSurfaceKHR::ComputeRequiredAllocationSize(const VkXlibSurfaceCreateInfoKHR *pCreateInfo)
@@ -44,6 +122,7 @@ void XlibSurfaceKHR::getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCa
 {
 	SurfaceKHR::getSurfaceCapabilities(pSurfaceCapabilities);
 
+	DisplayLock lock(this);
 	XWindowAttributes attr;
 	libX11->XGetWindowAttributes(pDisplay, window, &attr);
 	VkExtent2D extent = {static_cast<uint32_t>(attr.width), static_cast<uint32_t>(attr.height)};
@@ -53,8 +132,44 @@ void XlibSurfaceKHR::getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCa
 	pSurfaceCapabilities->maxImageExtent = extent;
 }
 
+void* XlibSurfaceKHR::allocateImageMemory(PresentImage* image, VkDeviceSize size)
+{
+	DisplayLock lock(this);
+
+	if(!mitShm)
+	{
+		return nullptr;
+	}
+
+	XWindowAttributes attr;
+	libX11->XGetWindowAttributes(pDisplay, window, &attr);
+
+	// The image refers to its segment info, so it's kept at a stable address.
+	XShmSegmentInfo &shmInfo = shmSegmentMap[image];
+	XImage* xImage = createSharedImage(image, attr.depth, size, shmInfo);
+
+	if(!xImage)
+	{
+		// The X server can't attach our segments, e.g. when it's remote.
+		shmSegmentMap.erase(image);
+		mitShm = false;
+		return nullptr;
+	}
+
+	imageMap[image] = xImage;
+
+	return shmInfo.shmaddr;
+}
+
 void XlibSurfaceKHR::attachImage(PresentImage* image)
 {
+	DisplayLock lock(this);
+
+	if(imageMap.count(image))
+	{
+		return;   // Already presented from its shared memory segment
+	}
+
 	XWindowAttributes attr;
 	libX11->XGetWindowAttributes(pDisplay, window, &attr);
 
@@ -68,20 +183,87 @@ void XlibSurfaceKHR::attachImage(PresentImage* image)
 	imageMap[image] = xImage;
 }
 
+XImage* XlibSurfaceKHR::createSharedImage(PresentImage* image, int depth, VkDeviceSize size, XShmSegmentInfo &shmInfo)
+{
+	VkExtent3D extent = vk::Cast(image->image)->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, 0);
+
+	shmInfo.shmid = -1;
+	shmInfo.shmaddr = reinterpret_cast<char*>(-1);
+	shmInfo.readOnly = False;
+
+	XImage* xImage = libX11->XShmCreateImage(pDisplay, visual, depth, ZPixmap, nullptr, &shmInfo, extent.width, extent.height);
+	if(!xImage)
+	{
+		return nullptr;
+	}
+
+	// The segment holds the image's memory, so both must lay out rows alike.
+	int bytes_per_line = vk::Cast(image->image)->rowPitchBytes(VK_IMAGE_ASPECT_COLOR_BIT, 0);
+	if((xImage->bytes_per_line != bytes_per_line) ||
+	   (static_cast<VkDeviceSize>(xImage->bytes_per_line) * xImage->height > size))
+	{
+		destroySharedImage(xImage, shmInfo);
+		return nullptr;
+	}
+
+	shmInfo.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | SHM_R | SHM_W);
+	if(shmInfo.shmid != -1)
+	{
+		shmInfo.shmaddr = xImage->data = static_cast<char*>(shmat(shmInfo.shmid, 0, 0));
+	}
+
+	if(shmInfo.shmaddr == reinterpret_cast<char*>(-1))
+	{
+		destroySharedImage(xImage, shmInfo);
+		return nullptr;
+	}
+
+	PreviousXErrorHandler = libX11->XSetErrorHandler(XShmErrorHandler);
+	libX11->XShmAttach(pDisplay, &shmInfo);   // May produce a BadAccess error
+	libX11->XSync(pDisplay, False);
+	libX11->XSetErrorHandler(PreviousXErrorHandler);
+
+	if(shmBadAccess)
+	{
+		shmBadAccess = false;
+		destroySharedImage(xImage, shmInfo);
+		return nullptr;
+	}
+
+	return xImage;
+}
+
 void XlibSurfaceKHR::detachImage(PresentImage* image)
 {
+	DisplayLock lock(this);
 	auto it = imageMap.find(image);
 	if(it != imageMap.end())
 	{
 		XImage* xImage = it->second;
-		xImage->data = nullptr; // the XImage does not actually own the buffer
-		XDestroyImage(xImage);
+
+		auto shm = shmSegmentMap.find(image);
+		if(shm != shmSegmentMap.end())
+		{
+			waitForCompletion(image);
+
+			libX11->XShmDetach(pDisplay, &shm->second);
+			libX11->XSync(pDisplay, False);
+			destroySharedImage(xImage, shm->second);
+			shmSegmentMap.erase(shm);
+		}
+		else
+		{
+			xImage->data = nullptr; // the XImage does not actually own the buffer
+			XDestroyImage(xImage);
+		}
+
 		imageMap.erase(image);
 	}
 }
 
 void XlibSurfaceKHR::present(PresentImage* image)
 {
+	DisplayLock lock(this);
 	auto it = imageMap.find(image);
 	if(it != imageMap.end())
 	{
@@ -90,7 +272,53 @@ void XlibSurfaceKHR::present(PresentImage* image)
 		if(xImage->data)
 		{
 			VkExtent3D extent = vk::Cast(image->image)->getMipLevelExtent(VK_IMAGE_ASPECT_COLOR_BIT, 0);
-			libX11->XPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height);
+
+			if(shmSegmentMap.count(image))
+			{
+				// The server reads the image's own memory after this returns, and
+				// sends a completion event once it's done.
+				libX11->XShmPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height, True);
+				pendingImages.insert(image);
+			}
+			else
+			{
+				libX11->XPutImage(pDisplay, window, gc, xImage, 0, 0, 0, 0, extent.width, extent.height);
+			}
+
+			// Nothing else flushes the surface's requests to the server.
+			libX11->XFlush(pDisplay);
+		}
+	}
+}
+
+void XlibSurfaceKHR::waitForImage(PresentImage* image)
+{
+	DisplayLock lock(this);
+	waitForCompletion(image);
+}
+
+void XlibSurfaceKHR::waitForCompletion(PresentImage* image)
+{
+	// Only the surface's private connection receives these events, so no
+	// event meant for the application is consumed here.
+	while(pendingImages.count(image))
+	{
+		XEvent event;
+		libX11->XNextEvent(pDisplay, &event);
+
+		if(event.type != shmCompletionEvent)
+		{
+			continue;
+		}
+
+		const XShmCompletionEvent* completion = reinterpret_cast<const XShmCompletionEvent*>(&event);
+		for(auto pending = pendingImages.begin(); pending != pendingImages.end(); pending++)
+		{
+			if(shmSegmentMap[*pending].shmseg == completion->shmseg)
+			{
+				pendingImages.erase(pending);
+				break;
+			}
 		}
 	}
 }
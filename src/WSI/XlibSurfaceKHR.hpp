@@ -22,6 +22,8 @@
 #include "vulkan/vulkan_xlib.h"
 
 #include <map>
+#include <mutex>
+#include <set>
 
 namespace vk {
 
@@ -35,16 +37,45 @@ public:
 
 	void getSurfaceCapabilities(VkSurfaceCapabilitiesKHR *pSurfaceCapabilities) const override;
 
+	void* allocateImageMemory(PresentImage* image, VkDeviceSize size) override;
 	virtual void attachImage(PresentImage* image) override;
 	virtual void detachImage(PresentImage* image) override;
 	void present(PresentImage* image) override;
+	void waitForImage(PresentImage* image) override;
 
 private:
+	XImage* createSharedImage(PresentImage* image, int depth, VkDeviceSize size, XShmSegmentInfo &shmInfo);
+	void waitForCompletion(PresentImage* image);
+
+	// Images are presented from the queues' present threads, while the
+	// application keeps using its own display connection. Xlib only makes a
+	// connection safe to use from several threads if XInitThreads() was
+	// called first, so the surface opens a private connection to the same
+	// server instead. The mutex serializes the surface's own calls on it,
+	// from several queues.
+	class DisplayLock
+	{
+	public:
+		DisplayLock(const XlibSurfaceKHR *surface);
+		~DisplayLock();
+
+	private:
+		std::lock_guard<std::mutex> guard;
+		Display *pDisplay;
+		bool shared;
+	};
+
 	Display *pDisplay;
+	bool privateDisplay = false;   // pDisplay was opened by the surface, rather than passed by the application
 	Window window;
 	GC gc;
 	Visual *visual = nullptr;
+	bool mitShm = false;   // Images are rendered into shared memory segments
+	int shmCompletionEvent = 0;
 	std::map<PresentImage*, XImage*> imageMap;
+	std::map<PresentImage*, XShmSegmentInfo> shmSegmentMap;
+	std::set<PresentImage*> pendingImages;   // Still read by the server
+	mutable std::mutex surfaceMutex;
 };
 
 }
@@ -32,16 +32,21 @@ LibX11exports::LibX11exports(void *libX11, void *libXext)
 	XDefaultVisual = (Visual *(*)(Display*, int screen_number))getProcAddress(libX11, "XDefaultVisual");
 	XSetErrorHandler = (int (*(*)(int (*)(Display*, XErrorEvent*)))(Display*, XErrorEvent*))getProcAddress(libX11, "XSetErrorHandler");
 	XSync = (int (*)(Display*, Bool))getProcAddress(libX11, "XSync");
+	XFlush = (int (*)(Display*))getProcAddress(libX11, "XFlush");
+	XNextEvent = (int (*)(Display*, XEvent*))getProcAddress(libX11, "XNextEvent");
 	XCreateImage = (XImage *(*)(Display*, Visual*, unsigned int, int, int, char*, unsigned int, unsigned int, int, int))getProcAddress(libX11, "XCreateImage");
 	XCloseDisplay = (int (*)(Display*))getProcAddress(libX11, "XCloseDisplay");
 	XPutImage = (int (*)(Display*, Drawable, GC, XImage*, int, int, int, int, unsigned int, unsigned int))getProcAddress(libX11, "XPutImage");
 	XDrawString = (int (*)(Display*, Drawable, GC, int, int, char*, int))getProcAddress(libX11, "XDrawString");
+	XLockDisplay = (void (*)(Display*))getProcAddress(libX11, "XLockDisplay");
+	XUnlockDisplay = (void (*)(Display*))getProcAddress(libX11, "XUnlockDisplay");
 
 	XShmQueryExtension = (Bool (*)(Display*))getProcAddress(libXext, "XShmQueryExtension");
 	XShmCreateImage = (XImage *(*)(Display*, Visual*, unsigned int, int, char*, XShmSegmentInfo*, unsigned int, unsigned int))getProcAddress(libXext, "XShmCreateImage");
 	XShmAttach = (Bool (*)(Display*, XShmSegmentInfo*))getProcAddress(libXext, "XShmAttach");
 	XShmDetach = (Bool (*)(Display*, XShmSegmentInfo*))getProcAddress(libXext, "XShmDetach");
 	XShmPutImage = (int (*)(Display*, Drawable, GC, XImage*, int, int, int, int, unsigned int, unsigned int, bool))getProcAddress(libXext, "XShmPutImage");
+	XShmGetEventBase = (int (*)(Display*))getProcAddress(libXext, "XShmGetEventBase");
 }
 
 LibX11exports *LibX11::operator->()
@@ -36,16 +36,21 @@ struct LibX11exports
 	Visual *(*XDefaultVisual)(Display *display, int screen_number);
 	int (*(*XSetErrorHandler)(int (*handler)(Display*, XErrorEvent*)))(Display*, XErrorEvent*);
 	int (*XSync)(Display *display, Bool discard);
+	int (*XFlush)(Display *display);
+	int (*XNextEvent)(Display *display, XEvent *event_return);
 	XImage *(*XCreateImage)(Display *display, Visual *visual, unsigned int depth, int format, int offset, char *data, unsigned int width, unsigned int height, int bitmap_pad, int bytes_per_line);
 	int (*XCloseDisplay)(Display *display);
 	int (*XPutImage)(Display *display, Drawable d, GC gc, XImage *image, int src_x, int src_y, int dest_x, int dest_y, unsigned int width, unsigned int height);
 	int (*XDrawString)(Display *display, Drawable d, GC gc, int x, int y, char *string, int length);
+	void (*XLockDisplay)(Display *display);
+	void (*XUnlockDisplay)(Display *display);
 
 	Bool (*XShmQueryExtension)(Display *display);
 	XImage *(*XShmCreateImage)(Display *display, Visual *visual, unsigned int depth, int format, char *data, XShmSegmentInfo *shminfo, unsigned int width, unsigned int height);
 	Bool (*XShmAttach)(Display *display, XShmSegmentInfo *shminfo);
 	Bool (*XShmDetach)(Display *display, XShmSegmentInfo *shminfo);
 	int (*XShmPutImage)(Display *display, Drawable d, GC gc, XImage *image, int src_x, int src_y, int dest_x, int dest_y, unsigned int width, unsigned int height, bool send_event);
+	int (*XShmGetEventBase)(Display *display);
 };
 
 #undef Bool // b/127920555
@@ -0,0 +1,85 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Reactor benchmarks, which report the throughput of operations whose cost
+// matters for the drivers built on Reactor.
+
+#include "Reactor.hpp"
+#include "ReactorTestRoutines.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace rr;
+
+namespace
+{
+
+// Compiles routines on an increasing number of threads, and reports the
+// compilation throughput. Reactor compiles independent routines
+// concurrently, so the throughput scales with the number of cores.
+void MultithreadedCompile(int maxThreads)
+{
+	const int degree = 64;
+	const int routinesPerThread = 16;
+
+	for(int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+	{
+		std::vector<std::thread> threads;
+
+		auto start = std::chrono::steady_clock::now();
+
+		for(int t = 0; t < threadCount; t++)
+		{
+			threads.emplace_back([]
+			{
+				for(int i = 0; i < routinesPerThread; i++)
+				{
+					delete generatePolynomial(degree);
+				}
+			});
+		}
+
+		for(auto &thread : threads)
+		{
+			thread.join();
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		double throughput = threadCount * routinesPerThread / elapsed.count();
+
+		printf("MultithreadedCompile: %d thread(s): %.1f routines/s\n", threadCount, throughput);
+	}
+}
+
+}  // anonymous namespace
+
+// Usage: ReactorBenchmarks [max thread count]
+int main(int argc, char **argv)
+{
+	int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	if(argc > 1)
+	{
+		maxThreads = std::max(1, atoi(argv[1]));
+	}
+
+	MultithreadedCompile(maxThreads);
+
+	return 0;
+}
@@ -0,0 +1,534 @@
+// Copyright 2019 The SwiftShader Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Vulkan benchmarks, which report the throughput of API calls whose cost
+// matters to applications. They use the driver and device helpers of the
+// Vulkan unit tests.
+
+#include "Driver.hpp"
+#include "Device.hpp"
+
+#if defined(VK_USE_PLATFORM_XLIB_KHR)
+#include <X11/Xlib.h>
+#include <vulkan/vulkan_xlib.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+#define VK_CHECK(x)                                            \
+    if((x) != VK_SUCCESS)                                      \
+    {                                                          \
+        printf("%s:%d: %s failed\n", __FILE__, __LINE__, #x);  \
+        return false;                                          \
+    }
+
+// Measures the throughput of vkUpdateDescriptorSets for combined image
+// samplers. Sampled image descriptor writes copy the texture layout which
+// each image view computes at creation, so this should be independent of the
+// number of mip levels.
+bool CombinedImageSamplerDescriptorUpdate(Device* device)
+{
+    static constexpr uint32_t descriptorCount = 64;
+    static constexpr int iterations = 10000;
+    static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+    VkImage image;
+    VK_CHECK(device->CreateSampledImage(format, 256, 256, 9, &image));
+
+    VkMemoryRequirements memoryRequirements;
+    device->GetImageMemoryRequirements(image, &memoryRequirements);
+
+    VkDeviceMemory memory;
+    VK_CHECK(device->AllocateMemory(memoryRequirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &memory));
+    VK_CHECK(device->BindImageMemory(image, memory, 0));
+
+    VkImageView imageView;
+    VK_CHECK(device->CreateImageView(image, format, &imageView));
+
+    VkSampler sampler;
+    VK_CHECK(device->CreateSampler(&sampler));
+
+    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings =
+    {
+        {
+            0,                                          // binding
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // descriptorType
+            descriptorCount,                            // descriptorCount
+            VK_SHADER_STAGE_COMPUTE_BIT,                // stageFlags
+            0,                                          // pImmutableSamplers
+        },
+    };
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VK_CHECK(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+    VkDescriptorPool descriptorPool;
+    VK_CHECK(device->CreateDescriptorPool({ { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, descriptorCount } }, &descriptorPool));
+
+    VkDescriptorSet descriptorSet;
+    VK_CHECK(device->AllocateDescriptorSet(descriptorPool, descriptorSetLayout, &descriptorSet));
+
+    std::vector<VkDescriptorImageInfo> descriptorImageInfos(descriptorCount,
+        {
+            sampler,                                   // sampler
+            imageView,                                 // imageView
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  // imageLayout
+        });
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < iterations; i++)
+    {
+        device->UpdateCombinedImageSamplerDescriptorSet(descriptorSet, 0, descriptorImageInfos);
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+    printf("CombinedImageSamplerDescriptorUpdate: %d x %u updates: %.1f ns per descriptor\n",
+           iterations, descriptorCount, elapsed.count() / (iterations * descriptorCount));
+
+    device->DestroyDescriptorPool(descriptorPool);
+    device->DestroyDescriptorSetLayout(descriptorSetLayout);
+    device->DestroySampler(sampler);
+    device->DestroyImageView(imageView);
+    device->DestroyImage(image);
+    device->FreeMemory(memory);
+
+    return true;
+}
+
+// A compressed texture of the ETC2 decoding corpus.
+struct CompressedTexture
+{
+    std::string name;
+    VkFormat format;
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> data;
+};
+
+uint32_t BlockSize(VkFormat format)
+{
+    switch(format)
+    {
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+        return 16;
+    default:
+        return 8;
+    }
+}
+
+const char* FormatName(VkFormat format)
+{
+    switch(format)
+    {
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:   return "ETC2 RGB8";
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK: return "ETC2 RGB8A1";
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK: return "ETC2 RGBA8";
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:       return "EAC R11";
+    case VK_FORMAT_EAC_R11_SNORM_BLOCK:       return "EAC R11 signed";
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:    return "EAC RG11";
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:    return "EAC RG11 signed";
+    default:                                  return "?";
+    }
+}
+
+// Reads a texture from a PKM file, as written by the etcpack encoder. Its
+// header holds the format and the extent padded to whole blocks, in big
+// endian 16-bit words, which the blocks follow.
+bool LoadPKM(const char* path, CompressedTexture& texture)
+{
+    FILE* file = fopen(path, "rb");
+    if(!file)
+    {
+        printf("Failed to open %s\n", path);
+        return false;
+    }
+
+    uint8_t header[16];
+    bool valid = (fread(header, 1, sizeof(header), file) == sizeof(header)) && (memcmp(header, "PKM ", 4) == 0);
+
+    static const VkFormat formats[] =
+    {
+        VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK,    // ETC1 RGB
+        VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK,    // ETC2 RGB
+        VK_FORMAT_UNDEFINED,                  // Obsolete RGBA
+        VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK,  // ETC2 RGBA
+        VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK,  // ETC2 RGBA1
+        VK_FORMAT_EAC_R11_UNORM_BLOCK,        // EAC R
+        VK_FORMAT_EAC_R11G11_UNORM_BLOCK,     // EAC RG
+        VK_FORMAT_EAC_R11_SNORM_BLOCK,        // EAC signed R
+        VK_FORMAT_EAC_R11G11_SNORM_BLOCK,     // EAC signed RG
+    };
+
+    uint32_t type = (header[6] << 8) | header[7];
+    texture.name = path;
+    texture.format = (valid && (type < sizeof(formats) / sizeof(formats[0]))) ? formats[type] : VK_FORMAT_UNDEFINED;
+    texture.width = (header[8] << 8) | header[9];
+    texture.height = (header[10] << 8) | header[11];
+    texture.data.resize(((texture.width + 3) / 4) * ((texture.height + 3) / 4) * BlockSize(texture.format));
+
+    valid = valid && (texture.format != VK_FORMAT_UNDEFINED) && (texture.width > 0) && (texture.height > 0) &&
+            (fread(texture.data.data(), 1, texture.data.size(), file) == texture.data.size());
+    fclose(file);
+
+    if(!valid)
+    {
+        printf("%s is not a supported PKM file\n", path);
+    }
+
+    return valid;
+}
+
+// Textures of random blocks, which use every mode of their format about as
+// often as its encoding allows.
+void AddRandomTextures(std::vector<CompressedTexture>& corpus)
+{
+    static const VkFormat formats[] =
+    {
+        VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK,
+        VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK,
+        VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK,
+        VK_FORMAT_EAC_R11_UNORM_BLOCK,
+        VK_FORMAT_EAC_R11G11_UNORM_BLOCK,
+    };
+
+    std::mt19937 random(0);
+
+    for(VkFormat format : formats)
+    {
+        CompressedTexture texture;
+        texture.name = "random";
+        texture.format = format;
+        texture.width = 2048;
+        texture.height = 2048;
+        texture.data.resize((texture.width / 4) * (texture.height / 4) * BlockSize(format));
+
+        for(uint8_t& byte : texture.data)
+        {
+            byte = static_cast<uint8_t>(random());
+        }
+
+        corpus.push_back(std::move(texture));
+    }
+}
+
+// Measures the throughput of decoding ETC2 and EAC textures, which happens
+// when a copy into a compressed image completes. The copy itself only moves
+// the compressed blocks, which are an eighth or a quarter of the decoded size.
+bool ETC2Decode(Driver* driver, Device* device, const std::vector<CompressedTexture>& corpus)
+{
+    static constexpr int iterations = 10;
+
+    for(const CompressedTexture& texture : corpus)
+    {
+        VkImage image;
+        VK_CHECK(device->CreateSampledImage(texture.format, texture.width, texture.height, 1, &image));
+
+        VkMemoryRequirements memoryRequirements;
+        device->GetImageMemoryRequirements(image, &memoryRequirements);
+
+        VkDeviceMemory imageMemory;
+        VK_CHECK(device->AllocateMemory(memoryRequirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+        VK_CHECK(device->BindImageMemory(image, imageMemory, 0));
+
+        VkDeviceMemory bufferMemory;
+        VK_CHECK(device->AllocateMemory(texture.data.size(), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &bufferMemory));
+
+        void* blocks;
+        VK_CHECK(device->MapMemory(bufferMemory, 0, texture.data.size(), 0, &blocks));
+        memcpy(blocks, texture.data.data(), texture.data.size());
+        device->UnmapMemory(bufferMemory);
+
+        VkBuffer buffer;
+        VK_CHECK(device->CreateTransferSrcBuffer(bufferMemory, texture.data.size(), 0, &buffer));
+
+        VkCommandPool commandPool;
+        VK_CHECK(device->CreateCommandPool(&commandPool));
+
+        VkCommandBuffer commandBuffer;
+        VK_CHECK(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+        VK_CHECK(device->BeginCommandBuffer(0, commandBuffer));
+
+        VkBufferImageCopy region = {};
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { texture.width, texture.height, 1 };
+        driver->vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        VK_CHECK(driver->vkEndCommandBuffer(commandBuffer));
+
+        VK_CHECK(device->QueueSubmitAndWait(commandBuffer));  // Warm up
+
+        auto start = std::chrono::steady_clock::now();
+
+        for(int i = 0; i < iterations; i++)
+        {
+            VK_CHECK(device->QueueSubmitAndWait(commandBuffer));
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        double texels = static_cast<double>(texture.width) * texture.height;
+
+        printf("ETC2Decode: %s (%s, %ux%u): %.2f ms per copy, %.1f Mtexels/s\n",
+               texture.name.c_str(), FormatName(texture.format), texture.width, texture.height,
+               elapsed.count() / iterations, texels * iterations / (elapsed.count() * 1000));
+
+        device->FreeCommandBuffer(commandPool, commandBuffer);
+        device->DestroyCommandPool(commandPool);
+        device->DestroyBuffer(buffer);
+        device->FreeMemory(bufferMemory);
+        device->DestroyImage(image);
+        device->FreeMemory(imageMemory);
+    }
+
+    return true;
+}
+
+#if defined(VK_USE_PLATFORM_XLIB_KHR)
+// Measures the frame rate of presenting to an X11 window, and the CPU time
+// spent by all of the process' threads per present. Meant to be run on a
+// virtual X server, e.g. with 'xvfb-run vk-benchmarks', so that it measures
+// the driver's presentation path rather than a compositor.
+bool XlibPresent(Driver* driver)
+{
+    static constexpr int frames = 1000;
+    static constexpr unsigned int width = 1280;
+    static constexpr unsigned int height = 720;
+
+    Display* display = XOpenDisplay(nullptr);
+    if(!display)
+    {
+        printf("XlibPresent: skipped, no X display\n");
+        return true;
+    }
+
+    Window window = XCreateSimpleWindow(display, DefaultRootWindow(display), 0, 0, width, height, 0, 0, 0);
+    XMapWindow(display, window);
+    XSync(display, False);
+
+    const char* instanceExtensions[] = { VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_XLIB_SURFACE_EXTENSION_NAME };
+    const VkInstanceCreateInfo instanceCreateInfo = {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+        nullptr,                                 // pNext
+        0,                                       // flags
+        nullptr,                                 // pApplicationInfo
+        0,                                       // enabledLayerCount
+        nullptr,                                 // ppEnabledLayerNames
+        2,                                       // enabledExtensionCount
+        instanceExtensions,                      // ppEnabledExtensionNames
+    };
+
+    VkInstance instance;
+    VK_CHECK(driver->vkCreateInstance(&instanceCreateInfo, nullptr, &instance));
+
+#define VK_FUNCTION(N) auto N = reinterpret_cast<PFN_##N>(driver->vk_icdGetInstanceProcAddr(instance, #N))
+    VK_FUNCTION(vkCreateXlibSurfaceKHR);
+    VK_FUNCTION(vkDestroySurfaceKHR);
+    VK_FUNCTION(vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
+    VK_FUNCTION(vkCreateSwapchainKHR);
+    VK_FUNCTION(vkDestroySwapchainKHR);
+    VK_FUNCTION(vkAcquireNextImageKHR);
+    VK_FUNCTION(vkQueuePresentKHR);
+    VK_FUNCTION(vkCreateSemaphore);
+    VK_FUNCTION(vkDestroySemaphore);
+#undef VK_FUNCTION
+
+    uint32_t physicalDeviceCount = 1;
+    VkPhysicalDevice physicalDevice;
+    VK_CHECK(driver->vkEnumeratePhysicalDevices(instance, &physicalDeviceCount, &physicalDevice));
+
+    const float queuePriority = 1.0f;
+    const VkDeviceQueueCreateInfo deviceQueueCreateInfo = {
+        VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,  // sType
+        nullptr,                                     // pNext
+        0,                                           // flags
+        0,                                           // queueFamilyIndex
+        1,                                           // queueCount
+        &queuePriority,                              // pQueuePriorities
+    };
+
+    const char* deviceExtensions[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    const VkDeviceCreateInfo deviceCreateInfo = {
+        VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,  // sType
+        nullptr,                               // pNext
+        0,                                     // flags
+        1,                                     // queueCreateInfoCount
+        &deviceQueueCreateInfo,                // pQueueCreateInfos
+        0,                                     // enabledLayerCount
+        nullptr,                               // ppEnabledLayerNames
+        1,                                     // enabledExtensionCount
+        deviceExtensions,                      // ppEnabledExtensionNames
+        nullptr,                               // pEnabledFeatures
+    };
+
+    VkDevice device;
+    VK_CHECK(driver->vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device));
+
+    VkQueue queue;
+    driver->vkGetDeviceQueue(device, 0, 0, &queue);
+
+    const VkXlibSurfaceCreateInfoKHR surfaceCreateInfo = {
+        VK_STRUCTURE_TYPE_XLIB_SURFACE_CREATE_INFO_KHR,  // sType
+        nullptr,                                         // pNext
+        0,                                               // flags
+        display,                                         // dpy
+        window,                                          // window
+    };
+
+    VkSurfaceKHR surface;
+    VK_CHECK(vkCreateXlibSurfaceKHR(instance, &surfaceCreateInfo, nullptr, &surface));
+
+    VkSurfaceCapabilitiesKHR capabilities;
+    VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities));
+
+    VkSwapchainCreateInfoKHR swapchainCreateInfo = {};
+    swapchainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+    swapchainCreateInfo.surface = surface;
+    swapchainCreateInfo.minImageCount = capabilities.minImageCount;
+    swapchainCreateInfo.imageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+    swapchainCreateInfo.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+    swapchainCreateInfo.imageExtent = capabilities.currentExtent;
+    swapchainCreateInfo.imageArrayLayers = 1;
+    swapchainCreateInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    swapchainCreateInfo.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    swapchainCreateInfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    swapchainCreateInfo.clipped = VK_TRUE;
+
+    VkSwapchainKHR swapchain;
+    VK_CHECK(vkCreateSwapchainKHR(device, &swapchainCreateInfo, nullptr, &swapchain));
+
+    const VkSemaphoreCreateInfo semaphoreCreateInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, nullptr, 0 };
+
+    VkSemaphore acquired;
+    VK_CHECK(vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &acquired));
+
+    auto start = std::chrono::steady_clock::now();
+    std::clock_t cpuStart = std::clock();
+
+    for(int i = 0; i < frames; i++)
+    {
+        uint32_t imageIndex;
+        VK_CHECK(vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, acquired, VK_NULL_HANDLE, &imageIndex));
+
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &acquired;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &swapchain;
+        presentInfo.pImageIndices = &imageIndex;
+
+        VK_CHECK(vkQueuePresentKHR(queue, &presentInfo));
+    }
+
+    VK_CHECK(driver->vkQueueWaitIdle(queue));
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double cpuTime = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+    printf("XlibPresent: %d x %ux%u frames: %.1f frames/s, %.1f us of CPU time per present\n",
+           frames, swapchainCreateInfo.imageExtent.width, swapchainCreateInfo.imageExtent.height,
+           frames / elapsed.count(), cpuTime * 1e6 / frames);
+
+    vkDestroySemaphore(device, acquired, nullptr);
+    vkDestroySwapchainKHR(device, swapchain, nullptr);
+    vkDestroySurfaceKHR(instance, surface, nullptr);
+    driver->vkDestroyDevice(device, nullptr);
+    driver->vkDestroyInstance(instance, nullptr);
+
+    XDestroyWindow(display, window);
+    XCloseDisplay(display);
+
+    return true;
+}
+#endif
+
+}  // anonymous namespace
+
+// The ETC2 decoding benchmark runs over the PKM textures given as arguments,
+// or over textures of random blocks if there are none.
+int main(int argc, char* argv[])
+{
+    std::vector<CompressedTexture> corpus(argc - 1);
+    for(int i = 1; i < argc; i++)
+    {
+        if(!LoadPKM(argv[i], corpus[i - 1]))
+        {
+            return 1;
+        }
+    }
+
+    if(corpus.empty())
+    {
+        AddRandomTextures(corpus);
+    }
+
+    Driver driver;
+    if(!driver.loadSwiftShader())
+    {
+        printf("Failed to load SwiftShader\n");
+        return 1;
+    }
+
+    const VkInstanceCreateInfo createInfo = {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+        nullptr,                                 // pNext
+        0,                                       // flags
+        nullptr,                                 // pApplicationInfo
+        0,                                       // enabledLayerCount
+        nullptr,                                 // ppEnabledLayerNames
+        0,                                       // enabledExtensionCount
+        nullptr,                                 // ppEnabledExtensionNames
+    };
+
+    VkInstance instance = VK_NULL_HANDLE;
+    if((driver.vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) || !driver.resolve(instance))
+    {
+        printf("Failed to create an instance\n");
+        return 1;
+    }
+
+    std::unique_ptr<Device> device;
+    if((Device::CreateComputeDevice(&driver, instance, device) != VK_SUCCESS) || !device->IsValid())
+    {
+        printf("Failed to create a device\n");
+        return 1;
+    }
+
+    bool success = CombinedImageSamplerDescriptorUpdate(device.get());
+    success = ETC2Decode(&driver, device.get(), corpus) && success;
+
+    device.reset(nullptr);
+    driver.vkDestroyInstance(instance, nullptr);
+
+#if defined(VK_USE_PLATFORM_XLIB_KHR)
+    success = XlibPresent(&driver) && success;
+#endif
+
+    return success ? 0 : 1;
+}
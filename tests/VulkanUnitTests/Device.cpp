@@ -139,16 +139,16 @@ VkResult Device::GetPhysicalDevices(
     return driver->vkEnumeratePhysicalDevices(instance, &count, out.data());
 }
 
-VkResult Device::CreateStorageBuffer(
-		VkDeviceMemory memory, VkDeviceSize size,
-		VkDeviceSize offset, VkBuffer* out) const
+VkResult Device::CreateBuffer(
+		VkDeviceMemory memory, VkDeviceSize size, VkDeviceSize offset,
+		VkBufferUsageFlags usage, VkBuffer* out) const
 {
 	const VkBufferCreateInfo info = {
 		VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, // sType
 		nullptr,                              // pNext
 		0,                                    // flags
 		size,                                 // size
-		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,   // usage
+		usage,                                // usage
 		VK_SHARING_MODE_EXCLUSIVE,            // sharingMode
 		0,                                    // queueFamilyIndexCount
 		nullptr,                              // pQueueFamilyIndices
@@ -171,6 +171,20 @@ VkResult Device::CreateStorageBuffer(
 	return VK_SUCCESS;
 }
 
+VkResult Device::CreateStorageBuffer(
+		VkDeviceMemory memory, VkDeviceSize size,
+		VkDeviceSize offset, VkBuffer* out) const
+{
+	return CreateBuffer(memory, size, offset, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, out);
+}
+
+VkResult Device::CreateTransferSrcBuffer(
+		VkDeviceMemory memory, VkDeviceSize size,
+		VkDeviceSize offset, VkBuffer* out) const
+{
+	return CreateBuffer(memory, size, offset, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, out);
+}
+
 void Device::DestroyBuffer(VkBuffer buffer) const
 {
 	driver->vkDestroyBuffer(device, buffer, nullptr);
@@ -261,6 +275,152 @@ VkResult Device::CreateComputePipeline(
 	return driver->vkCreateComputePipelines(device, 0, 1, &info, 0, out);
 }
 
+VkResult Device::CreateGraphicsPipeline(
+		VkShaderModule vertexModule, VkShaderModule fragmentModule,
+		VkPipelineLayout pipelineLayout, VkRenderPass renderPass,
+		uint32_t width, uint32_t height, VkPipeline* out) const
+{
+	const VkPipelineShaderStageCreateInfo stages[] = {
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, // sType
+			nullptr,                                             // pNext
+			0,                                                   // flags
+			VK_SHADER_STAGE_VERTEX_BIT,                          // stage
+			vertexModule,                                        // module
+			"main",                                              // pName
+			nullptr,                                             // pSpecializationInfo
+		},
+		{
+			VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, // sType
+			nullptr,                                             // pNext
+			0,                                                   // flags
+			VK_SHADER_STAGE_FRAGMENT_BIT,                        // stage
+			fragmentModule,                                      // module
+			"main",                                              // pName
+			nullptr,                                             // pSpecializationInfo
+		},
+	};
+
+	const VkPipelineVertexInputStateCreateInfo vertexInputState = {
+		VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO, // sType
+		nullptr,                                                   // pNext
+		0,                                                         // flags
+		0,                                                         // vertexBindingDescriptionCount
+		nullptr,                                                   // pVertexBindingDescriptions
+		0,                                                         // vertexAttributeDescriptionCount
+		nullptr,                                                   // pVertexAttributeDescriptions
+	};
+
+	const VkPipelineInputAssemblyStateCreateInfo inputAssemblyState = {
+		VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO, // sType
+		nullptr,                                                     // pNext
+		0,                                                           // flags
+		VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,                         // topology
+		VK_FALSE,                                                    // primitiveRestartEnable
+	};
+
+	const VkViewport viewport = {
+		0.0f,          // x
+		0.0f,          // y
+		float(width),  // width
+		float(height), // height
+		0.0f,          // minDepth
+		1.0f,          // maxDepth
+	};
+
+	const VkRect2D scissor = {
+		{ 0, 0 },          // offset
+		{ width, height }, // extent
+	};
+
+	const VkPipelineViewportStateCreateInfo viewportState = {
+		VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO, // sType
+		nullptr,                                               // pNext
+		0,                                                     // flags
+		1,                                                     // viewportCount
+		&viewport,                                             // pViewports
+		1,                                                     // scissorCount
+		&scissor,                                              // pScissors
+	};
+
+	const VkPipelineRasterizationStateCreateInfo rasterizationState = {
+		VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO, // sType
+		nullptr,                                                    // pNext
+		0,                                                          // flags
+		VK_FALSE,                                                   // depthClampEnable
+		VK_FALSE,                                                   // rasterizerDiscardEnable
+		VK_POLYGON_MODE_FILL,                                       // polygonMode
+		VK_CULL_MODE_NONE,                                          // cullMode
+		VK_FRONT_FACE_COUNTER_CLOCKWISE,                            // frontFace
+		VK_FALSE,                                                   // depthBiasEnable
+		0.0f,                                                       // depthBiasConstantFactor
+		0.0f,                                                       // depthBiasClamp
+		0.0f,                                                       // depthBiasSlopeFactor
+		1.0f,                                                       // lineWidth
+	};
+
+	const VkPipelineMultisampleStateCreateInfo multisampleState = {
+		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO, // sType
+		nullptr,                                                  // pNext
+		0,                                                        // flags
+		VK_SAMPLE_COUNT_1_BIT,                                    // rasterizationSamples
+		VK_FALSE,                                                 // sampleShadingEnable
+		0.0f,                                                     // minSampleShading
+		nullptr,                                                  // pSampleMask
+		VK_FALSE,                                                 // alphaToCoverageEnable
+		VK_FALSE,                                                 // alphaToOneEnable
+	};
+
+	const VkPipelineColorBlendAttachmentState colorBlendAttachment = {
+		VK_FALSE,                                 // blendEnable
+		VK_BLEND_FACTOR_ONE,                      // srcColorBlendFactor
+		VK_BLEND_FACTOR_ZERO,                     // dstColorBlendFactor
+		VK_BLEND_OP_ADD,                          // colorBlendOp
+		VK_BLEND_FACTOR_ONE,                      // srcAlphaBlendFactor
+		VK_BLEND_FACTOR_ZERO,                     // dstAlphaBlendFactor
+		VK_BLEND_OP_ADD,                          // alphaBlendOp
+		VK_COLOR_COMPONENT_R_BIT |
+		VK_COLOR_COMPONENT_G_BIT |
+		VK_COLOR_COMPONENT_B_BIT |
+		VK_COLOR_COMPONENT_A_BIT,                 // colorWriteMask
+	};
+
+	const VkPipelineColorBlendStateCreateInfo colorBlendState = {
+		VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO, // sType
+		nullptr,                                                  // pNext
+		0,                                                        // flags
+		VK_FALSE,                                                 // logicOpEnable
+		VK_LOGIC_OP_COPY,                                         // logicOp
+		1,                                                        // attachmentCount
+		&colorBlendAttachment,                                    // pAttachments
+		{ 0.0f, 0.0f, 0.0f, 0.0f },                               // blendConstants
+	};
+
+	VkGraphicsPipelineCreateInfo info = {
+		VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, // sType
+		nullptr,                                         // pNext
+		0,                                               // flags
+		2,                                               // stageCount
+		stages,                                          // pStages
+		&vertexInputState,                               // pVertexInputState
+		&inputAssemblyState,                             // pInputAssemblyState
+		nullptr,                                         // pTessellationState
+		&viewportState,                                  // pViewportState
+		&rasterizationState,                             // pRasterizationState
+		&multisampleState,                               // pMultisampleState
+		nullptr,                                         // pDepthStencilState
+		&colorBlendState,                                // pColorBlendState
+		nullptr,                                         // pDynamicState
+		pipelineLayout,                                  // layout
+		renderPass,                                      // renderPass
+		0,                                               // subpass
+		0,                                               // basePipelineHandle
+		0,                                               // basePipelineIndex
+	};
+
+	return driver->vkCreateGraphicsPipelines(device, 0, 1, &info, 0, out);
+}
+
 void Device::DestroyPipeline(VkPipeline pipeline) const
 {
 	driver->vkDestroyPipeline(device, pipeline, nullptr);
@@ -331,7 +491,283 @@ void Device::UpdateStorageBufferDescriptorSets(
 	driver->vkUpdateDescriptorSets(device, writes.size(), writes.data(), 0, nullptr);
 }
 
+VkResult Device::CreateSampledImage(VkFormat format, uint32_t width,
+		uint32_t height, uint32_t mipLevels, VkImage* out) const
+{
+	VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO, // sType
+		nullptr,                             // pNext
+		0,                                   // flags
+		VK_IMAGE_TYPE_2D,                    // imageType
+		format,                              // format
+		{ width, height, 1 },                // extent
+		mipLevels,                           // mipLevels
+		1,                                   // arrayLayers
+		VK_SAMPLE_COUNT_1_BIT,               // samples
+		VK_IMAGE_TILING_OPTIMAL,             // tiling
+		VK_IMAGE_USAGE_SAMPLED_BIT |
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT,     // usage
+		VK_SHARING_MODE_EXCLUSIVE,           // sharingMode
+		0,                                   // queueFamilyIndexCount
+		nullptr,                             // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,           // initialLayout
+	};
+
+	return driver->vkCreateImage(device, &info, 0, out);
+}
+
+VkResult Device::CreateColorAttachmentImage(VkFormat format, uint32_t width,
+		uint32_t height, VkImage* out) const
+{
+	VkImageCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,  // sType
+		nullptr,                              // pNext
+		0,                                    // flags
+		VK_IMAGE_TYPE_2D,                     // imageType
+		format,                               // format
+		{ width, height, 1 },                 // extent
+		1,                                    // mipLevels
+		1,                                    // arrayLayers
+		VK_SAMPLE_COUNT_1_BIT,                // samples
+		VK_IMAGE_TILING_OPTIMAL,              // tiling
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT,      // usage
+		VK_SHARING_MODE_EXCLUSIVE,            // sharingMode
+		0,                                    // queueFamilyIndexCount
+		nullptr,                              // pQueueFamilyIndices
+		VK_IMAGE_LAYOUT_UNDEFINED,            // initialLayout
+	};
+
+	return driver->vkCreateImage(device, &info, 0, out);
+}
+
+void Device::GetImageMemoryRequirements(VkImage image,
+		VkMemoryRequirements* out) const
+{
+	driver->vkGetImageMemoryRequirements(device, image, out);
+}
+
+VkResult Device::BindImageMemory(VkImage image, VkDeviceMemory memory,
+		VkDeviceSize offset) const
+{
+	return driver->vkBindImageMemory(device, image, memory, offset);
+}
+
+void Device::DestroyImage(VkImage image) const
+{
+	driver->vkDestroyImage(device, image, nullptr);
+}
+
+VkResult Device::CreateImageView(VkImage image, VkFormat format,
+		VkImageView* out) const
+{
+	VkImageViewCreateInfo info = {
+		VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO, // sType
+		nullptr,                                  // pNext
+		0,                                        // flags
+		image,                                    // image
+		VK_IMAGE_VIEW_TYPE_2D,                    // viewType
+		format,                                   // format
+		{
+			// components
+			VK_COMPONENT_SWIZZLE_IDENTITY, // r
+			VK_COMPONENT_SWIZZLE_IDENTITY, // g
+			VK_COMPONENT_SWIZZLE_IDENTITY, // b
+			VK_COMPONENT_SWIZZLE_IDENTITY, // a
+		},
+		{
+			// subresourceRange
+			VK_IMAGE_ASPECT_COLOR_BIT,  // aspectMask
+			0,                          // baseMipLevel
+			VK_REMAINING_MIP_LEVELS,    // levelCount
+			0,                          // baseArrayLayer
+			VK_REMAINING_ARRAY_LAYERS,  // layerCount
+		},
+	};
+
+	return driver->vkCreateImageView(device, &info, 0, out);
+}
+
+void Device::DestroyImageView(VkImageView imageView) const
+{
+	driver->vkDestroyImageView(device, imageView, nullptr);
+}
+
+VkResult Device::CreateSampler(VkSampler* out) const
+{
+	VkSamplerCreateInfo info = {
+		VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,    // sType
+		nullptr,                                  // pNext
+		0,                                        // flags
+		VK_FILTER_LINEAR,                         // magFilter
+		VK_FILTER_LINEAR,                         // minFilter
+		VK_SAMPLER_MIPMAP_MODE_LINEAR,            // mipmapMode
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeU
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeV
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,    // addressModeW
+		0.0f,                                     // mipLodBias
+		VK_FALSE,                                 // anisotropyEnable
+		1.0f,                                     // maxAnisotropy
+		VK_FALSE,                                 // compareEnable
+		VK_COMPARE_OP_NEVER,                      // compareOp
+		0.0f,                                     // minLod
+		VK_LOD_CLAMP_NONE,                        // maxLod
+		VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,  // borderColor
+		VK_FALSE,                                 // unnormalizedCoordinates
+	};
+
+	return driver->vkCreateSampler(device, &info, 0, out);
+}
+
+void Device::DestroySampler(VkSampler sampler) const
+{
+	driver->vkDestroySampler(device, sampler, nullptr);
+}
+
+VkResult Device::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& sizes,
+		VkDescriptorPool* out) const
+{
+	VkDescriptorPoolCreateInfo info = {
+		VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, // sType
+		nullptr,                                       // pNext
+		0,                                             // flags
+		1,                                             // maxSets
+		(uint32_t)sizes.size(),                        // poolSizeCount
+		sizes.data(),                                  // pPoolSizes
+	};
+
+	return driver->vkCreateDescriptorPool(device, &info, 0, out);
+}
+
+void Device::UpdateCombinedImageSamplerDescriptorSet(
+		VkDescriptorSet descriptorSet, uint32_t binding,
+		const std::vector<VkDescriptorImageInfo>& imageInfos) const
+{
+	VkWriteDescriptorSet write = {
+		VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,     // sType
+		nullptr,                                    // pNext
+		descriptorSet,                              // dstSet
+		binding,                                    // dstBinding
+		0,                                          // dstArrayElement
+		(uint32_t)imageInfos.size(),                // descriptorCount
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // descriptorType
+		imageInfos.data(),                          // pImageInfo
+		nullptr,                                    // pBufferInfo
+		nullptr,                                    // pTexelBufferView
+	};
+
+	driver->vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+VkResult Device::CreateRenderPass(VkFormat format, VkRenderPass* out) const
+{
+	const VkAttachmentDescription attachment = {
+		0,                                    // flags
+		format,                               // format
+		VK_SAMPLE_COUNT_1_BIT,                // samples
+		VK_ATTACHMENT_LOAD_OP_CLEAR,          // loadOp
+		VK_ATTACHMENT_STORE_OP_STORE,         // storeOp
+		VK_ATTACHMENT_LOAD_OP_DONT_CARE,      // stencilLoadOp
+		VK_ATTACHMENT_STORE_OP_DONT_CARE,     // stencilStoreOp
+		VK_IMAGE_LAYOUT_UNDEFINED,            // initialLayout
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // finalLayout
+	};
+
+	const VkAttachmentReference colorAttachment = {
+		0,                                        // attachment
+		VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, // layout
+	};
+
+	const VkSubpassDescription subpass = {
+		0,                               // flags
+		VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
+		0,                               // inputAttachmentCount
+		nullptr,                         // pInputAttachments
+		1,                               // colorAttachmentCount
+		&colorAttachment,                // pColorAttachments
+		nullptr,                         // pResolveAttachments
+		nullptr,                         // pDepthStencilAttachment
+		0,                               // preserveAttachmentCount
+		nullptr,                         // pPreserveAttachments
+	};
+
+	VkRenderPassCreateInfo info = {
+		VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO, // sType
+		nullptr,                                   // pNext
+		0,                                         // flags
+		1,                                         // attachmentCount
+		&attachment,                               // pAttachments
+		1,                                         // subpassCount
+		&subpass,                                  // pSubpasses
+		0,                                         // dependencyCount
+		nullptr,                                   // pDependencies
+	};
+
+	return driver->vkCreateRenderPass(device, &info, 0, out);
+}
+
+void Device::DestroyRenderPass(VkRenderPass renderPass) const
+{
+	driver->vkDestroyRenderPass(device, renderPass, nullptr);
+}
+
+VkResult Device::CreateFramebuffer(VkRenderPass renderPass,
+		VkImageView attachment, uint32_t width, uint32_t height,
+		VkFramebuffer* out) const
+{
+	VkFramebufferCreateInfo info = {
+		VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO, // sType
+		nullptr,                                   // pNext
+		0,                                         // flags
+		renderPass,                                // renderPass
+		1,                                         // attachmentCount
+		&attachment,                               // pAttachments
+		width,                                     // width
+		height,                                    // height
+		1,                                         // layers
+	};
+
+	return driver->vkCreateFramebuffer(device, &info, 0, out);
+}
+
+void Device::DestroyFramebuffer(VkFramebuffer framebuffer) const
+{
+	driver->vkDestroyFramebuffer(device, framebuffer, nullptr);
+}
+
+VkResult Device::CreatePipelineStatisticsQueryPool(
+		VkQueryPipelineStatisticFlags statistics, VkQueryPool* out) const
+{
+	VkQueryPoolCreateInfo info = {
+		VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO, // sType
+		nullptr,                                  // pNext
+		0,                                        // flags
+		VK_QUERY_TYPE_PIPELINE_STATISTICS,        // queryType
+		1,                                        // queryCount
+		statistics,                               // pipelineStatistics
+	};
+
+	return driver->vkCreateQueryPool(device, &info, 0, out);
+}
+
+VkResult Device::GetQueryPoolResults(VkQueryPool queryPool, size_t dataSize,
+		void* data, VkDeviceSize stride, VkQueryResultFlags flags) const
+{
+	return driver->vkGetQueryPoolResults(device, queryPool, 0, 1, dataSize, data, stride, flags);
+}
+
+void Device::DestroyQueryPool(VkQueryPool queryPool) const
+{
+	driver->vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
 VkResult Device::AllocateMemory(size_t size, VkMemoryPropertyFlags flags, VkDeviceMemory* out) const
+{
+	return AllocateMemory(size, flags, nullptr, out);
+}
+
+VkResult Device::AllocateMemory(size_t size, VkMemoryPropertyFlags flags,
+		const void* pNext, VkDeviceMemory* out) const
 {
 	VkPhysicalDeviceMemoryProperties properties;
 	driver->vkGetPhysicalDeviceMemoryProperties(physicalDevice, &properties);
@@ -350,7 +786,7 @@ VkResult Device::AllocateMemory(size_t size, VkMemoryPropertyFlags flags, VkDevi
 
 		const VkMemoryAllocateInfo info = {
 			VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,  // sType
-			nullptr,                                 // pNext
+			pNext,                                   // pNext
 			size,                                    // allocationSize
 			type,                                    // memoryTypeIndex
 		};
@@ -366,6 +802,20 @@ void Device::FreeMemory(VkDeviceMemory memory) const
 	driver->vkFreeMemory(device, memory, nullptr);
 }
 
+#if defined(__linux__)
+VkResult Device::GetMemoryFd(VkDeviceMemory memory, int* out) const
+{
+	VkMemoryGetFdInfoKHR info = {
+		VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,     // sType
+		nullptr,                                      // pNext
+		memory,                                       // memory
+		VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT, // handleType
+	};
+
+	return driver->vkGetMemoryFdKHR(device, &info, out);
+}
+#endif
+
 VkResult Device::MapMemory(VkDeviceMemory memory, VkDeviceSize offset,
 		VkDeviceSize size, VkMemoryMapFlags flags, void **ppData) const
 {
@@ -40,12 +40,23 @@ public:
 	// IsValid returns true if the Device is initialized and can be used.
 	bool IsValid() const;
 
-	// CreateBuffer creates a new buffer with the
+	// CreateBuffer creates a new buffer with the given usage, and
+	// VK_SHARING_MODE_EXCLUSIVE sharing mode, bound to memory at offset.
+	VkResult CreateBuffer(VkDeviceMemory memory, VkDeviceSize size,
+			VkDeviceSize offset, VkBufferUsageFlags usage, VkBuffer *out) const;
+
+	// CreateStorageBuffer creates a new buffer with the
 	// VK_BUFFER_USAGE_STORAGE_BUFFER_BIT usage, and
 	// VK_SHARING_MODE_EXCLUSIVE sharing mode.
 	VkResult CreateStorageBuffer(VkDeviceMemory memory, VkDeviceSize size,
 			VkDeviceSize offset, VkBuffer *out) const;
 
+	// CreateTransferSrcBuffer creates a new buffer with the
+	// VK_BUFFER_USAGE_TRANSFER_SRC_BIT usage, and
+	// VK_SHARING_MODE_EXCLUSIVE sharing mode.
+	VkResult CreateTransferSrcBuffer(VkDeviceMemory memory, VkDeviceSize size,
+			VkDeviceSize offset, VkBuffer *out) const;
+
 	// DestroyBuffer destroys a VkBuffer.
 	void DestroyBuffer(VkBuffer buffer) const;
 
@@ -79,6 +90,17 @@ public:
 			VkPipelineLayout pipelineLayout,
 			VkPipeline *out) const;
 
+	// CreateGraphicsPipeline creates a new graphics pipeline for the first
+	// subpass of renderPass, drawing triangle lists without vertex inputs,
+	// culling, depth testing or blending, onto a width x height viewport.
+	// Both shader modules have the entry point "main".
+	VkResult CreateGraphicsPipeline(VkShaderModule vertexModule,
+			VkShaderModule fragmentModule,
+			VkPipelineLayout pipelineLayout,
+			VkRenderPass renderPass,
+			uint32_t width, uint32_t height,
+			VkPipeline *out) const;
+
 	// DestroyPipeline destroys a graphics or compute pipeline.
 	void DestroyPipeline(VkPipeline pipeline) const;
 
@@ -101,12 +123,104 @@ public:
 	void UpdateStorageBufferDescriptorSets(VkDescriptorSet descriptorSet,
 		const std::vector<VkDescriptorBufferInfo> &bufferInfos) const;
 
+	// CreateSampledImage creates a new unbound 2D image with the
+	// VK_IMAGE_USAGE_SAMPLED_BIT and VK_IMAGE_USAGE_TRANSFER_DST_BIT usages
+	// and optimal tiling.
+	VkResult CreateSampledImage(VkFormat format, uint32_t width, uint32_t height,
+			uint32_t mipLevels, VkImage *out) const;
+
+	// CreateColorAttachmentImage creates a new unbound 2D image with the
+	// VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT and VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+	// usages and optimal tiling.
+	VkResult CreateColorAttachmentImage(VkFormat format, uint32_t width,
+			uint32_t height, VkImage *out) const;
+
+	// GetImageMemoryRequirements wraps vkGetImageMemoryRequirements,
+	// supplying the first VkDevice parameter.
+	void GetImageMemoryRequirements(VkImage image,
+			VkMemoryRequirements *out) const;
+
+	// BindImageMemory wraps vkBindImageMemory, supplying the first VkDevice
+	// parameter.
+	VkResult BindImageMemory(VkImage image, VkDeviceMemory memory,
+			VkDeviceSize offset) const;
+
+	// DestroyImage destroys a VkImage.
+	void DestroyImage(VkImage image) const;
+
+	// CreateImageView creates a new 2D color view of all the mip levels of
+	// image.
+	VkResult CreateImageView(VkImage image, VkFormat format,
+			VkImageView *out) const;
+
+	// DestroyImageView destroys a VkImageView.
+	void DestroyImageView(VkImageView imageView) const;
+
+	// CreateSampler creates a new sampler with linear filtering and
+	// clamp-to-edge addressing.
+	VkResult CreateSampler(VkSampler *out) const;
+
+	// DestroySampler destroys a VkSampler.
+	void DestroySampler(VkSampler sampler) const;
+
+	// CreateDescriptorPool creates a new descriptor pool that can hold a
+	// single set with the given descriptors.
+	VkResult CreateDescriptorPool(const std::vector<VkDescriptorPoolSize> &sizes,
+			VkDescriptorPool *out) const;
+
+	// UpdateCombinedImageSamplerDescriptorSet updates the array of combined
+	// image samplers at the given binding of descriptorSet with the given
+	// list of VkDescriptorImageInfos.
+	void UpdateCombinedImageSamplerDescriptorSet(VkDescriptorSet descriptorSet,
+		uint32_t binding, const std::vector<VkDescriptorImageInfo> &imageInfos) const;
+
+	// CreateRenderPass creates a new render pass with a single subpass,
+	// writing to a single color attachment. The attachment is cleared when
+	// the render pass begins, and left in the
+	// VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL layout when it ends.
+	VkResult CreateRenderPass(VkFormat format, VkRenderPass *out) const;
+
+	// DestroyRenderPass destroys a VkRenderPass.
+	void DestroyRenderPass(VkRenderPass renderPass) const;
+
+	// CreateFramebuffer creates a new framebuffer for renderPass, with the
+	// single given attachment.
+	VkResult CreateFramebuffer(VkRenderPass renderPass, VkImageView attachment,
+			uint32_t width, uint32_t height, VkFramebuffer *out) const;
+
+	// DestroyFramebuffer destroys a VkFramebuffer.
+	void DestroyFramebuffer(VkFramebuffer framebuffer) const;
+
+	// CreatePipelineStatisticsQueryPool creates a new pool of a single
+	// pipeline statistics query, gathering the given statistics.
+	VkResult CreatePipelineStatisticsQueryPool(
+			VkQueryPipelineStatisticFlags statistics, VkQueryPool *out) const;
+
+	// GetQueryPoolResults wraps vkGetQueryPoolResults for the single query
+	// of queryPool, supplying the first VkDevice parameter.
+	VkResult GetQueryPoolResults(VkQueryPool queryPool, size_t dataSize,
+			void *data, VkDeviceSize stride, VkQueryResultFlags flags) const;
+
+	// DestroyQueryPool destroys a VkQueryPool.
+	void DestroyQueryPool(VkQueryPool queryPool) const;
+
 	// AllocateMemory allocates size bytes from a memory heap that has all the
 	// given flag bits set.
 	// If memory could not be allocated from any heap then
 	// VK_ERROR_OUT_OF_DEVICE_MEMORY is returned.
 	VkResult AllocateMemory(size_t size, VkMemoryPropertyFlags flags, VkDeviceMemory* out) const;
 
+	// AllocateMemory allocates size bytes as above, with the given chain of
+	// VkMemoryAllocateInfo extension structures.
+	VkResult AllocateMemory(size_t size, VkMemoryPropertyFlags flags,
+			const void* pNext, VkDeviceMemory* out) const;
+
+#if defined(__linux__)
+	// GetMemoryFd exports memory as a new opaque file descriptor, owned by
+	// the caller. The memory must have been allocated as exportable.
+	VkResult GetMemoryFd(VkDeviceMemory memory, int* out) const;
+#endif
+
 	// FreeMemory frees the VkDeviceMemory.
 	void FreeMemory(VkDeviceMemory memory) const;
 
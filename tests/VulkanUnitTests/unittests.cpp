@@ -26,6 +26,10 @@
 #include <sstream>
 #include <cstring>
 
+#if defined(__linux__)
+#include <fcntl.h>
+#endif
+
 namespace
 {
     size_t alignUp(size_t val, size_t alignment)
@@ -450,6 +454,74 @@ TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, Memcpy)
     test(src.str(), [](uint32_t i) { return i; }, [](uint32_t i) { return i; });
 }
 
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, AtomicMemcpy)
+{
+    // Atomic accesses of sequential elements by the lanes of a subgroup are
+    // performed with single vector loads and stores.
+    std::stringstream src;
+    // #version 450
+    // layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+    // layout(binding = 0, std430) buffer InBuffer
+    // {
+    //     int Data[];
+    // } In;
+    // layout(binding = 1, std430) buffer OutBuffer
+    // {
+    //     int Data[];
+    // } Out;
+    // void main()
+    // {
+    //     atomicStore(Out.Data[gl_GlobalInvocationID.x], atomicLoad(In.Data[gl_GlobalInvocationID.x]));
+    // }
+    src <<
+              "OpCapability Shader\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %1 \"main\" %2\n"
+              "OpExecutionMode %1 LocalSize " <<
+                GetParam().localSizeX << " " <<
+                GetParam().localSizeY << " " <<
+                GetParam().localSizeZ << "\n" <<
+              "OpDecorate %3 ArrayStride 4\n"
+              "OpMemberDecorate %4 0 Offset 0\n"
+              "OpDecorate %4 BufferBlock\n"
+              "OpDecorate %5 DescriptorSet 0\n"
+              "OpDecorate %5 Binding 1\n"
+              "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+              "OpDecorate %6 DescriptorSet 0\n"
+              "OpDecorate %6 Binding 0\n"
+         "%7 = OpTypeVoid\n"
+         "%8 = OpTypeFunction %7\n"             // void()
+         "%9 = OpTypeInt 32 1\n"                // int32
+        "%10 = OpTypeInt 32 0\n"                // uint32
+         "%3 = OpTypeRuntimeArray %9\n"         // int32[]
+         "%4 = OpTypeStruct %3\n"               // struct{ int32[] }
+        "%11 = OpTypePointer Uniform %4\n"      // struct{ int32[] }*
+         "%5 = OpVariable %11 Uniform\n"        // struct{ int32[] }* in
+        "%12 = OpConstant %9 0\n"               // int32(0)
+        "%13 = OpConstant %10 0\n"              // uint32(0)
+        "%14 = OpTypeVector %10 3\n"            // vec3<int32>
+        "%15 = OpTypePointer Input %14\n"       // vec3<int32>*
+         "%2 = OpVariable %15 Input\n"          // gl_GlobalInvocationId
+        "%16 = OpTypePointer Input %10\n"       // uint32*
+         "%6 = OpVariable %11 Uniform\n"        // struct{ int32[] }* out
+        "%17 = OpTypePointer Uniform %9\n"      // int32*
+        "%18 = OpConstant %10 1\n"              // uint32(1) (Device scope)
+        "%19 = OpConstant %10 66\n"             // uint32(0x42) (UniformMemory | Acquire semantics)
+        "%20 = OpConstant %10 68\n"             // uint32(0x44) (UniformMemory | Release semantics)
+         "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%21 = OpLabel\n"
+        "%22 = OpAccessChain %16 %2 %13\n"      // &gl_GlobalInvocationId.x
+        "%23 = OpLoad %10 %22\n"                // gl_GlobalInvocationId.x
+        "%24 = OpAccessChain %17 %6 %12 %23\n"  // &in.arr[gl_GlobalInvocationId.x]
+        "%25 = OpAtomicLoad %9 %24 %18 %19\n"   // atomicLoad(in.arr[gl_GlobalInvocationId.x])
+        "%26 = OpAccessChain %17 %5 %12 %23\n"  // &out.arr[gl_GlobalInvocationId.x]
+              "OpAtomicStore %26 %18 %20 %25\n" // atomicStore(out.arr[gl_GlobalInvocationId.x], ...)
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+
+    test(src.str(), [](uint32_t i) { return i; }, [](uint32_t i) { return i; });
+}
+
 TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, GlobalInvocationId)
 {
     std::stringstream src;
@@ -1498,3 +1570,1281 @@ TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, LoopDivergentMergePhi)
               "OpFunctionEnd\n";
     test(src.str(), [](uint32_t i) { return i; }, [](uint32_t i) { return i; });
 }
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, BranchUniformEscapingValues)
+{
+    // The condition is uniform, so neither target is entered by any lane from
+    // the other side and both may be skipped. Each target defines values that
+    // are used beyond it, past a nested divergent branch.
+    std::stringstream src;
+    src <<
+              "OpCapability Shader\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %1 \"main\" %2\n"
+              "OpExecutionMode %1 LocalSize " <<
+                GetParam().localSizeX << " " <<
+                GetParam().localSizeY << " " <<
+                GetParam().localSizeZ << "\n" <<
+              "OpDecorate %3 ArrayStride 4\n"
+              "OpMemberDecorate %4 0 Offset 0\n"
+              "OpDecorate %4 BufferBlock\n"
+              "OpDecorate %5 DescriptorSet 0\n"
+              "OpDecorate %5 Binding 1\n"
+              "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+              "OpDecorate %6 DescriptorSet 0\n"
+              "OpDecorate %6 Binding 0\n"
+         "%7 = OpTypeVoid\n"
+         "%8 = OpTypeFunction %7\n"             // void()
+         "%9 = OpTypeInt 32 1\n"                // int32
+        "%10 = OpTypeInt 32 0\n"                // uint32
+        "%11 = OpTypeBool\n"
+         "%3 = OpTypeRuntimeArray %9\n"         // int32[]
+         "%4 = OpTypeStruct %3\n"               // struct{ int32[] }
+        "%12 = OpTypePointer Uniform %4\n"      // struct{ int32[] }*
+         "%5 = OpVariable %12 Uniform\n"        // struct{ int32[] }* in
+        "%13 = OpConstant %9 0\n"               // int32(0)
+        "%14 = OpConstant %9 1\n"               // int32(1)
+        "%15 = OpConstant %9 2\n"               // int32(2)
+        "%16 = OpConstant %10 0\n"              // uint32(0)
+        "%17 = OpTypeVector %10 3\n"            // vec4<int32>
+        "%18 = OpTypePointer Input %17\n"       // vec4<int32>*
+         "%2 = OpVariable %18 Input\n"          // gl_GlobalInvocationId
+        "%19 = OpTypePointer Input %10\n"       // uint32*
+         "%6 = OpVariable %12 Uniform\n"        // struct{ int32[] }* out
+        "%20 = OpTypePointer Uniform %9\n"      // int32*
+        "%21 = OpConstant %9 3\n"               // int32(3)
+         "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%22 = OpLabel\n"
+        "%23 = OpAccessChain %19 %2 %16\n"      // &gl_GlobalInvocationId.x
+        "%24 = OpLoad %10 %23\n"                // gl_GlobalInvocationId.x
+        "%25 = OpAccessChain %20 %6 %13 %24\n"  // &in.arr[gl_GlobalInvocationId.x]
+        "%26 = OpLoad %9 %25\n"                 // in.arr[gl_GlobalInvocationId.x]
+    // Start of branch logic
+    // %26 = in value
+        "%27 = OpSLessThan %11 %13 %14\n"       // 0 < 1, the same for all lanes
+              "OpSelectionMerge %28 None\n"
+              "OpBranchConditional %27 %29 %30\n"
+        "%29 = OpLabel\n"                       // taken by all lanes
+        "%31 = OpIAdd %9 %26 %15\n"             // in + 2
+        "%32 = OpAccessChain %20 %5 %13 %24\n"  // &out.arr[gl_GlobalInvocationId.x]
+        "%33 = OpSMod %9 %26 %15\n"             // in % 2
+        "%34 = OpIEqual %11 %33 %13\n"          // (in % 2) == 0
+              "OpSelectionMerge %35 None\n"
+              "OpBranchConditional %34 %36 %37\n"
+        "%36 = OpLabel\n"
+              "OpBranch %35\n"
+        "%37 = OpLabel\n"
+              "OpBranch %35\n"
+        "%35 = OpLabel\n"
+        "%38 = OpPhi %9 %14 %36 %15 %37\n"      // (in % 2) == 0 ? 1 : 2
+        "%39 = OpIAdd %9 %31 %38\n"             // %31 escapes the skippable block
+              "OpStore %32 %39\n"               // so does %32
+              "OpBranch %28\n"
+        "%30 = OpLabel\n"                       // taken by no lane
+        "%40 = OpIMul %9 %26 %21\n"             // in * 3
+        "%41 = OpAccessChain %20 %5 %13 %24\n"  // &out.arr[gl_GlobalInvocationId.x]
+        "%42 = OpSMod %9 %26 %15\n"             // in % 2
+        "%43 = OpIEqual %11 %42 %13\n"          // (in % 2) == 0
+              "OpSelectionMerge %44 None\n"
+              "OpBranchConditional %43 %45 %46\n"
+        "%45 = OpLabel\n"
+              "OpBranch %44\n"
+        "%46 = OpLabel\n"
+              "OpBranch %44\n"
+        "%44 = OpLabel\n"
+        "%47 = OpPhi %9 %14 %45 %15 %46\n"      // (in % 2) == 0 ? 1 : 2
+        "%48 = OpIAdd %9 %40 %47\n"
+              "OpStore %41 %48\n"               // must not be written
+              "OpBranch %28\n"
+        "%28 = OpLabel\n"                       // merge
+    // End of branch logic
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+
+    test(src.str(), [](uint32_t i) { return i; }, [](uint32_t i) { return i + 2 + ((i % 2) == 0 ? 1 : 2); });
+}
+
+TEST_P(SwiftShaderVulkanBufferToBufferComputeTest, BranchDivergentEscapingValues)
+{
+    // Both targets are long enough to be skipped when none of the lanes of a
+    // SIMD group take them, which happens as the condition changes every four
+    // invocations. Each defines intermediates, a pointer to the function's
+    // variable and a pointer to the output which are used beyond it, past a
+    // nested divergent branch.
+    std::stringstream src;
+    src <<
+              "OpCapability Shader\n"
+              "OpMemoryModel Logical GLSL450\n"
+              "OpEntryPoint GLCompute %1 \"main\" %2\n"
+              "OpExecutionMode %1 LocalSize " <<
+                GetParam().localSizeX << " " <<
+                GetParam().localSizeY << " " <<
+                GetParam().localSizeZ << "\n" <<
+              "OpDecorate %3 ArrayStride 4\n"
+              "OpMemberDecorate %4 0 Offset 0\n"
+              "OpDecorate %4 BufferBlock\n"
+              "OpDecorate %5 DescriptorSet 0\n"
+              "OpDecorate %5 Binding 1\n"
+              "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+              "OpDecorate %6 DescriptorSet 0\n"
+              "OpDecorate %6 Binding 0\n"
+         "%7 = OpTypeVoid\n"
+         "%8 = OpTypeFunction %7\n"             // void()
+         "%9 = OpTypeInt 32 1\n"                // int32
+        "%10 = OpTypeInt 32 0\n"                // uint32
+        "%11 = OpTypeBool\n"
+         "%3 = OpTypeRuntimeArray %9\n"         // int32[]
+         "%4 = OpTypeStruct %3\n"               // struct{ int32[] }
+        "%12 = OpTypePointer Uniform %4\n"      // struct{ int32[] }*
+         "%5 = OpVariable %12 Uniform\n"        // struct{ int32[] }* in
+        "%13 = OpConstant %9 0\n"               // int32(0)
+        "%14 = OpConstant %9 1\n"               // int32(1)
+        "%15 = OpConstant %9 2\n"               // int32(2)
+        "%16 = OpConstant %10 0\n"              // uint32(0)
+        "%17 = OpTypeVector %10 3\n"            // vec4<int32>
+        "%18 = OpTypePointer Input %17\n"       // vec4<int32>*
+         "%2 = OpVariable %18 Input\n"          // gl_GlobalInvocationId
+        "%19 = OpTypePointer Input %10\n"       // uint32*
+         "%6 = OpVariable %12 Uniform\n"        // struct{ int32[] }* out
+        "%20 = OpTypePointer Uniform %9\n"      // int32*
+        "%21 = OpConstant %9 3\n"               // int32(3)
+        "%22 = OpConstant %10 2\n"              // uint32(2)
+        "%23 = OpTypeArray %9 %22\n"            // int32[2]
+        "%24 = OpTypePointer Function %23\n"    // int32[2]*
+        "%25 = OpTypePointer Function %9\n"     // int32*
+         "%1 = OpFunction %7 None %8\n"         // -- Function begin --
+        "%26 = OpLabel\n"
+        "%27 = OpVariable %24 Function\n"       // int32 local[2]
+        "%28 = OpAccessChain %19 %2 %16\n"      // &gl_GlobalInvocationId.x
+        "%29 = OpLoad %10 %28\n"                // gl_GlobalInvocationId.x
+        "%30 = OpAccessChain %20 %6 %13 %29\n"  // &in.arr[gl_GlobalInvocationId.x]
+        "%31 = OpLoad %9 %30\n"                 // in.arr[gl_GlobalInvocationId.x]
+    // Start of branch logic
+    // %31 = in value
+        "%32 = OpShiftRightArithmetic %9 %31 %15\n" // in >> 2
+        "%33 = OpBitwiseAnd %9 %32 %14\n"       // (in >> 2) & 1
+        "%34 = OpIEqual %11 %33 %13\n"          // ((in >> 2) & 1) == 0
+              "OpSelectionMerge %35 None\n"
+              "OpBranchConditional %34 %36 %37\n"
+        "%36 = OpLabel\n"                       // ((in >> 2) & 1) == 0
+        "%38 = OpIAdd %9 %31 %15\n"             // in + 2
+        "%39 = OpIMul %9 %38 %21\n"             // (in + 2) * 3
+        "%40 = OpISub %9 %39 %31\n"             // 2 * in + 6
+        "%41 = OpShiftLeftLogical %9 %40 %14\n" // 4 * in + 12
+        "%42 = OpSDiv %9 %41 %15\n"             // 2 * in + 6
+        "%43 = OpAccessChain %25 %27 %13\n"     // &local[0]
+              "OpStore %43 %42\n"
+        "%44 = OpAccessChain %20 %5 %13 %29\n"  // &out.arr[gl_GlobalInvocationId.x]
+        "%45 = OpSMod %9 %31 %15\n"             // in % 2
+        "%46 = OpIEqual %11 %45 %13\n"          // (in % 2) == 0
+              "OpSelectionMerge %47 None\n"
+              "OpBranchConditional %46 %48 %49\n"
+        "%48 = OpLabel\n"
+              "OpBranch %47\n"
+        "%49 = OpLabel\n"
+              "OpBranch %47\n"
+        "%47 = OpLabel\n"
+        "%50 = OpPhi %9 %14 %48 %15 %49\n"      // (in % 2) == 0 ? 1 : 2
+        "%51 = OpLoad %9 %43\n"                 // local[0]
+        "%52 = OpIAdd %9 %51 %50\n"
+        "%53 = OpIAdd %9 %52 %38\n"             // 3 * in + 8 + phi
+              "OpStore %44 %53\n"
+              "OpBranch %35\n"
+        "%37 = OpLabel\n"                       // ((in >> 2) & 1) == 1
+        "%54 = OpIMul %9 %31 %21\n"             // in * 3
+        "%55 = OpISub %9 %54 %15\n"             // 3 * in - 2
+        "%56 = OpIAdd %9 %55 %21\n"             // 3 * in + 1
+        "%57 = OpShiftLeftLogical %9 %56 %14\n" // 6 * in + 2
+        "%58 = OpSDiv %9 %57 %15\n"             // 3 * in + 1
+        "%59 = OpAccessChain %25 %27 %14\n"     // &local[1]
+              "OpStore %59 %58\n"
+        "%60 = OpAccessChain %20 %5 %13 %29\n"  // &out.arr[gl_GlobalInvocationId.x]
+        "%61 = OpSMod %9 %31 %15\n"             // in % 2
+        "%62 = OpIEqual %11 %61 %13\n"          // (in % 2) == 0
+              "OpSelectionMerge %63 None\n"
+              "OpBranchConditional %62 %64 %65\n"
+        "%64 = OpLabel\n"
+              "OpBranch %63\n"
+        "%65 = OpLabel\n"
+              "OpBranch %63\n"
+        "%63 = OpLabel\n"
+        "%66 = OpPhi %9 %15 %64 %21 %65\n"      // (in % 2) == 0 ? 2 : 3
+        "%67 = OpLoad %9 %59\n"                 // local[1]
+        "%68 = OpIAdd %9 %67 %66\n"
+        "%69 = OpIAdd %9 %68 %54\n"             // 6 * in + 1 + phi
+              "OpStore %60 %69\n"
+              "OpBranch %35\n"
+        "%35 = OpLabel\n"                       // merge
+    // End of branch logic
+              "OpReturn\n"
+              "OpFunctionEnd\n";
+
+    test(src.str(), [](uint32_t i) { return i; }, [](uint32_t i) {
+        return ((i >> 2) & 1) == 0 ? 3 * i + 8 + ((i % 2) == 0 ? 1 : 2) : 6 * i + 1 + ((i % 2) == 0 ? 2 : 3);
+    });
+}
+
+// Writes an array of combined image samplers, then samples each mip level of
+// the image through its last element. Sampled image descriptors copy the
+// texture layout which the image view computes at creation.
+TEST_F(SwiftShaderVulkanTest, CombinedImageSamplerDescriptorUpdate)
+{
+    // #version 450
+    // layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+    // layout(binding = 0, std430) buffer OutBuffer
+    // {
+    //     vec4 Data[];
+    // } Out;
+    // layout(binding = 1) uniform sampler2D Textures[4];
+    // void main()
+    // {
+    //     uint i = gl_GlobalInvocationID.x;
+    //     Out.Data[i] = textureLod(Textures[3], vec2(0.5), float(i));
+    // }
+    const char* shader =
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize 1 1 1\n"
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 16\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"
+        "%9 = OpTypeInt 32 0\n"                                 // uint
+        "%10 = OpTypeVector %9 3\n"                             // uvec3
+        "%11 = OpTypePointer Input %10\n"
+        "%2 = OpVariable %11 Input\n"                           // gl_GlobalInvocationID
+        "%12 = OpConstant %9 0\n"
+        "%13 = OpTypePointer Input %9\n"
+        "%14 = OpTypeFloat 32\n"                                // float
+        "%15 = OpTypeVector %14 4\n"                            // vec4
+        "%3 = OpTypeRuntimeArray %15\n"
+        "%4 = OpTypeStruct %3\n"                                // struct OutBuffer
+        "%16 = OpTypePointer Uniform %4\n"
+        "%5 = OpVariable %16 Uniform\n"                         // Out
+        "%17 = OpTypeImage %14 2D 0 0 0 1 Unknown\n"
+        "%18 = OpTypeSampledImage %17\n"                        // sampler2D
+        "%19 = OpConstant %9 4\n"
+        "%20 = OpTypeArray %18 %19\n"
+        "%21 = OpTypePointer UniformConstant %20\n"
+        "%6 = OpVariable %21 UniformConstant\n"                 // Textures
+        "%22 = OpTypeInt 32 1\n"                                // int
+        "%23 = OpConstant %22 3\n"
+        "%24 = OpTypePointer UniformConstant %18\n"
+        "%25 = OpTypeVector %14 2\n"                            // vec2
+        "%26 = OpConstant %14 0.5\n"
+        "%27 = OpConstantComposite %25 %26 %26\n"
+        "%28 = OpConstant %22 0\n"
+        "%29 = OpTypePointer Uniform %15\n"
+        "%1 = OpFunction %7 None %8\n"                          // -- Function begin --
+        "%30 = OpLabel\n"
+        "%31 = OpAccessChain %13 %2 %12\n"                      // &gl_GlobalInvocationID.x
+        "%32 = OpLoad %9 %31\n"                                 // i
+        "%33 = OpAccessChain %24 %6 %23\n"                      // &Textures[3]
+        "%34 = OpLoad %18 %33\n"
+        "%35 = OpConvertUToF %14 %32\n"                         // float(i)
+        "%36 = OpImageSampleExplicitLod %15 %34 %27 Lod %35\n"
+        "%37 = OpAccessChain %29 %5 %28 %32\n"                  // &Out.Data[i]
+        "OpStore %37 %36\n"
+        "OpReturn\n"
+        "OpFunctionEnd\n";                                      // -- Function end --
+
+    auto code = compileSpirv(shader);
+
+    Driver driver;
+    ASSERT_TRUE(driver.loadSwiftShader());
+
+    const VkInstanceCreateInfo createInfo = {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+        nullptr,                                 // pNext
+        0,                                       // flags
+        nullptr,                                 // pApplicationInfo
+        0,                                       // enabledLayerCount
+        nullptr,                                 // ppEnabledLayerNames
+        0,                                       // enabledExtensionCount
+        nullptr,                                 // ppEnabledExtensionNames
+    };
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+    ASSERT_TRUE(driver.resolve(instance));
+
+    std::unique_ptr<Device> device;
+    VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+    ASSERT_TRUE(device->IsValid());
+
+    static constexpr uint32_t descriptorCount = 4;
+    static constexpr uint32_t mipLevels = 4;
+    static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+    // Each mip level is cleared to a color which is exact in the format.
+    const VkClearColorValue colors[mipLevels] =
+    {
+        { { 1.0f, 0.0f, 0.0f, 1.0f } },
+        { { 0.0f, 1.0f, 0.0f, 1.0f } },
+        { { 0.0f, 0.0f, 1.0f, 1.0f } },
+        { { 1.0f, 1.0f, 1.0f, 0.0f } },
+    };
+
+    VkImage image;
+    VK_ASSERT(device->CreateSampledImage(format, 8, 8, mipLevels, &image));
+
+    VkMemoryRequirements memoryRequirements;
+    device->GetImageMemoryRequirements(image, &memoryRequirements);
+
+    VkDeviceMemory imageMemory;
+    VK_ASSERT(device->AllocateMemory(memoryRequirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+    VK_ASSERT(device->BindImageMemory(image, imageMemory, 0));
+
+    VkImageView imageView;
+    VK_ASSERT(device->CreateImageView(image, format, &imageView));
+
+    VkSampler sampler;
+    VK_ASSERT(device->CreateSampler(&sampler));
+
+    size_t bufferSize = sizeof(float) * 4 * mipLevels;
+
+    VkDeviceMemory bufferMemory;
+    VK_ASSERT(device->AllocateMemory(bufferSize,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &bufferMemory));
+
+    VkBuffer buffer;
+    VK_ASSERT(device->CreateStorageBuffer(bufferMemory, bufferSize, 0, &buffer));
+
+    VkShaderModule shaderModule;
+    VK_ASSERT(device->CreateShaderModule(code, &shaderModule));
+
+    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings =
+    {
+        {
+            0,                                          // binding
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // descriptorType
+            1,                                          // descriptorCount
+            VK_SHADER_STAGE_COMPUTE_BIT,                // stageFlags
+            0,                                          // pImmutableSamplers
+        },
+        {
+            1,                                          // binding
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // descriptorType
+            descriptorCount,                            // descriptorCount
+            VK_SHADER_STAGE_COMPUTE_BIT,                // stageFlags
+            0,                                          // pImmutableSamplers
+        },
+    };
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VK_ASSERT(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+    VkPipelineLayout pipelineLayout;
+    VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+    VkPipeline pipeline;
+    VK_ASSERT(device->CreateComputePipeline(shaderModule, pipelineLayout, &pipeline));
+
+    VkDescriptorPool descriptorPool;
+    VK_ASSERT(device->CreateDescriptorPool({
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, descriptorCount },
+    }, &descriptorPool));
+
+    VkDescriptorSet descriptorSet;
+    VK_ASSERT(device->AllocateDescriptorSet(descriptorPool, descriptorSetLayout, &descriptorSet));
+
+    device->UpdateStorageBufferDescriptorSets(descriptorSet, { { buffer, 0, VK_WHOLE_SIZE } });
+
+    std::vector<VkDescriptorImageInfo> descriptorImageInfos(descriptorCount,
+        {
+            sampler,                                   // sampler
+            imageView,                                 // imageView
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  // imageLayout
+        });
+    device->UpdateCombinedImageSamplerDescriptorSet(descriptorSet, 1, descriptorImageInfos);
+
+    VkCommandPool commandPool;
+    VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+    VkCommandBuffer commandBuffer;
+    VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+
+    VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+    VkImageMemoryBarrier barrier = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,                       // sType
+        nullptr,                                                      // pNext
+        0,                                                            // srcAccessMask
+        VK_ACCESS_TRANSFER_WRITE_BIT,                                 // dstAccessMask
+        VK_IMAGE_LAYOUT_UNDEFINED,                                    // oldLayout
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,                         // newLayout
+        VK_QUEUE_FAMILY_IGNORED,                                      // srcQueueFamilyIndex
+        VK_QUEUE_FAMILY_IGNORED,                                      // dstQueueFamilyIndex
+        image,                                                        // image
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 },            // subresourceRange
+    };
+    driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    for(uint32_t level = 0; level < mipLevels; level++)
+    {
+        VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+        driver.vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &colors[level], 1, &range);
+    }
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+    driver.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+                                   0, nullptr);
+
+    driver.vkCmdDispatch(commandBuffer, mipLevels, 1, 1);
+
+    VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+
+    VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+    float* results;
+    VK_ASSERT(device->MapMemory(bufferMemory, 0, bufferSize, 0, (void**)&results));
+
+    for(uint32_t level = 0; level < mipLevels; level++)
+    {
+        for(int c = 0; c < 4; c++)
+        {
+            EXPECT_EQ(colors[level].float32[c], results[level * 4 + c]) << "Unexpected output at level " << level << ", component " << c;
+        }
+    }
+
+    device->UnmapMemory(bufferMemory);
+    results = nullptr;
+
+    device->FreeCommandBuffer(commandPool, commandBuffer);
+    device->DestroyCommandPool(commandPool);
+    device->DestroyPipeline(pipeline);
+    device->DestroyPipelineLayout(pipelineLayout);
+    device->DestroyDescriptorPool(descriptorPool);
+    device->DestroyDescriptorSetLayout(descriptorSetLayout);
+    device->DestroyShaderModule(shaderModule);
+    device->DestroyBuffer(buffer);
+    device->FreeMemory(bufferMemory);
+    device->DestroySampler(sampler);
+    device->DestroyImageView(imageView);
+    device->DestroyImage(image);
+    device->FreeMemory(imageMemory);
+    device.reset(nullptr);
+    driver.vkDestroyInstance(instance, nullptr);
+}
+
+// Copies a buffer into an image which is sampled from a copy of its texels in
+// 4x4 tiles, then overwrites a region which is not aligned to the tiles, and
+// fetches every texel. Both copies must update the tiled texels.
+TEST_F(SwiftShaderVulkanTest, TiledImageCopyThenSample)
+{
+    // #version 450
+    // layout(local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+    // layout(binding = 0, std430) buffer OutBuffer
+    // {
+    //     vec4 Data[];
+    // } Out;
+    // layout(binding = 1) uniform sampler2D Texture;
+    // void main()
+    // {
+    //     uint i = gl_GlobalInvocationID.x;
+    //     Out.Data[i] = texelFetch(Texture, ivec2(i % 256, i / 256), 0);
+    // }
+    const char* shader =
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint GLCompute %1 \"main\" %2\n"
+        "OpExecutionMode %1 LocalSize 1 1 1\n"
+        "OpDecorate %2 BuiltIn GlobalInvocationId\n"
+        "OpDecorate %3 ArrayStride 16\n"
+        "OpMemberDecorate %4 0 Offset 0\n"
+        "OpDecorate %4 BufferBlock\n"
+        "OpDecorate %5 DescriptorSet 0\n"
+        "OpDecorate %5 Binding 0\n"
+        "OpDecorate %6 DescriptorSet 0\n"
+        "OpDecorate %6 Binding 1\n"
+        "%7 = OpTypeVoid\n"
+        "%8 = OpTypeFunction %7\n"
+        "%9 = OpTypeInt 32 0\n"                                 // uint
+        "%10 = OpTypeVector %9 3\n"                             // uvec3
+        "%11 = OpTypePointer Input %10\n"
+        "%2 = OpVariable %11 Input\n"                           // gl_GlobalInvocationID
+        "%12 = OpConstant %9 0\n"
+        "%13 = OpTypePointer Input %9\n"
+        "%14 = OpTypeFloat 32\n"                                // float
+        "%15 = OpTypeVector %14 4\n"                            // vec4
+        "%3 = OpTypeRuntimeArray %15\n"
+        "%4 = OpTypeStruct %3\n"                                // struct OutBuffer
+        "%16 = OpTypePointer Uniform %4\n"
+        "%5 = OpVariable %16 Uniform\n"                         // Out
+        "%17 = OpTypeImage %14 2D 0 0 0 1 Unknown\n"
+        "%18 = OpTypeSampledImage %17\n"                        // sampler2D
+        "%19 = OpTypePointer UniformConstant %18\n"
+        "%6 = OpVariable %19 UniformConstant\n"                 // Texture
+        "%20 = OpTypeInt 32 1\n"                                // int
+        "%21 = OpTypeVector %20 2\n"                            // ivec2
+        "%22 = OpConstant %9 256\n"
+        "%23 = OpConstant %20 0\n"
+        "%24 = OpTypePointer Uniform %15\n"
+        "%1 = OpFunction %7 None %8\n"                          // -- Function begin --
+        "%25 = OpLabel\n"
+        "%26 = OpAccessChain %13 %2 %12\n"                      // &gl_GlobalInvocationID.x
+        "%27 = OpLoad %9 %26\n"                                 // i
+        "%28 = OpUMod %9 %27 %22\n"                             // i % 256
+        "%29 = OpUDiv %9 %27 %22\n"                             // i / 256
+        "%30 = OpBitcast %20 %28\n"
+        "%31 = OpBitcast %20 %29\n"
+        "%32 = OpCompositeConstruct %21 %30 %31\n"              // ivec2(i % 256, i / 256)
+        "%33 = OpLoad %18 %6\n"
+        "%34 = OpImage %17 %33\n"
+        "%35 = OpImageFetch %15 %34 %32 Lod %23\n"
+        "%36 = OpAccessChain %24 %5 %23 %27\n"                  // &Out.Data[i]
+        "OpStore %36 %35\n"
+        "OpReturn\n"
+        "OpFunctionEnd\n";                                      // -- Function end --
+
+    auto code = compileSpirv(shader);
+
+    Driver driver;
+    ASSERT_TRUE(driver.loadSwiftShader());
+
+    const VkInstanceCreateInfo createInfo = {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+        nullptr,                                 // pNext
+        0,                                       // flags
+        nullptr,                                 // pApplicationInfo
+        0,                                       // enabledLayerCount
+        nullptr,                                 // ppEnabledLayerNames
+        0,                                       // enabledExtensionCount
+        nullptr,                                 // ppEnabledExtensionNames
+    };
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+    ASSERT_TRUE(driver.resolve(instance));
+
+    std::unique_ptr<Device> device;
+    VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+    ASSERT_TRUE(device->IsValid());
+
+    // Rows of 1024 bytes are long enough for the image to be tiled.
+    static constexpr uint32_t width = 256;
+    static constexpr uint32_t height = 8;
+    static constexpr uint32_t texelCount = width * height;
+    static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+    // The second copy overwrites a region straddling several tiles.
+    static constexpr VkOffset3D regionOffset = { 5, 3, 0 };
+    static constexpr VkExtent3D regionExtent = { 13, 4, 1 };
+
+    auto firstTexel = [](uint32_t x, uint32_t y) -> uint32_t
+    {
+        return x | (y * 31) << 8 | ((x ^ (y * 17)) & 0xFF) << 16 | 0xFF000000;
+    };
+
+    auto secondTexel = [](uint32_t x, uint32_t y) -> uint32_t
+    {
+        return (255 - x) | (255 - y) << 8 | 0x5A << 16;
+    };
+
+    auto inRegion = [](uint32_t x, uint32_t y)
+    {
+        return (x >= uint32_t(regionOffset.x)) && (x < regionOffset.x + regionExtent.width) &&
+               (y >= uint32_t(regionOffset.y)) && (y < regionOffset.y + regionExtent.height);
+    };
+
+    VkImage image;
+    VK_ASSERT(device->CreateSampledImage(format, width, height, 1, &image));
+
+    VkMemoryRequirements memoryRequirements;
+    device->GetImageMemoryRequirements(image, &memoryRequirements);
+
+    VkDeviceMemory imageMemory;
+    VK_ASSERT(device->AllocateMemory(memoryRequirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+    VK_ASSERT(device->BindImageMemory(image, imageMemory, 0));
+
+    VkImageView imageView;
+    VK_ASSERT(device->CreateImageView(image, format, &imageView));
+
+    VkSampler sampler;
+    VK_ASSERT(device->CreateSampler(&sampler));
+
+    // The texels of the first copy, followed by those of the second.
+    size_t regionTexelCount = regionExtent.width * regionExtent.height;
+    size_t stagingSize = sizeof(uint32_t) * (texelCount + regionTexelCount);
+
+    VkDeviceMemory stagingMemory;
+    VK_ASSERT(device->AllocateMemory(stagingSize,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &stagingMemory));
+
+    VkBuffer stagingBuffer;
+    VK_ASSERT(device->CreateTransferSrcBuffer(stagingMemory, stagingSize, 0, &stagingBuffer));
+
+    uint32_t* texels;
+    VK_ASSERT(device->MapMemory(stagingMemory, 0, stagingSize, 0, (void**)&texels));
+
+    for(uint32_t y = 0; y < height; y++)
+    {
+        for(uint32_t x = 0; x < width; x++)
+        {
+            texels[y * width + x] = firstTexel(x, y);
+        }
+    }
+
+    for(uint32_t y = 0; y < regionExtent.height; y++)
+    {
+        for(uint32_t x = 0; x < regionExtent.width; x++)
+        {
+            texels[texelCount + y * regionExtent.width + x] = secondTexel(regionOffset.x + x, regionOffset.y + y);
+        }
+    }
+
+    device->UnmapMemory(stagingMemory);
+    texels = nullptr;
+
+    size_t bufferSize = sizeof(float) * 4 * texelCount;
+
+    VkDeviceMemory bufferMemory;
+    VK_ASSERT(device->AllocateMemory(bufferSize,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &bufferMemory));
+
+    VkBuffer buffer;
+    VK_ASSERT(device->CreateStorageBuffer(bufferMemory, bufferSize, 0, &buffer));
+
+    VkShaderModule shaderModule;
+    VK_ASSERT(device->CreateShaderModule(code, &shaderModule));
+
+    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings =
+    {
+        {
+            0,                                          // binding
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,          // descriptorType
+            1,                                          // descriptorCount
+            VK_SHADER_STAGE_COMPUTE_BIT,                // stageFlags
+            0,                                          // pImmutableSamplers
+        },
+        {
+            1,                                          // binding
+            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // descriptorType
+            1,                                          // descriptorCount
+            VK_SHADER_STAGE_COMPUTE_BIT,                // stageFlags
+            0,                                          // pImmutableSamplers
+        },
+    };
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VK_ASSERT(device->CreateDescriptorSetLayout(descriptorSetLayoutBindings, &descriptorSetLayout));
+
+    VkPipelineLayout pipelineLayout;
+    VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+    VkPipeline pipeline;
+    VK_ASSERT(device->CreateComputePipeline(shaderModule, pipelineLayout, &pipeline));
+
+    VkDescriptorPool descriptorPool;
+    VK_ASSERT(device->CreateDescriptorPool({
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+    }, &descriptorPool));
+
+    VkDescriptorSet descriptorSet;
+    VK_ASSERT(device->AllocateDescriptorSet(descriptorPool, descriptorSetLayout, &descriptorSet));
+
+    device->UpdateStorageBufferDescriptorSets(descriptorSet, { { buffer, 0, VK_WHOLE_SIZE } });
+    device->UpdateCombinedImageSamplerDescriptorSet(descriptorSet, 1,
+        {
+            {
+                sampler,                                   // sampler
+                imageView,                                 // imageView
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,  // imageLayout
+            },
+        });
+
+    VkCommandPool commandPool;
+    VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+    VkCommandBuffer commandBuffer;
+    VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+
+    VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+    VkImageMemoryBarrier barrier = {
+        VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,                       // sType
+        nullptr,                                                      // pNext
+        0,                                                            // srcAccessMask
+        VK_ACCESS_TRANSFER_WRITE_BIT,                                 // dstAccessMask
+        VK_IMAGE_LAYOUT_UNDEFINED,                                    // oldLayout
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,                         // newLayout
+        VK_QUEUE_FAMILY_IGNORED,                                      // srcQueueFamilyIndex
+        VK_QUEUE_FAMILY_IGNORED,                                      // dstQueueFamilyIndex
+        image,                                                        // image
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },                    // subresourceRange
+    };
+    driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    const VkBufferImageCopy regions[] =
+    {
+        {
+            0,                                         // bufferOffset
+            0,                                         // bufferRowLength
+            0,                                         // bufferImageHeight
+            { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },    // imageSubresource
+            { 0, 0, 0 },                               // imageOffset
+            { width, height, 1 },                      // imageExtent
+        },
+        {
+            sizeof(uint32_t) * texelCount,             // bufferOffset
+            0,                                         // bufferRowLength
+            0,                                         // bufferImageHeight
+            { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },    // imageSubresource
+            regionOffset,                              // imageOffset
+            regionExtent,                              // imageExtent
+        },
+    };
+
+    for(const auto &region : regions)
+    {
+        driver.vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    driver.vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+    driver.vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+                                   0, nullptr);
+
+    driver.vkCmdDispatch(commandBuffer, texelCount, 1, 1);
+
+    VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+
+    VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+    float* results;
+    VK_ASSERT(device->MapMemory(bufferMemory, 0, bufferSize, 0, (void**)&results));
+
+    for(uint32_t y = 0; y < height; y++)
+    {
+        for(uint32_t x = 0; x < width; x++)
+        {
+            uint32_t texel = inRegion(x, y) ? secondTexel(x, y) : firstTexel(x, y);
+
+            for(int c = 0; c < 4; c++)
+            {
+                uint32_t expected = (texel >> (c * 8)) & 0xFF;
+                uint32_t result = static_cast<uint32_t>(results[(y * width + x) * 4 + c] * 255.0f + 0.5f);
+                EXPECT_EQ(expected, result) << "Unexpected output at texel (" << x << ", " << y << "), component " << c;
+            }
+        }
+    }
+
+    device->UnmapMemory(bufferMemory);
+    results = nullptr;
+
+    device->FreeCommandBuffer(commandPool, commandBuffer);
+    device->DestroyCommandPool(commandPool);
+    device->DestroyPipeline(pipeline);
+    device->DestroyPipelineLayout(pipelineLayout);
+    device->DestroyDescriptorPool(descriptorPool);
+    device->DestroyDescriptorSetLayout(descriptorSetLayout);
+    device->DestroyShaderModule(shaderModule);
+    device->DestroyBuffer(buffer);
+    device->FreeMemory(bufferMemory);
+    device->DestroyBuffer(stagingBuffer);
+    device->FreeMemory(stagingMemory);
+    device->DestroySampler(sampler);
+    device->DestroyImageView(imageView);
+    device->DestroyImage(image);
+    device->FreeMemory(imageMemory);
+    device.reset(nullptr);
+    driver.vkDestroyInstance(instance, nullptr);
+}
+
+TEST_F(SwiftShaderVulkanTest, IndexedDrawShadesUniqueVerticesOnce)
+{
+    // #version 450
+    // layout(location = 0) out vec2 color;
+    // void main()
+    // {
+    //     color = vec2(gl_VertexIndex % 5, gl_VertexIndex / 5) * 0.25;
+    //     gl_Position = vec4(color * 2.0 - 1.0, 0.0, 1.0);
+    // }
+    const char* vertexShader =
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint Vertex %1 \"main\" %2 %3 %4\n"
+        "OpDecorate %2 BuiltIn VertexIndex\n"
+        "OpDecorate %3 Location 0\n"
+        "OpDecorate %4 BuiltIn Position\n"
+        "%5 = OpTypeVoid\n"
+        "%6 = OpTypeFunction %5\n"
+        "%7 = OpTypeInt 32 1\n"                                 // int
+        "%8 = OpTypePointer Input %7\n"
+        "%2 = OpVariable %8 Input\n"                            // gl_VertexIndex
+        "%9 = OpTypeFloat 32\n"                                 // float
+        "%10 = OpTypeVector %9 2\n"                             // vec2
+        "%11 = OpTypePointer Output %10\n"
+        "%3 = OpVariable %11 Output\n"                          // color
+        "%12 = OpTypeVector %9 4\n"                             // vec4
+        "%13 = OpTypePointer Output %12\n"
+        "%4 = OpVariable %13 Output\n"                          // gl_Position
+        "%14 = OpConstant %7 5\n"
+        "%15 = OpConstant %9 0.25\n"
+        "%16 = OpConstant %9 2\n"
+        "%17 = OpConstant %9 -1\n"
+        "%18 = OpConstant %9 0\n"
+        "%19 = OpConstant %9 1\n"
+        "%1 = OpFunction %5 None %6\n"                          // -- Function begin --
+        "%20 = OpLabel\n"
+        "%21 = OpLoad %7 %2\n"                                  // gl_VertexIndex
+        "%22 = OpSMod %7 %21 %14\n"                             // column
+        "%23 = OpSDiv %7 %21 %14\n"                             // row
+        "%24 = OpConvertSToF %9 %22\n"
+        "%25 = OpConvertSToF %9 %23\n"
+        "%26 = OpCompositeConstruct %10 %24 %25\n"
+        "%27 = OpVectorTimesScalar %10 %26 %15\n"               // color
+        "OpStore %3 %27\n"
+        "%28 = OpCompositeExtract %9 %27 0\n"
+        "%29 = OpCompositeExtract %9 %27 1\n"
+        "%30 = OpFMul %9 %28 %16\n"
+        "%31 = OpFAdd %9 %30 %17\n"
+        "%32 = OpFMul %9 %29 %16\n"
+        "%33 = OpFAdd %9 %32 %17\n"
+        "%34 = OpCompositeConstruct %12 %31 %33 %18 %19\n"
+        "OpStore %4 %34\n"
+        "OpReturn\n"
+        "OpFunctionEnd\n";                                      // -- Function end --
+
+    // #version 450
+    // layout(location = 0) in vec2 color;
+    // layout(location = 0) out vec4 fragColor;
+    // void main()
+    // {
+    //     fragColor = vec4(color, 0.0, 1.0);
+    // }
+    const char* fragmentShader =
+        "OpCapability Shader\n"
+        "OpMemoryModel Logical GLSL450\n"
+        "OpEntryPoint Fragment %1 \"main\" %2 %3\n"
+        "OpExecutionMode %1 OriginUpperLeft\n"
+        "OpDecorate %2 Location 0\n"
+        "OpDecorate %3 Location 0\n"
+        "%4 = OpTypeVoid\n"
+        "%5 = OpTypeFunction %4\n"
+        "%6 = OpTypeFloat 32\n"                                 // float
+        "%7 = OpTypeVector %6 2\n"                              // vec2
+        "%8 = OpTypePointer Input %7\n"
+        "%2 = OpVariable %8 Input\n"                            // color
+        "%9 = OpTypeVector %6 4\n"                              // vec4
+        "%10 = OpTypePointer Output %9\n"
+        "%3 = OpVariable %10 Output\n"                          // fragColor
+        "%11 = OpConstant %6 0\n"
+        "%12 = OpConstant %6 1\n"
+        "%1 = OpFunction %4 None %5\n"                          // -- Function begin --
+        "%13 = OpLabel\n"
+        "%14 = OpLoad %7 %2\n"
+        "%15 = OpCompositeExtract %6 %14 0\n"
+        "%16 = OpCompositeExtract %6 %14 1\n"
+        "%17 = OpCompositeConstruct %9 %15 %16 %11 %12\n"
+        "OpStore %3 %17\n"
+        "OpReturn\n"
+        "OpFunctionEnd\n";                                      // -- Function end --
+
+    auto vertexCode = compileSpirv(vertexShader);
+    auto fragmentCode = compileSpirv(fragmentShader);
+
+    Driver driver;
+    ASSERT_TRUE(driver.loadSwiftShader());
+
+    const VkInstanceCreateInfo createInfo = {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+        nullptr,                                 // pNext
+        0,                                       // flags
+        nullptr,                                 // pApplicationInfo
+        0,                                       // enabledLayerCount
+        nullptr,                                 // ppEnabledLayerNames
+        0,                                       // enabledExtensionCount
+        nullptr,                                 // ppEnabledExtensionNames
+    };
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+    ASSERT_TRUE(driver.resolve(instance));
+
+    std::unique_ptr<Device> device;
+    VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+    ASSERT_TRUE(device->IsValid());
+
+    static constexpr uint32_t width = 64;
+    static constexpr uint32_t height = 64;
+    static constexpr VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+    // A grid of 4 x 4 quads covering the whole image. Each of its 25 vertices
+    // is referenced by up to 6 of the 32 triangles, which fit in one batch.
+    static constexpr uint32_t gridSize = 4;
+    static constexpr uint32_t vertexCount = (gridSize + 1) * (gridSize + 1);
+
+    std::vector<uint32_t> indices;
+    for(uint32_t row = 0; row < gridSize; row++)
+    {
+        for(uint32_t column = 0; column < gridSize; column++)
+        {
+            uint32_t v0 = row * (gridSize + 1) + column;
+            uint32_t v1 = v0 + 1;
+            uint32_t v2 = v0 + (gridSize + 1);
+            uint32_t v3 = v2 + 1;
+
+            indices.insert(indices.end(), { v0, v1, v2, v2, v1, v3 });
+        }
+    }
+
+    VkImage image;
+    VK_ASSERT(device->CreateColorAttachmentImage(format, width, height, &image));
+
+    VkMemoryRequirements memoryRequirements;
+    device->GetImageMemoryRequirements(image, &memoryRequirements);
+
+    VkDeviceMemory imageMemory;
+    VK_ASSERT(device->AllocateMemory(memoryRequirements.size, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &imageMemory));
+    VK_ASSERT(device->BindImageMemory(image, imageMemory, 0));
+
+    VkImageView imageView;
+    VK_ASSERT(device->CreateImageView(image, format, &imageView));
+
+    size_t indexBufferSize = sizeof(uint32_t) * indices.size();
+
+    VkDeviceMemory indexMemory;
+    VK_ASSERT(device->AllocateMemory(indexBufferSize,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &indexMemory));
+
+    VkBuffer indexBuffer;
+    VK_ASSERT(device->CreateBuffer(indexMemory, indexBufferSize, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &indexBuffer));
+
+    void* mappedIndices;
+    VK_ASSERT(device->MapMemory(indexMemory, 0, indexBufferSize, 0, &mappedIndices));
+    memcpy(mappedIndices, indices.data(), indexBufferSize);
+    device->UnmapMemory(indexMemory);
+    mappedIndices = nullptr;
+
+    size_t bufferSize = sizeof(uint32_t) * width * height;
+
+    VkDeviceMemory bufferMemory;
+    VK_ASSERT(device->AllocateMemory(bufferSize,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            &bufferMemory));
+
+    VkBuffer buffer;
+    VK_ASSERT(device->CreateBuffer(bufferMemory, bufferSize, 0, VK_BUFFER_USAGE_TRANSFER_DST_BIT, &buffer));
+
+    VkShaderModule vertexModule;
+    VK_ASSERT(device->CreateShaderModule(vertexCode, &vertexModule));
+
+    VkShaderModule fragmentModule;
+    VK_ASSERT(device->CreateShaderModule(fragmentCode, &fragmentModule));
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VK_ASSERT(device->CreateDescriptorSetLayout({}, &descriptorSetLayout));
+
+    VkPipelineLayout pipelineLayout;
+    VK_ASSERT(device->CreatePipelineLayout(descriptorSetLayout, &pipelineLayout));
+
+    VkRenderPass renderPass;
+    VK_ASSERT(device->CreateRenderPass(format, &renderPass));
+
+    VkFramebuffer framebuffer;
+    VK_ASSERT(device->CreateFramebuffer(renderPass, imageView, width, height, &framebuffer));
+
+    VkPipeline pipeline;
+    VK_ASSERT(device->CreateGraphicsPipeline(vertexModule, fragmentModule, pipelineLayout, renderPass,
+                                             width, height, &pipeline));
+
+    VkQueryPool queryPool;
+    VK_ASSERT(device->CreatePipelineStatisticsQueryPool(
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT,
+            &queryPool));
+
+    VkCommandPool commandPool;
+    VK_ASSERT(device->CreateCommandPool(&commandPool));
+
+    VkCommandBuffer commandBuffer;
+    VK_ASSERT(device->AllocateCommandBuffer(commandPool, &commandBuffer));
+
+    VK_ASSERT(device->BeginCommandBuffer(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, commandBuffer));
+
+    driver.vkCmdResetQueryPool(commandBuffer, queryPool, 0, 1);
+
+    // Pixels left uncovered by the grid keep the blue clear color.
+    VkClearValue clearValue = {};
+    clearValue.color.float32[2] = 1.0f;
+    clearValue.color.float32[3] = 1.0f;
+
+    const VkRenderPassBeginInfo renderPassBeginInfo = {
+        VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,  // sType
+        nullptr,                                   // pNext
+        renderPass,                                // renderPass
+        framebuffer,                               // framebuffer
+        { { 0, 0 }, { width, height } },           // renderArea
+        1,                                         // clearValueCount
+        &clearValue,                               // pClearValues
+    };
+    driver.vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    driver.vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    driver.vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+    driver.vkCmdBeginQuery(commandBuffer, queryPool, 0, 0);
+    driver.vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+    driver.vkCmdEndQuery(commandBuffer, queryPool, 0);
+
+    driver.vkCmdEndRenderPass(commandBuffer);
+
+    const VkBufferImageCopy region = {
+        0,                                         // bufferOffset
+        0,                                         // bufferRowLength
+        0,                                         // bufferImageHeight
+        { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },    // imageSubresource
+        { 0, 0, 0 },                               // imageOffset
+        { width, height, 1 },                      // imageExtent
+    };
+    driver.vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+
+    VK_ASSERT(driver.vkEndCommandBuffer(commandBuffer));
+
+    VK_ASSERT(device->QueueSubmitAndWait(commandBuffer));
+
+    // The statistics are written in the order of their bits.
+    uint64_t statistics[2] = {};
+    VK_ASSERT(device->GetQueryPoolResults(queryPool, sizeof(statistics), statistics, sizeof(statistics),
+                                          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+    EXPECT_EQ(statistics[0], indices.size());  // Input assembly vertices
+    EXPECT_EQ(statistics[1], vertexCount);     // Vertex shader invocations
+
+    uint32_t* pixels;
+    VK_ASSERT(device->MapMemory(bufferMemory, 0, bufferSize, 0, (void**)&pixels));
+
+    for(uint32_t y = 0; y < height; y++)
+    {
+        for(uint32_t x = 0; x < width; x++)
+        {
+            // The color varies linearly over the grid, from 0 at its top left
+            // corner to 1 at its bottom right one.
+            float expected[4] =
+            {
+                (x + 0.5f) / width,
+                (y + 0.5f) / height,
+                0.0f,
+                1.0f,
+            };
+
+            uint32_t pixel = pixels[y * width + x];
+
+            for(int c = 0; c < 4; c++)
+            {
+                int result = (pixel >> (c * 8)) & 0xFF;
+                EXPECT_NEAR(expected[c] * 255.0f, result, 1.0f) << "Unexpected output at pixel (" << x << ", " << y << "), component " << c;
+            }
+        }
+    }
+
+    device->UnmapMemory(bufferMemory);
+    pixels = nullptr;
+
+    device->FreeCommandBuffer(commandPool, commandBuffer);
+    device->DestroyCommandPool(commandPool);
+    device->DestroyQueryPool(queryPool);
+    device->DestroyPipeline(pipeline);
+    device->DestroyFramebuffer(framebuffer);
+    device->DestroyRenderPass(renderPass);
+    device->DestroyPipelineLayout(pipelineLayout);
+    device->DestroyDescriptorSetLayout(descriptorSetLayout);
+    device->DestroyShaderModule(fragmentModule);
+    device->DestroyShaderModule(vertexModule);
+    device->DestroyBuffer(buffer);
+    device->FreeMemory(bufferMemory);
+    device->DestroyBuffer(indexBuffer);
+    device->FreeMemory(indexMemory);
+    device->DestroyImageView(imageView);
+    device->DestroyImage(image);
+    device->FreeMemory(imageMemory);
+    device.reset(nullptr);
+    driver.vkDestroyInstance(instance, nullptr);
+}
+
+#if defined(__linux__)
+TEST_F(SwiftShaderVulkanTest, ExportedMemoryImportsAsSameMemory)
+{
+    Driver driver;
+    ASSERT_TRUE(driver.loadSwiftShader());
+
+    const VkInstanceCreateInfo createInfo = {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+        nullptr,                                 // pNext
+        0,                                       // flags
+        nullptr,                                 // pApplicationInfo
+        0,                                       // enabledLayerCount
+        nullptr,                                 // ppEnabledLayerNames
+        0,                                       // enabledExtensionCount
+        nullptr,                                 // ppEnabledExtensionNames
+    };
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+    ASSERT_TRUE(driver.resolve(instance));
+
+    std::unique_ptr<Device> device;
+    VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+    ASSERT_TRUE(device->IsValid());
+
+    static constexpr size_t size = 64 * 1024;
+    static constexpr size_t count = size / sizeof(uint32_t);
+    static constexpr VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    const VkExportMemoryAllocateInfo exportInfo = {
+        VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,  // sType
+        nullptr,                                        // pNext
+        VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,   // handleTypes
+    };
+
+    VkDeviceMemory exportedMemory;
+    VK_ASSERT(device->AllocateMemory(size, flags, &exportInfo, &exportedMemory));
+
+    uint32_t* exported;
+    VK_ASSERT(device->MapMemory(exportedMemory, 0, size, 0, (void**)&exported));
+
+    for(size_t i = 0; i < count; i++)
+    {
+        exported[i] = static_cast<uint32_t>(i * 0x9E3779B1u);
+    }
+
+    int fd = -1;
+    VK_ASSERT(device->GetMemoryFd(exportedMemory, &fd));
+    ASSERT_GE(fd, 0);
+
+    // The implementation owns the file descriptor once the import succeeds.
+    const VkImportMemoryFdInfoKHR importInfo = {
+        VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,    // sType
+        nullptr,                                        // pNext
+        VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,   // handleType
+        fd,                                             // fd
+    };
+
+    VkDeviceMemory importedMemory;
+    VK_ASSERT(device->AllocateMemory(size, flags, &importInfo, &importedMemory));
+
+    uint32_t* imported;
+    VK_ASSERT(device->MapMemory(importedMemory, 0, size, 0, (void**)&imported));
+
+    // Both allocations are mappings of the same memory, so the contents
+    // written through either are read through the other.
+    for(size_t i = 0; i < count; i++)
+    {
+        ASSERT_EQ(imported[i], static_cast<uint32_t>(i * 0x9E3779B1u)) << "Unexpected imported value at index " << i;
+        imported[i] = ~imported[i];
+    }
+
+    for(size_t i = 0; i < count; i++)
+    {
+        ASSERT_EQ(exported[i], ~static_cast<uint32_t>(i * 0x9E3779B1u)) << "Unexpected exported value at index " << i;
+    }
+
+    device->UnmapMemory(importedMemory);
+    imported = nullptr;
+    device->UnmapMemory(exportedMemory);
+    exported = nullptr;
+
+    device->FreeMemory(importedMemory);
+    device->FreeMemory(exportedMemory);
+    device.reset(nullptr);
+    driver.vkDestroyInstance(instance, nullptr);
+}
+
+TEST_F(SwiftShaderVulkanTest, FailedMemoryImportLeavesFdOpen)
+{
+    Driver driver;
+    ASSERT_TRUE(driver.loadSwiftShader());
+
+    const VkInstanceCreateInfo createInfo = {
+        VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,  // sType
+        nullptr,                                 // pNext
+        0,                                       // flags
+        nullptr,                                 // pApplicationInfo
+        0,                                       // enabledLayerCount
+        nullptr,                                 // ppEnabledLayerNames
+        0,                                       // enabledExtensionCount
+        nullptr,                                 // ppEnabledExtensionNames
+    };
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VK_ASSERT(driver.vkCreateInstance(&createInfo, nullptr, &instance));
+
+    ASSERT_TRUE(driver.resolve(instance));
+
+    std::unique_ptr<Device> device;
+    VK_ASSERT(Device::CreateComputeDevice(&driver, instance, device));
+    ASSERT_TRUE(device->IsValid());
+
+    static constexpr size_t size = 4 * 1024;
+    static constexpr VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    const VkExportMemoryAllocateInfo exportInfo = {
+        VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,  // sType
+        nullptr,                                        // pNext
+        VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,   // handleTypes
+    };
+
+    VkDeviceMemory exportedMemory;
+    VK_ASSERT(device->AllocateMemory(size, flags, &exportInfo, &exportedMemory));
+
+    int fd = -1;
+    VK_ASSERT(device->GetMemoryFd(exportedMemory, &fd));
+    ASSERT_GE(fd, 0);
+
+    const VkImportMemoryFdInfoKHR importInfo = {
+        VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,    // sType
+        nullptr,                                        // pNext
+        VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT,   // handleType
+        fd,                                             // fd
+    };
+
+    // The file is smaller than the allocation, so it can't be imported.
+    VkDeviceMemory importedMemory = VK_NULL_HANDLE;
+    EXPECT_EQ(device->AllocateMemory(2 * size, flags, &importInfo, &importedMemory), VK_ERROR_INVALID_EXTERNAL_HANDLE);
+
+    // The application still owns the file descriptor, which remains usable.
+    EXPECT_NE(fcntl(fd, F_GETFD), -1);
+
+    VK_ASSERT(device->AllocateMemory(size, flags, &importInfo, &importedMemory));
+
+    device->FreeMemory(importedMemory);
+    device->FreeMemory(exportedMemory);
+    device.reset(nullptr);
+    driver.vkDestroyInstance(instance, nullptr);
+}
+#endif
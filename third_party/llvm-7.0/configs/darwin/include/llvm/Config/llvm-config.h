@@ -28,7 +28,9 @@
 #endif
 
 /* Define if threads enabled */
+#ifndef LLVM_ENABLE_THREADS
 #define LLVM_ENABLE_THREADS 0
+#endif
 
 /* Has gcc/MSVC atomic intrinsics */
 #define LLVM_HAS_ATOMICS 1